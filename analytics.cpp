@@ -0,0 +1,433 @@
+/* Program name: analytics.cpp
+* Purpose: Implements the sales analytics mirror declared in analytics.h. The kernels work on plain arrays without branches in their loops: the date filter
+*  writes a 0/1 mask, and a grouped sum masks each value with -mask instead of testing it. This file is built with -O3 (makefile), which gcc needs to
+*  vectorize them; add -march=native to OPTFLAGS for the widest vectors the machine has.
+*/
+
+#include "analytics.h"
+#include "pokemart_internal.h"
+#include "rowmap.h"
+#include "timestamp.h"
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+//Up to this many groups, a grouped sum makes one vectorized pass per group instead of scattering each row into its group's total
+const int VECTOR_GROUPS = 8;
+
+static double secondsSince(std::chrono::steady_clock::time_point start){
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+//Money is kept in thousandths of a dollar, the scale of the NUMERIC(9,3) columns
+static sqlite3_int64 toThousandths(double amount){
+	return std::llround(amount * 1000);
+}
+
+static double fromThousandths(sqlite3_int64 amount){
+	return amount / 1000.0;
+}
+
+//mask[i] is 1 for the rows dated from <= epoch[i] < to, otherwise 0
+static void dateMask(const std::vector<sqlite3_int64> &epochs, sqlite3_int64 from, sqlite3_int64 to, std::vector<unsigned char> &mask){
+	size_t rows = epochs.size();
+	mask.resize(rows);
+	const sqlite3_int64 *epoch = epochs.data();
+	unsigned char *selected = mask.data();
+	for(size_t i = 0; i < rows; i++){
+		selected[i] = (epoch[i] >= from) & (epoch[i] < to);
+	}
+}
+
+//Adds up value and counts the rows in mask for each group code in group, into sums and counts (both sized to the number of groups)
+template<typename T>
+static void groupSum(const int *group, const T *value, const unsigned char *mask, size_t rows, std::vector<sqlite3_int64> &sums,
+	std::vector<sqlite3_int64> &counts){
+	int groups = sums.size();
+	if(groups <= VECTOR_GROUPS){
+		for(int g = 0; g < groups; g++){
+			sqlite3_int64 sum = 0, count = 0;
+			for(size_t i = 0; i < rows; i++){
+				sqlite3_int64 take = mask[i] & (group[i] == g);
+				sum += static_cast<sqlite3_int64>(value[i]) & -take;
+				count += take;
+			}
+			sums[g] = sum;
+			counts[g] = count;
+		}
+		return;
+	}
+	sqlite3_int64 *sum = sums.data(), *count = counts.data();
+	for(size_t i = 0; i < rows; i++){
+		sqlite3_int64 take = mask[i];
+		sum[group[i]] += static_cast<sqlite3_int64>(value[i]) & -take;
+		count[group[i]] += take;
+	}
+}
+
+//Adds up value over the rows in mask
+template<typename T>
+static sqlite3_int64 maskedSum(const std::vector<T> &values, const std::vector<unsigned char> &mask){
+	const T *value = values.data();
+	const unsigned char *selected = mask.data();
+	sqlite3_int64 sum = 0;
+	for(size_t i = 0; i < values.size(); i++){
+		sum += static_cast<sqlite3_int64>(value[i]) & -static_cast<sqlite3_int64>(selected[i]);
+	}
+	return sum;
+}
+
+static sqlite3_int64 maskCount(const std::vector<unsigned char> &mask){
+	sqlite3_int64 count = 0;
+	for(unsigned char selected : mask){count += selected;}
+	return count;
+}
+
+//Gives value a code in dictionary, adding it if it is new
+static int encode(std::string_view value, std::unordered_map<std::string, int> &codes, std::vector<std::string> &dictionary){
+	auto found = codes.try_emplace(std::string(value), static_cast<int>(dictionary.size()));
+	if(found.second){dictionary.emplace_back(value);}
+	return found.first->second;
+}
+
+OpResult SalesColumns::load(sqlite3 *db){
+	OpResult result;
+	*this = SalesColumns();
+	sqlite3_stmt *res;
+
+	//PokeMarts, with their regions encoded
+	std::vector<int> martCodes, martRegion; //mart_id -> code (-1 for none), code -> region code
+	std::unordered_map<std::string, int> regionCodes;
+	int rc = sqlite3_prepare_v2(db, "SELECT mart_id, region FROM pokemart ORDER BY mart_id", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting PokeMarts for analytics");
+		return result;
+	}
+	rc = forEachRow<int, std::string_view>(res, [&](int martID, std::string_view region){
+		if(martID < 0){return;}
+		if(martID >= static_cast<int>(martCodes.size())){martCodes.resize(martID + 1, -1);}
+		martCodes[martID] = marts.size();
+		marts.push_back(martID);
+		martRegion.push_back(encode(region, regionCodes, regions));
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading PokeMarts for analytics");
+		return result;
+	}
+	sqlite3_finalize(res);
+
+	//Invoices. invoice_date is local time text; it is converted once here so the filters compare integers
+	std::vector<int> invoiceRows; //invoice_num -> row (-1 for none)
+	rc = sqlite3_prepare_v2(db, "SELECT invoice_num, mart_id, invoice_date, tax FROM invoice ORDER BY invoice_num", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting invoices for analytics");
+		return result;
+	}
+	std::string date;
+	rc = forEachRow<int, int, std::string_view, double>(res, [&](int invoiceNum, int martID, std::string_view invoiceDate, double tax){
+		if(invoiceNum < 0 || martID < 0 || martID >= static_cast<int>(martCodes.size()) || martCodes[martID] < 0){return;}
+		sqlite3_int64 epoch;
+		date.assign(invoiceDate);
+		if(!parseTimestamp(date, epoch)){epoch = std::numeric_limits<sqlite3_int64>::min();} //Only an open start date includes it
+		if(invoiceNum >= static_cast<int>(invoiceRows.size())){invoiceRows.resize(invoiceNum + 1, -1);}
+		invoiceRows[invoiceNum] = invoiceEpoch.size();
+		invoiceEpoch.push_back(epoch);
+		invoiceTax.push_back(toThousandths(tax));
+		invoiceMart.push_back(martCodes[martID]);
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading invoices for analytics");
+		return result;
+	}
+	sqlite3_finalize(res);
+
+	//Lines, each given its invoice's date and region so no question has to look the invoice up
+	std::unordered_map<std::string, int> productCodes;
+	rc = sqlite3_prepare_v2(db, "SELECT invoice_num, prod_code, qty, line_total FROM line", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting lines for analytics");
+		return result;
+	}
+	rc = forEachRow<int, std::string_view, int, double>(res, [&](int invoiceNum, std::string_view prodCode, int qty, double lineTotalAmount){
+		if(invoiceNum < 0 || invoiceNum >= static_cast<int>(invoiceRows.size()) || invoiceRows[invoiceNum] < 0){return;}
+		int row = invoiceRows[invoiceNum];
+		lineEpoch.push_back(invoiceEpoch[row]);
+		lineRegion.push_back(martRegion[invoiceMart[row]]);
+		lineProduct.push_back(encode(prodCode, productCodes, products));
+		lineQty.push_back(qty);
+		lineTotal.push_back(toThousandths(lineTotalAmount));
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading lines for analytics");
+		return result;
+	}
+	sqlite3_finalize(res);
+	return result;
+}
+
+void SalesColumns::revenueByRegion(sqlite3_int64 from, sqlite3_int64 to, std::vector<RegionRevenue> &revenue) const{
+	std::vector<unsigned char> mask;
+	dateMask(lineEpoch, from, to, mask);
+	std::vector<sqlite3_int64> sums(regions.size()), counts(regions.size());
+	groupSum(lineRegion.data(), lineTotal.data(), mask.data(), mask.size(), sums, counts);
+	revenue.clear();
+	for(size_t g = 0; g < regions.size(); g++){
+		if(counts[g] > 0){revenue.push_back({regions[g], counts[g], fromThousandths(sums[g])});}
+	}
+}
+
+void SalesColumns::salesByProduct(sqlite3_int64 from, sqlite3_int64 to, std::vector<ProductSales> &sales) const{
+	std::vector<unsigned char> mask;
+	dateMask(lineEpoch, from, to, mask);
+	std::vector<sqlite3_int64> revenue(products.size()), units(products.size()), counts(products.size());
+	groupSum(lineProduct.data(), lineTotal.data(), mask.data(), mask.size(), revenue, counts);
+	groupSum(lineProduct.data(), lineQty.data(), mask.data(), mask.size(), units, counts);
+	sales.clear();
+	for(size_t g = 0; g < products.size(); g++){
+		if(counts[g] > 0){sales.push_back({products[g], units[g], fromThousandths(revenue[g])});}
+	}
+}
+
+void SalesColumns::taxByMart(sqlite3_int64 from, sqlite3_int64 to, std::vector<MartTax> &tax) const{
+	std::vector<unsigned char> mask;
+	dateMask(invoiceEpoch, from, to, mask);
+	std::vector<sqlite3_int64> sums(marts.size()), counts(marts.size());
+	groupSum(invoiceMart.data(), invoiceTax.data(), mask.data(), mask.size(), sums, counts);
+	tax.clear();
+	for(size_t g = 0; g < marts.size(); g++){
+		if(counts[g] > 0){tax.push_back({marts[g], counts[g], fromThousandths(sums[g])});}
+	}
+}
+
+BasketSize SalesColumns::basketSize(sqlite3_int64 from, sqlite3_int64 to) const{
+	BasketSize basket;
+	std::vector<unsigned char> mask;
+	dateMask(invoiceEpoch, from, to, mask);
+	basket.invoices = maskCount(mask);
+	dateMask(lineEpoch, from, to, mask);
+	basket.lines = maskCount(mask);
+	basket.units = maskedSum(lineQty, mask);
+	return basket;
+}
+
+//The same questions in SQL. ?1 and ?2 are the request's dates as text, which compares like the dates themselves
+const char *const REGION_REVENUE_SQL = "SELECT m.region, COUNT(*), SUM(l.line_total) FROM line l JOIN invoice i ON i.invoice_num = l.invoice_num "
+	"JOIN pokemart m ON m.mart_id = i.mart_id WHERE i.invoice_date >= ?1 AND i.invoice_date < ?2 GROUP BY m.region";
+const char *const PRODUCT_SALES_SQL = "SELECT l.prod_code, SUM(l.qty), SUM(l.line_total) FROM line l JOIN invoice i ON i.invoice_num = l.invoice_num "
+	"WHERE i.invoice_date >= ?1 AND i.invoice_date < ?2 GROUP BY l.prod_code";
+const char *const MART_TAX_SQL = "SELECT mart_id, COUNT(*), SUM(tax) FROM invoice WHERE invoice_date >= ?1 AND invoice_date < ?2 GROUP BY mart_id";
+const char *const BASKET_SIZE_SQL = "SELECT (SELECT COUNT(*) FROM invoice WHERE invoice_date >= ?1 AND invoice_date < ?2), COUNT(*), SUM(l.qty) "
+	"FROM line l JOIN invoice i ON i.invoice_num = l.invoice_num WHERE i.invoice_date >= ?1 AND i.invoice_date < ?2";
+
+//Runs one of the queries above, passing each row to rowFunction, and adds its time to timing. Returns false with the failure recorded on result
+template<typename... Columns, typename RowFunction>
+static bool timeQuery(sqlite3 *db, const char *sql, const AnalyticsRequest &request, RowFunction rowFunction, AnalyticsTiming &timing,
+	AnalyticsResult &result){
+	auto start = std::chrono::steady_clock::now();
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, sql, -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error preparing SQLite query for " + timing.question);
+		return false;
+	}
+	//Sorts after every date. It has to look like a date: invoice_date has NUMERIC affinity, so a bare "9999" would be compared as the number 9999
+	std::string to = request.to.empty() ? "9999-12-31 23:59:59" : request.to;
+	rc = sqlite3_bind_text(res, 1, request.from.c_str(), -1, SQLITE_STATIC);
+	if(rc == SQLITE_OK){rc = sqlite3_bind_text(res, 2, to.c_str(), -1, SQLITE_STATIC);}
+	if(rc == SQLITE_OK){rc = forEachRow<Columns...>(res, rowFunction);}
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error running SQLite query for " + timing.question);
+		return false;
+	}
+	sqlite3_finalize(res);
+	timing.sqliteSeconds = secondsSince(start);
+	return true;
+}
+
+//The mirror adds exact thousandths while SQLite adds doubles, so totals may differ by rounding in the last place of each row
+static bool sameAmount(double mirror, double sqlite, sqlite3_int64 rows){
+	return std::fabs(mirror - sqlite) <= 0.0005 * rows + 0.0005;
+}
+
+//Answers every question from the mirror, and from SQLite when the request compares
+static void answerQuestions(sqlite3 *db, const SalesColumns &columns, const AnalyticsRequest &request, sqlite3_int64 from, sqlite3_int64 to,
+	AnalyticsResult &result){
+	AnalyticsTiming regionTiming{"Revenue by region", columns.lineRows()};
+	auto start = std::chrono::steady_clock::now();
+	columns.revenueByRegion(from, to, result.revenueByRegion);
+	regionTiming.columnarSeconds = secondsSince(start);
+	if(request.compare){
+		std::unordered_map<std::string, RegionRevenue> found;
+		for(const RegionRevenue &region : result.revenueByRegion){found[region.region] = region;}
+		size_t rows = 0;
+		if(!timeQuery<std::string_view, sqlite3_int64, double>(db, REGION_REVENUE_SQL, request, [&](std::string_view region, sqlite3_int64 lines, double revenue){
+			auto mirror = found.find(std::string(region));
+			rows++;
+			if(mirror == found.end() || mirror->second.lines != lines || !sameAmount(mirror->second.revenue, revenue, lines)){regionTiming.matches = false;}
+		}, regionTiming, result)){return;}
+		if(rows != found.size()){regionTiming.matches = false;}
+	}
+	result.timings.push_back(regionTiming);
+
+	AnalyticsTiming productTiming{"Sales by product", columns.lineRows()};
+	start = std::chrono::steady_clock::now();
+	columns.salesByProduct(from, to, result.salesByProduct);
+	productTiming.columnarSeconds = secondsSince(start);
+	if(request.compare){
+		std::unordered_map<std::string, ProductSales> found;
+		for(const ProductSales &product : result.salesByProduct){found[product.prodCode] = product;}
+		size_t rows = 0;
+		if(!timeQuery<std::string_view, sqlite3_int64, double>(db, PRODUCT_SALES_SQL, request, [&](std::string_view prodCode, sqlite3_int64 units, double revenue){
+			auto mirror = found.find(std::string(prodCode));
+			rows++;
+			if(mirror == found.end() || mirror->second.units != units || !sameAmount(mirror->second.revenue, revenue, units)){productTiming.matches = false;}
+		}, productTiming, result)){return;}
+		if(rows != found.size()){productTiming.matches = false;}
+	}
+	result.timings.push_back(productTiming);
+
+	AnalyticsTiming martTiming{"Tax by PokeMart", columns.invoiceRows()};
+	start = std::chrono::steady_clock::now();
+	columns.taxByMart(from, to, result.taxByMart);
+	martTiming.columnarSeconds = secondsSince(start);
+	if(request.compare){
+		std::unordered_map<int, MartTax> found;
+		for(const MartTax &mart : result.taxByMart){found[mart.martID] = mart;}
+		size_t rows = 0;
+		if(!timeQuery<int, sqlite3_int64, double>(db, MART_TAX_SQL, request, [&](int martID, sqlite3_int64 invoices, double tax){
+			auto mirror = found.find(martID);
+			rows++;
+			if(mirror == found.end() || mirror->second.invoices != invoices || !sameAmount(mirror->second.tax, tax, invoices)){martTiming.matches = false;}
+		}, martTiming, result)){return;}
+		if(rows != found.size()){martTiming.matches = false;}
+	}
+	result.timings.push_back(martTiming);
+
+	AnalyticsTiming basketTiming{"Basket size", columns.invoiceRows() + columns.lineRows()};
+	start = std::chrono::steady_clock::now();
+	result.basket = columns.basketSize(from, to);
+	basketTiming.columnarSeconds = secondsSince(start);
+	if(request.compare){
+		if(!timeQuery<sqlite3_int64, sqlite3_int64, sqlite3_int64>(db, BASKET_SIZE_SQL, request, [&](sqlite3_int64 invoices, sqlite3_int64 lines, sqlite3_int64 units){
+			basketTiming.matches = invoices == result.basket.invoices && lines == result.basket.lines && units == result.basket.units;
+		}, basketTiming, result)){return;}
+	}
+	result.timings.push_back(basketTiming);
+}
+
+AnalyticsResult runSalesAnalytics(sqlite3 *db, const AnalyticsRequest &request){
+	AnalyticsResult result;
+	sqlite3_int64 from = std::numeric_limits<sqlite3_int64>::min(), to = std::numeric_limits<sqlite3_int64>::max();
+	if((!request.from.empty() && (!validDate(request.from) || !parseTimestamp(request.from, from))) ||
+		(!request.to.empty() && (!validDate(request.to) || !parseTimestamp(request.to, to)))){
+		fail(result, "Dates must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return result;
+	}
+
+	SalesColumns columns;
+	auto start = std::chrono::steady_clock::now();
+	OpResult loaded = columns.load(db);
+	result.loadSeconds = secondsSince(start);
+	if(!loaded.ok()){
+		result.rc = loaded.rc;
+		result.error = loaded.error;
+		return result;
+	}
+	result.invoiceRows = columns.invoiceRows();
+	result.lineRows = columns.lineRows();
+	answerQuestions(db, columns, request, from, to, result);
+	return result;
+}
+
+//Report fields
+const ReportField ANALYTICS_REPORT = {"Sales Analytics", "analytics"};
+const ReportField FROM_DATE = {"From", "from"};
+const ReportField TO_DATE = {"To", "to"};
+const ReportField INVOICE_ROWS = {"Invoice Rows Loaded", "invoice_rows"};
+const ReportField LINE_ROWS = {"Line Rows Loaded", "line_rows"};
+const ReportField LOAD_SECONDS = {"Load Seconds", "load_seconds"};
+const ReportField REVENUE_BY_REGION = {"Revenue By Region", "revenue_by_region"};
+const ReportField REGION = {"Region", "region"};
+const ReportField LINES = {"Lines", "lines"};
+const ReportField REVENUE = {"Revenue", "revenue"};
+const ReportField SALES_BY_PRODUCT = {"Sales By Product", "sales_by_product"};
+const ReportField PROD_CODE = {"Product Code", "prod_code"};
+const ReportField UNITS = {"Units", "units"};
+const ReportField TAX_BY_MART = {"Tax By PokeMart", "tax_by_mart"};
+const ReportField MART_ID = {"PokeMart", "mart_id"};
+const ReportField INVOICES = {"Invoices", "invoices"};
+const ReportField TAX = {"Tax", "tax"};
+const ReportField AVERAGE_LINES = {"Average Lines Per Invoice", "average_lines"};
+const ReportField AVERAGE_UNITS = {"Average Units Per Invoice", "average_units"};
+const ReportField THROUGHPUT = {"Scan Throughput", "throughput"};
+const ReportField QUESTION = {"Question", "question"};
+const ReportField ROWS_SCANNED = {"Rows Scanned", "rows_scanned"};
+const ReportField COLUMNAR_ROWS_PER_SECOND = {"Columnar Rows/s", "columnar_rows_per_second"};
+const ReportField SQLITE_ROWS_PER_SECOND = {"SQLite Rows/s", "sqlite_rows_per_second"};
+const ReportField SPEEDUP = {"Speedup", "speedup"};
+const ReportField MATCHES = {"Matches SQLite", "matches_sqlite"};
+
+static sqlite3_int64 rowsPerSecond(sqlite3_int64 rows, double seconds){
+	return seconds > 0 ? static_cast<sqlite3_int64>(rows / seconds) : 0;
+}
+
+void writeAnalyticsReport(const AnalyticsRequest &request, const AnalyticsResult &result, ReportRenderer &out){
+	out.beginReport(ANALYTICS_REPORT);
+	out.field(FROM_DATE, request.from.empty() ? "(all)" : request.from);
+	out.field(TO_DATE, request.to.empty() ? "(all)" : request.to);
+	out.field(INVOICE_ROWS, result.invoiceRows);
+	out.field(LINE_ROWS, result.lineRows);
+	out.decimalField(LOAD_SECONDS, result.loadSeconds);
+
+	out.beginRows(REVENUE_BY_REGION);
+	for(const RegionRevenue &region : result.revenueByRegion){
+		out.beginRow();
+		out.field(REGION, region.region);
+		out.field(LINES, region.lines);
+		out.moneyField(REVENUE, region.revenue);
+		out.endRow();
+	}
+	out.endRows();
+
+	out.beginRows(SALES_BY_PRODUCT);
+	for(const ProductSales &product : result.salesByProduct){
+		out.beginRow();
+		out.field(PROD_CODE, product.prodCode);
+		out.field(UNITS, product.units);
+		out.moneyField(REVENUE, product.revenue);
+		out.endRow();
+	}
+	out.endRows();
+
+	out.beginRows(TAX_BY_MART);
+	for(const MartTax &mart : result.taxByMart){
+		out.beginRow();
+		out.field(MART_ID, mart.martID);
+		out.field(INVOICES, mart.invoices);
+		out.moneyField(TAX, mart.tax);
+		out.endRow();
+	}
+	out.endRows();
+
+	out.field(INVOICES, result.basket.invoices);
+	out.decimalField(AVERAGE_LINES, result.basket.invoices > 0 ? static_cast<double>(result.basket.lines) / result.basket.invoices : 0);
+	out.decimalField(AVERAGE_UNITS, result.basket.invoices > 0 ? static_cast<double>(result.basket.units) / result.basket.invoices : 0);
+
+	out.beginRows(THROUGHPUT);
+	for(const AnalyticsTiming &timing : result.timings){
+		out.beginRow();
+		out.field(QUESTION, timing.question);
+		out.field(ROWS_SCANNED, timing.rowsScanned);
+		out.field(COLUMNAR_ROWS_PER_SECOND, rowsPerSecond(timing.rowsScanned, timing.columnarSeconds));
+		if(request.compare){
+			out.field(SQLITE_ROWS_PER_SECOND, rowsPerSecond(timing.rowsScanned, timing.sqliteSeconds));
+			out.decimalField(SPEEDUP, timing.columnarSeconds > 0 ? timing.sqliteSeconds / timing.columnarSeconds : 0);
+			out.field(MATCHES, timing.matches ? "yes" : "no");
+		}
+		out.endRow();
+	}
+	out.endRows();
+	out.endReport();
+}
@@ -0,0 +1,97 @@
+/* Program name: analytics.h
+* Purpose: Declares the sales analytics mirror. Questions such as revenue by region or tax collected by PokeMart scan every invoice and line, which SQLite
+*  does one row at a time through joins. SalesColumns loads invoice, line and the PokeMart regions once into dense arrays, one per column, with prod_code
+*  and region replaced by small integer codes and money stored as whole thousandths (the NUMERIC(9,3) scale) so sums are exact integer adds. Each line
+*  also carries its invoice's date and region, so every question is a date filter and a grouped sum over a few arrays, which the compiler vectorizes.
+*  The mirror is a snapshot: sales recorded after load are not in it until it is loaded again.
+*/
+
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct AnalyticsRequest{
+	std::string from, to; //Only invoices dated from <= invoice_date < to ("YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS"). An empty date leaves that end open
+	bool compare = true; //Also answer each question with the equivalent SQLite query, time it and check both answers agree
+};
+
+struct RegionRevenue{
+	std::string region;
+	sqlite3_int64 lines = 0;
+	double revenue = 0; //Sum of line_total
+};
+
+struct ProductSales{
+	std::string prodCode;
+	sqlite3_int64 units = 0;
+	double revenue = 0;
+};
+
+struct MartTax{
+	int martID;
+	sqlite3_int64 invoices = 0;
+	double tax = 0;
+};
+
+struct BasketSize{
+	sqlite3_int64 invoices = 0, lines = 0, units = 0;
+};
+
+//Rows scanned per second by the mirror and by SQLite for one question
+struct AnalyticsTiming{
+	std::string question;
+	sqlite3_int64 rowsScanned = 0;
+	double columnarSeconds = 0, sqliteSeconds = 0;
+	bool matches = true; //SQLite gave the same answer. Always true when the request does not compare
+};
+
+//Groups are in dictionary order (region and prod_code by first appearance, PokeMarts by mart_id); groups with no rows in the date range are left out
+struct AnalyticsResult : OpResult{
+	sqlite3_int64 invoiceRows = 0, lineRows = 0;
+	double loadSeconds = 0;
+	std::vector<RegionRevenue> revenueByRegion;
+	std::vector<ProductSales> salesByProduct;
+	std::vector<MartTax> taxByMart;
+	BasketSize basket;
+	std::vector<AnalyticsTiming> timings;
+};
+
+class SalesColumns{
+public:
+	//Reads every invoice and line. Replaces anything loaded before
+	OpResult load(sqlite3 *);
+
+	//Dates are Unix time, from inclusive and to exclusive
+	void revenueByRegion(sqlite3_int64 from, sqlite3_int64 to, std::vector<RegionRevenue> &) const;
+	void salesByProduct(sqlite3_int64 from, sqlite3_int64 to, std::vector<ProductSales> &) const;
+	void taxByMart(sqlite3_int64 from, sqlite3_int64 to, std::vector<MartTax> &) const;
+	BasketSize basketSize(sqlite3_int64 from, sqlite3_int64 to) const;
+
+	sqlite3_int64 invoiceRows() const {return invoiceEpoch.size();}
+	sqlite3_int64 lineRows() const {return lineEpoch.size();}
+
+private:
+	//Dictionaries: a code is the index of its value
+	std::vector<std::string> regions, products;
+	std::vector<int> marts; //mart_id of each PokeMart code
+
+	//One entry per invoice
+	std::vector<sqlite3_int64> invoiceEpoch, invoiceTax;
+	std::vector<int> invoiceMart;
+
+	//One entry per line
+	std::vector<sqlite3_int64> lineEpoch, lineTotal;
+	std::vector<int> lineRegion, lineProduct, lineQty;
+};
+
+//Loads a SalesColumns and answers revenue by region, sales by product, tax by PokeMart and basket size for the request's dates
+AnalyticsResult runSalesAnalytics(sqlite3 *, const AnalyticsRequest &);
+
+void writeAnalyticsReport(const AnalyticsRequest &, const AnalyticsResult &, ReportRenderer &);
+
+#endif
@@ -0,0 +1,156 @@
+/* Program name: analytics_bench.cpp
+* Purpose: Benchmarks the sales analytics mirror (analytics.h). Builds a database from tables.sql with 200 PokeMarts in 20 regions, 100 products and a
+*  year of invoices, then answers revenue by region, sales by product, tax by PokeMart and basket size over the whole year and over one month, once from
+*  the mirror and once with the equivalent SQLite queries. Prints the rows each scans per second and fails if any answer differs.
+*  Usage: analytics_bench [invoices] [lines_per_invoice] (run from the source directory; analytics_bench.db is rebuilt on every run)
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "analytics.h"
+
+const int REGIONS = 20;
+const int DB_MARTS = 200;
+const int DB_PRODUCTS = 100;
+
+static double secondsSince(std::chrono::steady_clock::time_point start){
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+static bool execOrReport(sqlite3 *db, const std::string &sql, const char *what){
+	if(sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error " << what << ": " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+//Creates the schema and a chain with a year of sales. Invoices and lines are inserted with their own prepared statements, as the registry has no bulk insert
+static bool buildDatabase(sqlite3 *db, int invoices, int linesPerInvoice){
+	std::ifstream tablesFile("tables.sql");
+	if(!tablesFile){
+		std::cerr << "tables.sql not found; run the benchmark from the source directory\n";
+		return false;
+	}
+	std::stringstream tables;
+	tables << tablesFile.rdbuf();
+	if(!execOrReport(db, tables.str(), "creating schema")){return false;}
+
+	std::string sql = "BEGIN;INSERT INTO trainer_card (trainer_fname, trainer_lname) VALUES ('Bench', 'Trainer');"
+		"INSERT INTO employee (emp_fname, emp_lname) VALUES ('Bench', 'Clerk');";
+	for(int m = 1; m <= DB_MARTS; m++){
+		sql += "INSERT INTO pokemart (city, region, street_address, phone_num) VALUES ('Bench', 'Region " + std::to_string(m % REGIONS) + "', '" +
+			std::to_string(m) + " Bench Road', '" + std::to_string(m) + "');";
+	}
+	for(int p = 1; p <= DB_PRODUCTS; p++){
+		sql += "INSERT INTO product (prod_code, prod_name, prod_descript, unit_price, min_qty, vendor_price) VALUES ('P" + std::to_string(p) + "', 'Product " +
+			std::to_string(p) + "', 'Benchmark', " + std::to_string(p) + ".25, 10, 1);";
+	}
+	if(!execOrReport(db, sql, "filling benchmark database")){return false;}
+
+	sqlite3_stmt *invoice, *line;
+	sqlite3_prepare_v2(db, "INSERT INTO invoice (trainer_id, emp_id, mart_id, invoice_date, subtotal, tax, total) VALUES (1, 1, ?, datetime(1704067200 + ?, "
+		"'unixepoch'), ?, ?, ?)", -1, &invoice, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO line (invoice_num, line_num, prod_code, qty, unit_price, line_total) VALUES (?, ?, ?, ?, ?, ?)", -1, &line, NULL);
+	std::mt19937 random(11);
+	int rc = SQLITE_OK;
+	for(int i = 1; i <= invoices && rc == SQLITE_OK; i++){
+		int lines = 1 + random() % (2 * linesPerInvoice - 1); //Averages linesPerInvoice
+		double subtotal = 0;
+		for(int l = 1; l <= lines && rc == SQLITE_OK; l++){
+			int product = 1 + random() % DB_PRODUCTS, qty = 1 + random() % 9;
+			double price = product + 0.25;
+			std::string code = "P" + std::to_string(product);
+			sqlite3_bind_int(line, 1, i);
+			sqlite3_bind_int(line, 2, l);
+			sqlite3_bind_text(line, 3, code.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int(line, 4, qty);
+			sqlite3_bind_double(line, 5, price);
+			sqlite3_bind_double(line, 6, price * qty);
+			subtotal += price * qty;
+			rc = sqlite3_step(line) == SQLITE_DONE ? SQLITE_OK : sqlite3_errcode(db);
+			sqlite3_reset(line);
+		}
+		double tax = static_cast<long long>(subtotal * 70 + 0.5) / 1000.0; //7%, rounded to the column's thousandths
+		sqlite3_bind_int(invoice, 1, 1 + random() % DB_MARTS);
+		sqlite3_bind_int(invoice, 2, static_cast<int>(random() % (366 * 86400)));
+		sqlite3_bind_double(invoice, 3, subtotal);
+		sqlite3_bind_double(invoice, 4, tax);
+		sqlite3_bind_double(invoice, 5, subtotal + tax);
+		if(rc == SQLITE_OK){rc = sqlite3_step(invoice) == SQLITE_DONE ? SQLITE_OK : sqlite3_errcode(db);}
+		sqlite3_reset(invoice);
+	}
+	sqlite3_finalize(invoice);
+	sqlite3_finalize(line);
+	if(rc != SQLITE_OK){
+		std::cerr << "Error filling benchmark database: " << sqlite3_errmsg(db) << '\n';
+		sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+		return false;
+	}
+	return execOrReport(db, "COMMIT", "filling benchmark database");
+}
+
+static bool benchRange(sqlite3 *db, const char *label, const AnalyticsRequest &request){
+	AnalyticsResult result = runSalesAnalytics(db, request);
+	if(!result.ok()){
+		std::cerr << result.error << '\n';
+		return false;
+	}
+	std::cout << label << ": loaded " << result.invoiceRows << " invoices and " << result.lineRows << " lines in " << result.loadSeconds << " s\n";
+	bool ok = true;
+	for(const AnalyticsTiming &timing : result.timings){
+		double columnar = timing.columnarSeconds > 0 ? timing.rowsScanned / timing.columnarSeconds : 0;
+		double sqlite = timing.sqliteSeconds > 0 ? timing.rowsScanned / timing.sqliteSeconds : 0;
+		std::cout << "  " << timing.question << ": " << timing.rowsScanned << " rows, mirror " << columnar << " rows/s, SQLite " << sqlite << " rows/s";
+		if(timing.columnarSeconds > 0){std::cout << " (" << timing.sqliteSeconds / timing.columnarSeconds << "x)";}
+		std::cout << '\n';
+		if(!timing.matches){
+			std::cerr << timing.question << " from the mirror does not match SQLite\n";
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+int main(int argc, char *argv[]){
+	int invoices = argc > 1 ? std::atoi(argv[1]) : 200000;
+	int linesPerInvoice = argc > 2 ? std::atoi(argv[2]) : 5;
+	if(invoices < 1 || linesPerInvoice < 1){
+		std::cerr << "Usage: " << argv[0] << " [invoices] [lines_per_invoice]\n";
+		return 2;
+	}
+
+	std::string path = "analytics_bench.db";
+	std::remove(path.c_str());
+	sqlite3 *db;
+	if(sqlite3_open(path.c_str(), &db) != SQLITE_OK){
+		std::cerr << "Error opening " << path << ": " << sqlite3_errmsg(db) << '\n';
+		sqlite3_close(db);
+		return 1;
+	}
+	auto start = std::chrono::steady_clock::now();
+	OpResult prepared;
+	if(buildDatabase(db, invoices, linesPerInvoice)){prepared = enableForeignKeys(db);}
+	else{prepared.rc = -1;}
+	if(prepared.ok()){prepared = prepareStatements(db);}
+	if(!prepared.ok()){
+		if(!prepared.error.empty()){std::cerr << prepared.error << '\n';}
+		sqlite3_close(db);
+		return 1;
+	}
+	std::cout << "Built " << invoices << " invoices in " << secondsSince(start) << " s\n";
+
+	AnalyticsRequest year, month;
+	month.from = "2024-06-01";
+	month.to = "2024-07-01";
+	bool ok = benchRange(db, "Whole year", year) && benchRange(db, "June", month);
+	finalizeStatements(db);
+	sqlite3_close(db);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/* Program name: asof.cpp
+* Purpose: Implements the as-of lookups and checkpoints declared in asof.h with the AS_OF_ and CHECKPOINT_ registry statements. The keys of a report are every
+*  PokeMart (and product) matching the request, read first; each is then looked up with the same prepared statement.
+*/
+
+#include "asof.h"
+#include "pokemart_internal.h"
+#include "statements.h"
+#include "timestamp.h"
+
+//A (PokeMart, product) pair. prodCode is empty for balance keys
+struct HistoryKey{
+	int martID;
+	std::string prodCode;
+};
+
+//Reads the PokeMarts matching martID (0 for all), with every product matching prodCode (empty for all) when withProducts is set
+static int readKeys(sqlite3 *db, int martID, const std::string &prodCode, bool withProducts, std::vector<HistoryKey> &keys, OpResult &result){
+	const char *query = withProducts
+		? "SELECT m.mart_id, p.prod_code FROM pokemart m CROSS JOIN product p WHERE (?1 = 0 OR m.mart_id = ?1) AND (?2 = '' OR p.prod_code = ?2) "
+		  "ORDER BY m.mart_id, p.prod_code"
+		: "SELECT mart_id, '' FROM pokemart WHERE ?1 = 0 OR mart_id = ?1 ORDER BY mart_id";
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, query, -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error preparing as-of keys");}
+	rc = sqlite3_bind_int(res, 1, martID);
+	if(rc == SQLITE_OK && withProducts){rc = sqlite3_bind_text(res, 2, prodCode.c_str(), -1, SQLITE_STATIC);}
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error binding as-of keys");}
+	rc = forEachRow<int, std::string_view>(res, [&](int mart, std::string_view prod){keys.push_back({mart, std::string(prod)});});
+	if(rc != SQLITE_DONE){return fail(result, db, res, "Error reading as-of keys");}
+	sqlite3_finalize(res);
+	return SQLITE_OK;
+}
+
+bool asOfTime(const std::string &at, sqlite3_int64 &epoch){
+	if(at.empty()){
+		epoch = currentTimestamp().epoch;
+		return true;
+	}
+	if(at.size() == 10){return parseTimestamp(at + " 23:59:59", epoch);}
+	return parseTimestamp(at, epoch);
+}
+
+//Resolves the request's time into result.at. Returns false (with the error on result) if it is not a valid time
+static bool resolveTime(const std::string &at, sqlite3_int64 &epoch, OpResult &result){
+	if(!asOfTime(at, epoch)){
+		fail(result, "Invalid time " + at + ". Times must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return false;
+	}
+	return true;
+}
+
+AsOfResult stockAsOf(sqlite3 *db, const AsOfRequest &request){
+	AsOfResult result;
+	sqlite3_int64 epoch;
+	if(!resolveTime(request.at, epoch, result)){return result;}
+	result.at = std::string(timestampAt(epoch).view());
+	std::vector<HistoryKey> keys;
+	if(readKeys(db, request.martID, request.prodCode, true, keys, result) != SQLITE_OK){return result;}
+
+	for(const HistoryKey &key : keys){
+		Query query(db, AS_OF_STOCK);
+		if(!query.prepared()){
+			fail(result, db, NULL, "Error preparing stock as-of lookup");
+			return result;
+		}
+		if(query.bind(key.martID, key.prodCode, epoch) != SQLITE_OK){
+			fail(result, db, NULL, "Error binding stock as-of lookup");
+			return result;
+		}
+		int rc = query.forEach([&](int qty, std::string_view stockDate){result.stock.push_back({key.martID, key.prodCode, qty, std::string(stockDate)});});
+		if(rc != SQLITE_DONE){
+			fail(result, db, NULL, "Error reading stock of " + key.prodCode + " at PokeMart " + std::to_string(key.martID));
+			return result;
+		}
+	}
+	return result;
+}
+
+AsOfResult balancesAsOf(sqlite3 *db, const AsOfRequest &request){
+	AsOfResult result;
+	sqlite3_int64 epoch;
+	if(!resolveTime(request.at, epoch, result)){return result;}
+	result.at = std::string(timestampAt(epoch).view());
+	std::vector<HistoryKey> keys;
+	if(readKeys(db, request.martID, request.prodCode, false, keys, result) != SQLITE_OK){return result;}
+
+	for(const HistoryKey &key : keys){
+		Query query(db, AS_OF_BALANCE);
+		if(!query.prepared()){
+			fail(result, db, NULL, "Error preparing balance as-of lookup");
+			return result;
+		}
+		if(query.bind(key.martID, epoch) != SQLITE_OK){
+			fail(result, db, NULL, "Error binding balance as-of lookup");
+			return result;
+		}
+		int rc = query.forEach([&](double balance, std::string_view balanceDate){result.balances.push_back({key.martID, balance, std::string(balanceDate)});});
+		if(rc != SQLITE_DONE){
+			fail(result, db, NULL, "Error reading balance of PokeMart " + std::to_string(key.martID));
+			return result;
+		}
+	}
+	return result;
+}
+
+//Checkpoints the stock of every product with history and the balance of one PokeMart, in the caller's transaction. The products are read into prodCodes
+//(reused from PokeMart to PokeMart) before any is written, since the inserts go into one of the tables being read
+static int checkpointMart(sqlite3 *db, int martID, std::vector<std::string> &prodCodes, sqlite3_int64 epoch, CheckpointResult &result){
+	prodCodes.clear();
+	{
+		Query query(db, CHECKPOINT_PRODUCTS);
+		if(!query.prepared()){return fail(result, db, NULL, "Error preparing checkpoint products");}
+		if(query.bind(martID) != SQLITE_OK){return fail(result, db, NULL, "Error binding checkpoint products");}
+		if(query.forEach([&](std::string_view prodCode){prodCodes.emplace_back(prodCode);}) != SQLITE_DONE){
+			return fail(result, db, NULL, "Error reading the products of PokeMart " + std::to_string(martID));
+		}
+	}
+	for(const std::string &prodCode : prodCodes){
+		Query query(db, CHECKPOINT_STOCK);
+		if(!query.prepared()){return fail(result, db, NULL, "Error preparing stock checkpoint");}
+		if(query.bind(martID, prodCode, epoch) != SQLITE_OK){return fail(result, db, NULL, "Error binding stock checkpoint");}
+		if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error checkpointing stock of " + prodCode + " at PokeMart " + std::to_string(martID));}
+		result.stockRows += sqlite3_changes(db);
+	}
+	Query query(db, CHECKPOINT_BALANCE);
+	if(!query.prepared()){return fail(result, db, NULL, "Error preparing balance checkpoint");}
+	if(query.bind(martID, epoch) != SQLITE_OK){return fail(result, db, NULL, "Error binding balance checkpoint");}
+	if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error checkpointing balance of PokeMart " + std::to_string(martID));}
+	result.balanceRows += sqlite3_changes(db);
+	return SQLITE_OK;
+}
+
+CheckpointResult takeCheckpoint(sqlite3 *db, sqlite3_int64 epoch){
+	CheckpointResult result;
+	Timestamp at = timestampAt(epoch);
+	result.at = std::string(at.view());
+	if(epoch > currentTimestamp().epoch){
+		fail(result, "Cannot checkpoint " + result.at + ", which is in the future");
+		return result;
+	}
+	std::vector<HistoryKey> marts;
+	if(readKeys(db, 0, "", false, marts, result) != SQLITE_OK){return result;}
+	std::vector<std::string> prodCodes;
+
+	//Each PokeMart is its own IMMEDIATE transaction, so the write lock is taken up front and a sale waiting on it gets in between PokeMarts. Rows recorded
+	//meanwhile are dated now, after the checkpoint, so they do not change what it holds
+	for(const HistoryKey &mart : marts){
+		if(sqlite3_exec(db, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK){
+			fail(result, db, NULL, "Error starting checkpoint of PokeMart " + std::to_string(mart.martID));
+			return result;
+		}
+		if(checkpointMart(db, mart.martID, prodCodes, epoch, result) != SQLITE_OK){
+			rollback(db);
+			return result;
+		}
+		if(commit(db) != SQLITE_OK){
+			fail(result, db, NULL, "Error committing checkpoint of PokeMart " + std::to_string(mart.martID));
+			rollback(db);
+			return result;
+		}
+	}
+
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO history_checkpoint (checkpoint_epoch, checkpoint_date, stock_rows, balance_rows) VALUES (?, ?, ?, ?)",
+		-1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error preparing checkpoint record");
+		return result;
+	}
+	rc = sqlite3_bind_int64(res, 1, epoch);
+	if(rc == SQLITE_OK){rc = sqlite3_bind_text(res, 2, at.text, TIMESTAMP_LENGTH, SQLITE_STATIC);}
+	if(rc == SQLITE_OK){rc = sqlite3_bind_int(res, 3, result.stockRows);}
+	if(rc == SQLITE_OK){rc = sqlite3_bind_int(res, 4, result.balanceRows);}
+	if(rc == SQLITE_OK){rc = sqlite3_step(res);}
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error recording checkpoint");
+		return result;
+	}
+	sqlite3_finalize(res);
+	return result;
+}
+
+//Report fields
+const ReportField STOCK_AS_OF_REPORT = {"Stock As Of", "stock_as_of"};
+const ReportField BALANCES_AS_OF_REPORT = {"PokeMart Balances As Of", "balances_as_of"};
+const ReportField CHECKPOINT_REPORT = {"History Checkpoint", "checkpoint"};
+const ReportField AT = {"As Of", "at"};
+const ReportField STOCK = {"Stock", "stock"};
+const ReportField BALANCES = {"Balances", "balances"};
+const ReportField MART_ID = {"PokeMart", "mart_id"};
+const ReportField PROD_CODE = {"Product Code", "prod_code"};
+const ReportField QTY = {"Quantity", "qty"};
+const ReportField STOCK_DATE = {"Recorded", "stock_date"};
+const ReportField BALANCE = {"Balance", "balance"};
+const ReportField BALANCE_DATE = {"Recorded", "balance_date"};
+const ReportField STOCK_ROWS = {"Stock Rows", "stock_rows"};
+const ReportField BALANCE_ROWS = {"Balance Rows", "balance_rows"};
+
+void writeStockAsOfReport(const AsOfRequest &, const AsOfResult &result, ReportRenderer &out){
+	out.beginReport(STOCK_AS_OF_REPORT);
+	out.field(AT, result.at);
+	out.beginRows(STOCK);
+	for(const StockAsOf &stock : result.stock){
+		out.beginRow();
+		out.field(MART_ID, stock.martID);
+		out.field(PROD_CODE, stock.prodCode);
+		out.field(QTY, stock.qty);
+		out.field(STOCK_DATE, stock.stockDate);
+		out.endRow();
+	}
+	out.endRows();
+	out.endReport();
+}
+
+void writeBalancesAsOfReport(const AsOfRequest &, const AsOfResult &result, ReportRenderer &out){
+	out.beginReport(BALANCES_AS_OF_REPORT);
+	out.field(AT, result.at);
+	out.beginRows(BALANCES);
+	for(const BalanceAsOf &balance : result.balances){
+		out.beginRow();
+		out.field(MART_ID, balance.martID);
+		out.moneyField(BALANCE, balance.balance);
+		out.field(BALANCE_DATE, balance.balanceDate);
+		out.endRow();
+	}
+	out.endRows();
+	out.endReport();
+}
+
+void writeCheckpointReport(const CheckpointResult &result, ReportRenderer &out){
+	out.beginReport(CHECKPOINT_REPORT);
+	out.field(AT, result.at);
+	out.field(STOCK_ROWS, result.stockRows);
+	out.field(BALANCE_ROWS, result.balanceRows);
+	out.endReport();
+}
@@ -0,0 +1,65 @@
+/* Program name: asof.h
+* Purpose: Declares as-of lookups over stock_history and mart_balance_history: the stock of a product at a PokeMart, or a PokeMart's balance, in effect at
+*  a given time rather than the latest. The row in effect is the last one dated at or before that time, read with one seek back in the
+*  (mart_id, prod_code, stock_epoch) and (mart_id, balance_epoch) indexes, so a lookup never scans a key's history. Reports over every PokeMart do one
+*  seek per key. Checkpoints copy the row in effect for every key at a chosen time into stock_checkpoint and balance_checkpoint; a lookup takes the later
+*  of the history row and the checkpoint row, so compaction (which takes a checkpoint at its cutoff) can archive old history without changing any answer
+*  from the cutoff on. Times before the first compaction's cutoff are answered from whatever history is still in pokemart.db.
+*/
+
+#ifndef ASOF_H
+#define ASOF_H
+
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct AsOfRequest{
+	std::string at; //"YYYY-MM-DD HH:MM:SS", or "YYYY-MM-DD" for the end of that day. Empty for now
+	int martID = 0; //0 for every PokeMart
+	std::string prodCode; //Empty for every product. Not used for balances
+};
+
+struct StockAsOf{
+	int martID;
+	std::string prodCode;
+	int qty;
+	std::string stockDate; //Date of the history row the stock was read from
+};
+
+struct BalanceAsOf{
+	int martID;
+	double balance;
+	std::string balanceDate;
+};
+
+//Rows are in mart_id (then prod_code) order. Keys with no history by the time are left out
+struct AsOfResult : OpResult{
+	std::string at; //The time looked up, as "YYYY-MM-DD HH:MM:SS"
+	std::vector<StockAsOf> stock;
+	std::vector<BalanceAsOf> balances;
+};
+
+struct CheckpointResult : OpResult{
+	std::string at;
+	int stockRows = 0, balanceRows = 0;
+};
+
+//Converts an AsOfRequest time to Unix time, with "YYYY-MM-DD" as 23:59:59 that day and empty as now. Returns false if the text is in neither format
+bool asOfTime(const std::string &at, sqlite3_int64 &epoch);
+
+AsOfResult stockAsOf(sqlite3 *, const AsOfRequest &);
+AsOfResult balancesAsOf(sqlite3 *, const AsOfRequest &);
+
+//Checkpoints the stock of every (PokeMart, product) with history and every PokeMart balance in effect at epoch, one PokeMart per transaction so sales are
+//not held up. The time cannot be in the future, as rows recorded after the checkpoint could still be dated before it. Taking a checkpoint at the same time
+//again replaces it
+CheckpointResult takeCheckpoint(sqlite3 *, sqlite3_int64 epoch);
+
+void writeStockAsOfReport(const AsOfRequest &, const AsOfResult &, ReportRenderer &);
+void writeBalancesAsOfReport(const AsOfRequest &, const AsOfResult &, ReportRenderer &);
+void writeCheckpointReport(const CheckpointResult &, ReportRenderer &);
+
+#endif
@@ -0,0 +1,572 @@
+/* Program name: bootstrap.cpp
+* Purpose: Implements the bootstrap job declared in bootstrap.h. The files are split into statements on one thread, since a quote can only be told from
+*  the end of a string by reading from the start. The seed statements are then handed out to the parser threads in contiguous ranges of about the same size,
+*  so the runs of each thread are in file order relative to each other. Loading uses a single connection because SQLite has a single writer.
+*/
+
+#include "bootstrap.h"
+#include "pokemart_internal.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+//One literal from a VALUES list
+struct SeedValue{
+	int type = SQLITE_NULL; //SQLITE_NULL, SQLITE_INTEGER, SQLITE_FLOAT or SQLITE_TEXT
+	sqlite3_int64 integer = 0;
+	double real = 0;
+	std::string text;
+};
+
+typedef std::vector<SeedValue> SeedRow;
+
+//The rows of every INSERT into one table with one column list between two statements that are run as written. A thread parses part of a run; the
+//parts are merged before loading
+struct SeedRun{
+	std::string table, columns; //columns is the column list joined with ", "
+	size_t segment = 0; //1 + the statement run as written just before these rows, or 0 if there is none
+	size_t firstStatement = 0; //Runs in a segment are loaded in the order they first appear in the seed file
+	std::vector<int> key; //Positions of the primary key columns in the column list. Empty when the table's rowids are assigned in file order
+	std::vector<SeedRow> rows;
+};
+
+typedef std::map<std::pair<size_t, std::string>, SeedRun> SeedRuns; //By segment, then lowercase table name and column list
+
+//What one parser thread produced
+struct ParsePart{
+	size_t firstStatement = 0, lastStatement = 0; //[first, last) of the seed statements
+	SeedRuns runs;
+	std::vector<size_t> unparsed; //Statements to run as written. Rows after one of these are not loaded until it has run
+	sqlite3_int64 rows = 0;
+};
+
+typedef std::chrono::steady_clock Stopwatch;
+
+static void addPhase(BootstrapResult &result, const char *name, double seconds, sqlite3_int64 statements, sqlite3_int64 rows){
+	BootstrapPhase phase;
+	phase.name = name;
+	phase.seconds = seconds;
+	phase.statements = statements;
+	phase.rows = rows;
+	result.phases.push_back(phase);
+}
+
+//Returns the seconds since start and restarts the stopwatch
+static double lap(Stopwatch::time_point &start){
+	Stopwatch::time_point now = Stopwatch::now();
+	double seconds = std::chrono::duration<double>(now - start).count();
+	start = now;
+	return seconds;
+}
+
+static bool readFile(const std::string &path, std::string &contents){
+	std::ifstream file(path, std::ios::binary);
+	if(!file){return false;}
+	std::stringstream text;
+	text << file.rdbuf();
+	contents = text.str();
+	return true;
+}
+
+static std::string lowercase(std::string_view text){
+	std::string lower(text);
+	for(char &c : lower){c = std::tolower(static_cast<unsigned char>(c));}
+	return lower;
+}
+
+//Splits a .sql file into statements at every ; that is not inside a quoted string, quoted name or comment. The blank space and comments before each
+//statement are dropped, and so is the ;
+static std::vector<std::string_view> splitStatements(std::string_view sql){
+	std::vector<std::string_view> statements;
+	size_t start = 0, i = 0;
+	bool inStatement = false;
+	while(i < sql.size()){
+		char c = sql[i];
+		if(c == '-' && i + 1 < sql.size() && sql[i + 1] == '-'){
+			i = sql.find('\n', i);
+			if(i == std::string_view::npos){i = sql.size();}
+			continue;
+		}
+		if(c == '/' && i + 1 < sql.size() && sql[i + 1] == '*'){
+			i = sql.find("*/", i + 2);
+			i = i == std::string_view::npos ? sql.size() : i + 2;
+			continue;
+		}
+		if(c == ';'){
+			if(inStatement){statements.push_back(sql.substr(start, i - start));}
+			inStatement = false;
+			i++;
+			continue;
+		}
+		if(!inStatement && !std::isspace(static_cast<unsigned char>(c))){
+			start = i;
+			inStatement = true;
+		}
+		if(c == '\'' || c == '"' || c == '`' || c == '['){
+			char close = c == '[' ? ']' : c;
+			for(i++; i < sql.size(); i++){
+				if(sql[i] != close){continue;}
+				if(close != ']' && i + 1 < sql.size() && sql[i + 1] == close){i++; continue;} //A doubled quote is part of the string
+				break;
+			}
+		}
+		i++;
+	}
+	if(inStatement){statements.push_back(sql.substr(start));}
+	return statements;
+}
+
+//Reads the parts of a seed INSERT. Only INSERT INTO name (columns) VALUES (...), ... with literal values is understood; anything else is left to SQLite
+class SeedParser{
+public:
+	explicit SeedParser(std::string_view statement) : sql(statement) {}
+
+	bool parseInsert(std::string &table, std::vector<std::string> &columns, std::vector<SeedRow> &rows){
+		if(!keyword("INSERT") || !keyword("INTO") || !name(table) || !symbol('(')){return false;}
+		do{
+			std::string column;
+			if(!name(column)){return false;}
+			columns.push_back(column);
+		}while(symbol(','));
+		if(!symbol(')') || !keyword("VALUES")){return false;}
+		do{
+			if(!symbol('(')){return false;}
+			SeedRow row;
+			row.reserve(columns.size());
+			do{
+				row.emplace_back();
+				if(!literal(row.back())){return false;}
+			}while(symbol(','));
+			if(!symbol(')') || row.size() != columns.size()){return false;}
+			rows.push_back(std::move(row));
+		}while(symbol(','));
+		skipSpace();
+		return pos == sql.size();
+	}
+
+private:
+	std::string_view sql;
+	size_t pos = 0;
+
+	void skipSpace(){
+		while(pos < sql.size()){
+			if(std::isspace(static_cast<unsigned char>(sql[pos]))){pos++;}
+			else if(sql.compare(pos, 2, "--") == 0){
+				pos = sql.find('\n', pos);
+				if(pos == std::string_view::npos){pos = sql.size();}
+			}
+			else if(sql.compare(pos, 2, "/*") == 0){
+				pos = sql.find("*/", pos + 2);
+				pos = pos == std::string_view::npos ? sql.size() : pos + 2;
+			}
+			else{break;}
+		}
+	}
+
+	static bool wordChar(char c){return std::isalnum(static_cast<unsigned char>(c)) || c == '_';}
+
+	bool symbol(char c){
+		skipSpace();
+		if(pos < sql.size() && sql[pos] == c){
+			pos++;
+			return true;
+		}
+		return false;
+	}
+
+	bool keyword(const char *word){
+		skipSpace();
+		size_t length = std::char_traits<char>::length(word);
+		if(pos + length > sql.size() || (pos + length < sql.size() && wordChar(sql[pos + length]))){return false;}
+		for(size_t i = 0; i < length; i++){
+			if(std::toupper(static_cast<unsigned char>(sql[pos + i])) != word[i]){return false;}
+		}
+		pos += length;
+		return true;
+	}
+
+	//A plain or "quoted" table or column name, kept as written so it can be put back into SQL
+	bool name(std::string &out){
+		skipSpace();
+		size_t start = pos;
+		if(pos < sql.size() && sql[pos] == '"'){
+			size_t close = sql.find('"', pos + 1);
+			if(close == std::string_view::npos){return false;}
+			pos = close + 1;
+		}
+		else{
+			while(pos < sql.size() && wordChar(sql[pos])){pos++;}
+		}
+		out = sql.substr(start, pos - start);
+		return pos > start;
+	}
+
+	bool literal(SeedValue &value){
+		skipSpace();
+		if(pos >= sql.size()){return false;}
+		char c = sql[pos];
+		if(c == '\''){
+			value.type = SQLITE_TEXT;
+			for(pos++; pos < sql.size(); pos++){
+				if(sql[pos] == '\''){
+					if(pos + 1 < sql.size() && sql[pos + 1] == '\''){pos++;}
+					else{
+						pos++;
+						return true;
+					}
+				}
+				value.text += sql[pos];
+			}
+			return false; //Unterminated string
+		}
+		if(keyword("NULL")){
+			value.type = SQLITE_NULL;
+			return true;
+		}
+
+		size_t start = pos;
+		if(c == '-' || c == '+'){pos++;}
+		bool real = false, digits = false;
+		while(pos < sql.size()){
+			char d = sql[pos];
+			if(std::isdigit(static_cast<unsigned char>(d))){digits = true;}
+			else if(d == '.'){real = true;}
+			else if((d == 'e' || d == 'E') && digits){
+				real = true;
+				if(pos + 1 < sql.size() && (sql[pos + 1] == '-' || sql[pos + 1] == '+')){pos++;}
+			}
+			else{break;}
+			pos++;
+		}
+		if(!digits || (pos < sql.size() && wordChar(sql[pos]))){return false;}
+		std::string number(sql.substr(start, pos - start));
+		if(!real){
+			errno = 0;
+			value.integer = std::strtoll(number.c_str(), NULL, 10);
+			if(errno != ERANGE){
+				value.type = SQLITE_INTEGER;
+				return true;
+			}
+		}
+		value.type = SQLITE_FLOAT; //Like SQLite, integers too big for 64 bits become reals
+		value.real = std::strtod(number.c_str(), NULL);
+		return true;
+	}
+};
+
+//Orders values the way SQLite does: NULL, then numbers, then text by bytes
+static int compareValues(const SeedValue &a, const SeedValue &b){
+	auto rank = [](const SeedValue &value){return value.type == SQLITE_NULL ? 0 : value.type == SQLITE_TEXT ? 2 : 1;};
+	if(rank(a) != rank(b)){return rank(a) - rank(b);}
+	if(a.type == SQLITE_INTEGER && b.type == SQLITE_INTEGER){return a.integer < b.integer ? -1 : a.integer > b.integer;}
+	if(rank(a) == 1){
+		double x = a.type == SQLITE_INTEGER ? a.integer : a.real, y = b.type == SQLITE_INTEGER ? b.integer : b.real;
+		return x < y ? -1 : x > y;
+	}
+	return a.text.compare(b.text);
+}
+
+//The primary key columns of every table, lowercase, in key order
+typedef std::map<std::string, std::vector<std::string>> PrimaryKeys;
+
+static int readPrimaryKeys(sqlite3 *db, PrimaryKeys &keys, OpResult &result){
+	sqlite3_stmt *res;
+	const char *query = "SELECT m.name, p.name FROM sqlite_schema m JOIN pragma_table_info(m.name) p WHERE m.type = 'table' AND p.pk > 0 ORDER BY m.name, p.pk";
+	int rc = sqlite3_prepare_v2(db, query, -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error reading primary keys");}
+	while((rc = sqlite3_step(res)) == SQLITE_ROW){
+		keys[lowercase(reinterpret_cast<const char *>(sqlite3_column_text(res, 0)))].push_back(lowercase(reinterpret_cast<const char *>(sqlite3_column_text(res, 1))));
+	}
+	if(rc != SQLITE_DONE){return fail(result, db, res, "Error reading primary keys");}
+	sqlite3_finalize(res);
+	return SQLITE_OK;
+}
+
+//Where each primary key column is in an INSERT's column list. Left empty if any key column is missing, which leaves SQLite to assign rowids in file order
+static std::vector<int> keyPositions(const PrimaryKeys &keys, const std::string &table, const std::vector<std::string> &columns){
+	std::vector<int> positions;
+	auto found = keys.find(table);
+	if(found == keys.end()){return positions;}
+	for(const std::string &keyColumn : found->second){
+		auto column = std::find_if(columns.begin(), columns.end(), [&](const std::string &name){return lowercase(name) == keyColumn;});
+		if(column == columns.end()){return {};}
+		positions.push_back(column - columns.begin());
+	}
+	return positions;
+}
+
+static bool keyLess(const std::vector<int> &key, const SeedRow &a, const SeedRow &b){
+	for(int column : key){
+		int order = compareValues(a[column], b[column]);
+		if(order != 0){return order < 0;}
+	}
+	return false;
+}
+
+//Parses one thread's range of seed statements and sorts each of its runs by primary key. Stable sorts keep rows with equal keys in file order, so the
+//duplicate that SQLite rejects is the same one it would have rejected running the file
+static void parseSeed(const std::vector<std::string_view> &statements, const PrimaryKeys &keys, ParsePart &part){
+	size_t segment = 0; //Until this thread meets a statement run as written, its rows belong to whichever segment the previous thread ended in
+	for(size_t i = part.firstStatement; i < part.lastStatement; i++){
+		std::string table;
+		std::vector<std::string> columns;
+		std::vector<SeedRow> rows;
+		if(!SeedParser(statements[i]).parseInsert(table, columns, rows)){
+			part.unparsed.push_back(i);
+			segment = i + 1;
+			continue;
+		}
+		std::string joined;
+		for(const std::string &column : columns){joined += (joined.empty() ? "" : ", ") + column;}
+		std::string tableKey = lowercase(table[0] == '"' ? table.substr(1, table.size() - 2) : table);
+		SeedRun &run = part.runs[{segment, tableKey + '\n' + lowercase(joined)}];
+		if(run.table.empty()){
+			run.table = table;
+			run.columns = joined;
+			run.segment = segment;
+			run.firstStatement = i;
+			run.key = keyPositions(keys, tableKey, columns);
+		}
+		part.rows += rows.size();
+		std::move(rows.begin(), rows.end(), std::back_inserter(run.rows));
+	}
+	for(auto &[name, run] : part.runs){
+		if(!run.key.empty()){
+			std::stable_sort(run.rows.begin(), run.rows.end(), [&](const SeedRow &a, const SeedRow &b){return keyLess(run.key, a, b);});
+		}
+	}
+}
+
+//Merges the parts of each run, in thread order, into one run sorted by primary key. Returns the runs in load order
+static std::vector<SeedRun> mergeRuns(std::vector<ParsePart> &parts){
+	SeedRuns merged;
+	size_t segment = 0; //The segment the previous thread ended in
+	for(ParsePart &part : parts){
+		for(auto &[name, run] : part.runs){
+			if(run.segment == 0){run.segment = segment;}
+			auto found = merged.find({run.segment, name.second});
+			if(found == merged.end()){
+				merged.emplace(std::make_pair(run.segment, name.second), std::move(run));
+				continue;
+			}
+			SeedRun &into = found->second;
+			size_t middle = into.rows.size();
+			std::move(run.rows.begin(), run.rows.end(), std::back_inserter(into.rows));
+			if(!into.key.empty()){
+				std::inplace_merge(into.rows.begin(), into.rows.begin() + middle, into.rows.end(), [&](const SeedRow &a, const SeedRow &b){return keyLess(into.key, a, b);});
+			}
+		}
+		part.runs.clear();
+		if(!part.unparsed.empty()){segment = part.unparsed.back() + 1;}
+	}
+	std::vector<SeedRun> runs;
+	for(auto &[name, run] : merged){runs.push_back(std::move(run));}
+	std::sort(runs.begin(), runs.end(), [](const SeedRun &a, const SeedRun &b){return a.firstStatement < b.firstStatement;}); //Also orders the segments
+	return runs;
+}
+
+static int bindValue(sqlite3_stmt *res, int index, const SeedValue &value){
+	switch(value.type){
+	case SQLITE_INTEGER: return sqlite3_bind_int64(res, index, value.integer);
+	case SQLITE_FLOAT: return sqlite3_bind_double(res, index, value.real);
+	case SQLITE_TEXT: return sqlite3_bind_text(res, index, value.text.data(), value.text.size(), SQLITE_STATIC);
+	default: return sqlite3_bind_null(res, index);
+	}
+}
+
+//Inserts a run in order, committing every batchRows rows
+static int loadRun(sqlite3 *db, const SeedRun &run, int batchRows, BootstrapResult &result){
+	std::string query = "INSERT INTO " + run.table + " (" + run.columns + ") VALUES (";
+	for(size_t i = 0; i < run.rows[0].size(); i++){query += i == 0 ? "?" : ", ?";}
+	query += ")";
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error preparing load of " + run.table);}
+
+	rc = startTransaction(db);
+	for(size_t i = 0; rc == SQLITE_OK && i < run.rows.size(); i++){
+		const SeedRow &row = run.rows[i];
+		for(size_t column = 0; rc == SQLITE_OK && column < row.size(); column++){rc = bindValue(res, column + 1, row[column]);}
+		if(rc == SQLITE_OK){rc = sqlite3_step(res) == SQLITE_DONE ? SQLITE_OK : sqlite3_errcode(db);}
+		sqlite3_reset(res);
+		if(rc == SQLITE_OK && (i + 1) % batchRows == 0){
+			rc = commit(db);
+			if(rc == SQLITE_OK){rc = startTransaction(db);}
+		}
+	}
+	if(rc == SQLITE_OK){rc = commit(db);}
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error loading " + run.table);
+		rollback(db);
+		return -1;
+	}
+	sqlite3_finalize(res);
+	result.rowsLoaded += run.rows.size();
+	return SQLITE_OK;
+}
+
+//The first words of a statement in upper case, for telling CREATE INDEX and PRAGMA user_version apart from the rest of tables.sql
+static std::string leadingWords(std::string_view statement, int count){
+	std::string words;
+	size_t i = 0;
+	for(int word = 0; word < count; word++){
+		while(i < statement.size() && std::isspace(static_cast<unsigned char>(statement[i]))){i++;}
+		if(word > 0){words += ' ';}
+		while(i < statement.size() && (std::isalnum(static_cast<unsigned char>(statement[i])) || statement[i] == '_')){
+			words += std::toupper(static_cast<unsigned char>(statement[i++]));
+		}
+	}
+	return words;
+}
+
+static int runStatement(sqlite3 *db, std::string_view statement, OpResult &result){
+	std::string sql(statement);
+	if(sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK){return fail(result, db, NULL, "Error running " + sql.substr(0, 80));}
+	return SQLITE_OK;
+}
+
+//Everything after the database is opened. Returns SQLITE_OK or -1 with the error in result
+static int bootstrap(sqlite3 *db, const BootstrapRequest &request, BootstrapResult &result){
+	Stopwatch::time_point start = Stopwatch::now();
+
+	//Schema: the tables now, the indexes and the schema version once the data is in
+	std::string tables, seed;
+	if(!readFile(request.tablesPath, tables)){return fail(result, "Cannot read " + request.tablesPath);}
+	std::vector<std::string_view> deferred;
+	sqlite3_int64 created = 0;
+	for(std::string_view statement : splitStatements(tables)){
+		std::string words = leadingWords(statement, 3);
+		if(words.compare(0, 12, "CREATE INDEX") == 0 || words.compare(0, 19, "CREATE UNIQUE INDEX") == 0 || words.compare(0, 19, "PRAGMA USER_VERSION") == 0){
+			deferred.push_back(statement);
+			continue;
+		}
+		if(runStatement(db, statement, result) != SQLITE_OK){return -1;}
+		created++;
+	}
+	PrimaryKeys keys;
+	if(readPrimaryKeys(db, keys, result) != SQLITE_OK){return -1;}
+	addPhase(result, "schema", lap(start), created, 0);
+
+	//Parse: contiguous ranges of about the same number of bytes per thread
+	if(!readFile(request.seedPath, seed)){return fail(result, "Cannot read " + request.seedPath);}
+	std::vector<std::string_view> statements = splitStatements(seed);
+	size_t threads = request.threads > 0 ? request.threads : std::thread::hardware_concurrency();
+	threads = std::max<size_t>(1, std::min(threads, statements.size()));
+	result.threads = threads;
+	std::vector<ParsePart> parts(threads);
+	size_t next = 0;
+	for(size_t t = 0; t < threads; t++){
+		size_t bytes = 0, share = seed.size() / threads;
+		parts[t].firstStatement = next;
+		while(next < statements.size() && (t == threads - 1 || bytes < share)){bytes += statements[next++].size();}
+		parts[t].lastStatement = next;
+	}
+	if(threads == 1){parseSeed(statements, keys, parts[0]);}
+	else{
+		std::vector<std::thread> workers;
+		for(ParsePart &part : parts){
+			workers.emplace_back(parseSeed, std::cref(statements), std::cref(keys), std::ref(part));
+		}
+		for(std::thread &worker : workers){worker.join();}
+	}
+	sqlite3_int64 parsedRows = 0;
+	std::vector<size_t> unparsed;
+	for(const ParsePart &part : parts){
+		parsedRows += part.rows;
+		unparsed.insert(unparsed.end(), part.unparsed.begin(), part.unparsed.end());
+	}
+	addPhase(result, "parse", lap(start), statements.size() - unparsed.size(), parsedRows);
+
+	std::vector<SeedRun> runs = mergeRuns(parts);
+	addPhase(result, "merge", lap(start), 0, parsedRows);
+
+	//Load each segment, then run the statement the parser did not take (such as an UPDATE over the rows already loaded) that ends it
+	double loadSeconds = 0, statementSeconds = 0;
+	size_t nextRun = 0;
+	for(size_t segment = 0; segment <= unparsed.size(); segment++){
+		size_t end = segment < unparsed.size() ? unparsed[segment] + 1 : 0;
+		for(; nextRun < runs.size() && (end == 0 || runs[nextRun].segment < end); nextRun++){
+			if(loadRun(db, runs[nextRun], request.batchRows, result) != SQLITE_OK){return -1;}
+		}
+		loadSeconds += lap(start);
+		if(end == 0){break;}
+		if(runStatement(db, statements[end - 1], result) != SQLITE_OK){return -1;}
+		result.statementsRun++;
+		statementSeconds += lap(start);
+	}
+	addPhase(result, "load", loadSeconds, runs.size(), result.rowsLoaded);
+	addPhase(result, "statements", statementSeconds, result.statementsRun, 0);
+
+	for(std::string_view statement : deferred){
+		if(runStatement(db, statement, result) != SQLITE_OK){return -1;}
+	}
+	addPhase(result, "indexes", lap(start), deferred.size(), 0);
+	return SQLITE_OK;
+}
+
+BootstrapResult bootstrapDatabase(const BootstrapRequest &request){
+	BootstrapResult result;
+	if(request.batchRows < 1){
+		fail(result, "Batch size must be at least 1 row");
+		return result;
+	}
+	if(std::ifstream(request.path)){
+		fail(result, request.path + " already exists. Bootstrap only creates new databases");
+		return result;
+	}
+
+	sqlite3 *db;
+	int rc = sqlite3_open_v2(request.path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+	if(rc == SQLITE_OK){
+		//Nothing else can be using a file that did not exist, and a failed bootstrap is deleted, so there is nothing for a journal to protect
+		rc = sqlite3_exec(db, "PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF;", NULL, NULL, NULL);
+	}
+	if(rc != SQLITE_OK){fail(result, db, NULL, "Error creating " + request.path);}
+	else{bootstrap(db, request, result);}
+	sqlite3_close(db);
+	if(!result.ok()){std::remove(request.path.c_str());}
+	return result;
+}
+
+//Report fields
+const ReportField BOOTSTRAP_REPORT = {"Bootstrap", "bootstrap"};
+const ReportField DATABASE = {"Database", "database"};
+const ReportField THREADS = {"Parser Threads", "threads"};
+const ReportField ROWS_LOADED = {"Rows Loaded", "rows_loaded"};
+const ReportField STATEMENTS_RUN = {"Seed Statements Run As Written", "statements_run"};
+const ReportField PHASES = {"Phases", "phases"};
+const ReportField PHASE = {"Phase", "phase"};
+const ReportField SECONDS = {"Seconds", "seconds"};
+const ReportField STATEMENTS = {"Statements", "statements"};
+const ReportField ROWS = {"Rows", "rows"};
+const ReportField TOTAL_SECONDS = {"Total Seconds", "total_seconds"};
+
+void writeBootstrapReport(const BootstrapRequest &request, const BootstrapResult &result, ReportRenderer &out){
+	double total = 0;
+	out.beginReport(BOOTSTRAP_REPORT);
+	out.field(DATABASE, request.path);
+	out.field(THREADS, result.threads);
+	out.field(ROWS_LOADED, result.rowsLoaded);
+	out.field(STATEMENTS_RUN, result.statementsRun);
+	out.beginRows(PHASES);
+	for(const BootstrapPhase &phase : result.phases){
+		out.beginRow();
+		out.field(PHASE, phase.name);
+		out.decimalField(SECONDS, phase.seconds);
+		out.field(STATEMENTS, phase.statements);
+		out.field(ROWS, phase.rows);
+		out.endRow();
+		total += phase.seconds;
+	}
+	out.endRows();
+	out.decimalField(TOTAL_SECONDS, total);
+	out.endReport();
+}
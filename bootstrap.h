@@ -0,0 +1,43 @@
+/* Program name: bootstrap.h
+* Purpose: Declares the bootstrap job, which provisions a new database from tables.sql and inserts.sql much faster than running the two files statement by
+*  statement. Tables are created first and their indexes are left until the data is in. The seed INSERTs are parsed on several threads into one sorted
+*  run per table and thread, and the runs are merged and loaded in primary key order in large transactions. Each phase is timed.
+*/
+
+#ifndef BOOTSTRAP_H
+#define BOOTSTRAP_H
+
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct BootstrapRequest{
+	std::string path; //The database to create. It must not exist yet
+	std::string tablesPath = "tables.sql";
+	std::string seedPath = "inserts.sql";
+	int threads = 0; //Parser threads. 0 uses one per hardware thread
+	int batchRows = 100000; //Rows per load transaction
+};
+
+struct BootstrapPhase{
+	std::string name;
+	double seconds = 0;
+	sqlite3_int64 statements = 0, rows = 0; //Statements run and rows parsed or loaded in this phase
+};
+
+struct BootstrapResult : OpResult{
+	std::vector<BootstrapPhase> phases; //In the order they ran
+	sqlite3_int64 rowsLoaded = 0; //Rows inserted from parsed VALUES lists
+	sqlite3_int64 statementsRun = 0; //Seed statements that could not be parsed and were run as written
+	int threads = 0;
+};
+
+//Creates and fills the database. If anything fails the partly built file is removed. Seed INSERTs of the form INSERT INTO table (columns) VALUES (...), ...
+//with literal values are bulk loaded; every other seed statement is run as written, after the rows before it in the file are loaded and before any after it
+BootstrapResult bootstrapDatabase(const BootstrapRequest &);
+
+void writeBootstrapReport(const BootstrapRequest &, const BootstrapResult &, ReportRenderer &);
+
+#endif
@@ -0,0 +1,530 @@
+/* Program name: clerk.cpp
+* Purpose: The PokeMart menu as a clerk session. Each menu flow is a coroutine that prompts on the terminal's screen and co_awaits the clerk's answers,
+*  so the flows read like the blocking menu they replaced while a waiting clerk holds no thread. Input is validated the way the menu validated std::cin:
+*  a word that is not a number is rejected and the rest of its line dropped, and the prompt's error message is repeated until the answer is valid.
+*/
+
+#include <charconv>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "clerk.h"
+#include "pokemart.h"
+#include "report.h"
+
+//Insert related flows
+static SessionTask<> insertIntoTable(sqlite3 *, ClerkTerminal &);
+static SessionTask<> addTrainerCard(sqlite3 *, ClerkTerminal &);
+static SessionTask<> addEmployee(sqlite3 *, ClerkTerminal &);
+
+//Update related flows
+static SessionTask<int> selectPerson(sqlite3 *, ClerkTerminal &, PersonTable, std::string);
+static SessionTask<> updateTable(sqlite3 *, ClerkTerminal &);
+static SessionTask<> updateTrainerCard(sqlite3 *, ClerkTerminal &);
+static SessionTask<> updateEmployee(sqlite3 *, ClerkTerminal &);
+
+//Delete related flows
+static SessionTask<> deleteFromTable(sqlite3 *, ClerkTerminal &);
+static SessionTask<> deleteTrainerCard(sqlite3 *, ClerkTerminal &);
+static SessionTask<> deleteEmployee(sqlite3 *, ClerkTerminal &);
+
+//Transaction related
+static SessionTask<int> selectPokemart(sqlite3 *, ClerkTerminal &);
+static SessionTask<> makeSale(sqlite3 *, ClerkTerminal &, StockCounters *);
+static SessionTask<int> selectProduct(sqlite3 *, ClerkTerminal &, int, SaleRequest &);
+
+//User reports
+static SessionTask<> viewInvoice(sqlite3 *, ClerkTerminal &);
+static SessionTask<> viewCertificates(sqlite3 *, ClerkTerminal &);
+
+//Input helpers
+static SessionTask<int> mainMenuChoice(ClerkTerminal &);
+static SessionTask<int> selectRow(ClerkTerminal &, const PickerResult &, std::string, std::string);
+static SessionTask<int> getMenuChoice(ClerkTerminal &, int, int, std::string);
+static SessionTask<std::string> getPhone(ClerkTerminal &, std::string);
+
+//Reads a number. A word that is not one gives nullopt and the rest of its line is dropped
+template<typename T>
+static SessionTask<std::optional<T>> readNumber(ClerkTerminal &terminal){
+	std::string word = co_await terminal.word();
+	T value;
+	const char *end = word.data() + word.size();
+	std::from_chars_result parsed = std::from_chars(word.data(), end, value);
+	if(parsed.ec != std::errc() || parsed.ptr != end){
+		terminal.discardLine();
+		co_return std::nullopt;
+	}
+	co_return value;
+}
+
+SessionTask<> clerkSession(sqlite3 *db, ClerkTerminal &terminal, StockCounters *counters){
+	terminal.out << "Welcome to PokeMart Database" << '\n'; //Welcome message
+
+	//Quits if the clerk inputs the QUIT constant into the main menu selection
+	for(int choice = co_await mainMenuChoice(terminal); choice != QUIT; choice = co_await mainMenuChoice(terminal)){
+		switch(choice){
+		case 1:	co_await insertIntoTable(db, terminal); break;
+		case 2:	co_await updateTable(db, terminal); break;
+		case 3:	co_await deleteFromTable(db, terminal); break;
+		case 4:	co_await makeSale(db, terminal, counters); break;
+		case 5: co_await viewInvoice(db, terminal); break;
+		case 6:	co_await viewCertificates(db, terminal); break;
+		}
+	}
+}
+
+//Prints the main menu and returns the clerk's valid choice
+static SessionTask<int> mainMenuChoice(ClerkTerminal &terminal){
+	std::ostream &out = terminal.out;
+	out << "Please select an option (enter -1 to quit): " << '\n';
+	out << "1. Add to a table" << '\n';
+	out << "2. Update a table" << '\n';
+	out << "3. Delete from a table" << '\n';
+	out << "4. Make a sale" << '\n';
+	out << "5. View invoice" << '\n'; //One of the user report options. Joins invoice, line, pokemart, and employee, trainer_card, and product tables
+	out << "6. View certificate records" << '\n'; //One of the user report options. Join certification, employee, and certification_history
+
+	std::optional<int> choice = co_await readNumber<int>(terminal);
+	while(!choice || *choice > 6 || (*choice < 1 && *choice != QUIT)){
+		out << "Invalid menu option selected. Please select an option from the menu." << '\n';
+		choice = co_await readNumber<int>(terminal);
+	}
+	co_return *choice;
+}
+
+//This flow selects which table to insert into
+static SessionTask<> insertIntoTable(sqlite3 *db, ClerkTerminal &terminal){
+	std::ostream &out = terminal.out;
+	out << "Please choose a table addition to perform:" << '\n';
+	out << "1. Add to trainer_card" << '\n';
+	out << "2. Add to employee" << '\n';
+	out << "3. Return to main menu" << '\n';
+	int choice = co_await getMenuChoice(terminal, 1, 3, "Invalid menu option selected. Please select an option from the menu.");
+
+	switch(choice){
+	case 1:	co_await addTrainerCard(db, terminal); break;
+	case 2:	co_await addEmployee(db, terminal); break;
+	}
+}
+
+//Get information about a new trainer card and insert it into the trainer_card table
+static SessionTask<> addTrainerCard(sqlite3 *db, ClerkTerminal &terminal){
+	std::ostream &out = terminal.out;
+	CreateTrainerRequest request; //Holds the trainer card info
+
+	out << "Enter the first name of trainer to add: ";
+	request.fname = co_await terminal.word();
+	out << "Enter " << request.fname << "'s last name: ";
+	request.lname = co_await terminal.word();
+	out << "Enter " << request.fname << "'s badge level (0 - " << MAX_BADGES << "):" << '\n';
+	std::optional<int> badgeLevel = co_await readNumber<int>(terminal);
+	while(!badgeLevel || !validBadgeLevel(*badgeLevel)){ //Verify badge level input is between 0 and the max amount of badges you can have
+		out << "Invalid badge count entered. Valid badges counts are between 0 and " << MAX_BADGES << ". Please try again." << '\n';
+		badgeLevel = co_await readNumber<int>(terminal);
+	}
+	request.badgeLevel = *badgeLevel;
+	out << "Enter " << request.fname << "'s phone number (###-####):" << '\n';
+	request.phone = co_await getPhone(terminal, "Invalid phone number entered. Please enter the phone number as ###-#### (ex. 123-4567):");
+
+	//Print out the entered info to verify the information is correct before INSERTING
+	out << "Is this information correct?" << '\n';
+	out << "Name: " << request.fname << " " << request.lname << '\n';
+	out << "Phone: " << request.phone << '\n';
+	out << "Badge Count: " << request.badgeLevel << '\n';
+	out << "1. Yes" << '\n';
+	out << "2. No" << '\n';
+	int choice = co_await getMenuChoice(terminal, 1, 2, "Invalid entry. Please try again.");
+
+	if(choice == 2){
+		out << "Cancelling trainer_card insert" << '\n';
+		out << '\n';
+		co_return;
+	}
+
+	CreateTrainerResult result = createTrainer(db, request);
+	if(!result.ok()){
+		out << result.error << '\n';
+		co_return;
+	}
+	out << "Successfully inserted into trainer_card" << '\n';
+	out << '\n';
+}
+
+//Get information about a new employee to insert into the employee table
+static SessionTask<> addEmployee(sqlite3 *db, ClerkTerminal &terminal){
+	std::ostream &out = terminal.out;
+	CreateEmployeeRequest request; //Holds the employee info
+
+	out << "Enter the first name of employee to add: ";
+	request.fname = co_await terminal.word();
+	out << "Enter " << request.fname << "'s last name: ";
+	request.lname = co_await terminal.word();
+	out << "Enter " << request.fname << "'s phone number (###-####):" << '\n';
+	request.phone = co_await getPhone(terminal, "Invalid phone number entered. Please enter the phone number as ###-#### (ex. 123-4567):");
+
+	//Ask the clerk to verify the information is correct before inserting
+	out << "Is this information correct?" << '\n';
+	out << "Name: " << request.fname << " " << request.lname << '\n';
+	out << "Phone: " << request.phone << '\n';
+	out << "1. Yes" << '\n';
+	out << "2. No" << '\n';
+	int choice = co_await getMenuChoice(terminal, 1, 2, "Invalid entry. Please try again.");
+
+	if(choice == 2){ //If information is not correct, cancel the insert and return to main menu
+		out << "Cancelling employee insert" << '\n';
+		out << '\n';
+		co_return;
+	}
+
+	CreateEmployeeResult result = createEmployee(db, request);
+	if(!result.ok()){
+		out << result.error << '\n';
+		co_return;
+	}
+	out << "Successfully inserted into employee" << '\n';
+}
+
+//Prints a menu of trainer cards or employees and returns the id of the one the clerk picks, or -1 if there are none
+static SessionTask<int> selectPerson(sqlite3 *db, ClerkTerminal &terminal, PersonTable table, std::string context){
+	std::string tableName = table == PersonTable::TRAINER_CARD ? "trainer_card" : "employee";
+	PickerResult people = listPeople(db, table);
+	if(people.ok() && people.rows.empty()){
+		terminal.out << "No " << tableName << "s to select. " << tableName << " requires at least one record for this action. Try to insert a new record into " << tableName << " first." << '\n';
+		co_return -1;
+	}
+	co_return co_await selectRow(terminal, people, "Select the " + tableName + " for the " + context + ": ", tableName);
+}
+
+//This flow selects a table to update
+static SessionTask<> updateTable(sqlite3 *db, ClerkTerminal &terminal){
+	std::ostream &out = terminal.out;
+	out << "Please select a table update to perform:" << '\n';
+	out << "1. trainer_card" << '\n';
+	out << "2. employee" << '\n';
+	out << "3. Return to main menu" << '\n';
+	int choice = co_await getMenuChoice(terminal, 1, 3, "Invalid entry. Please select an option from the menu:");
+
+	switch(choice){
+	case 1: co_await updateTrainerCard(db, terminal); break;
+	case 2: co_await updateEmployee(db, terminal); break;
+	}
+}
+
+//This flow selects the attribute from trainer_card to update, then attempts the update on that attribute with a value provided by the clerk
+static SessionTask<> updateTrainerCard(sqlite3 *db, ClerkTerminal &terminal){
+	std::ostream &out = terminal.out;
+	UpdateTrainerRequest request;
+	request.trainerID = co_await selectPerson(db, terminal, PersonTable::TRAINER_CARD, "update");
+	if(request.trainerID == -1){co_return;}
+
+	out << "Select the attribute to update:" << '\n';
+	out << "1. Balance" << '\n';
+	out << "2. Badge Count" << '\n';
+	out << "3. Phone Number" << '\n';
+	out << "4. Return to main menu" << '\n';
+	int choice = co_await getMenuChoice(terminal, 1, 4, "Invalid entry. Please try again.");
+
+	if(choice == 4){co_return;} //Return if the clerk selects return to main menu
+
+	//Get the new value for the chosen attribute
+	std::string updated;
+	switch(choice){
+	case 1:{ //Update the trainer balance
+		request.field = TrainerField::BALANCE;
+		out << "Enter the new balance" << '\n';
+		std::optional<double> balance = co_await readNumber<double>(terminal);
+		while(!balance || *balance < 0){
+			out << "Invalid balance entered. Please try again." << '\n';
+			balance = co_await readNumber<double>(terminal);
+		}
+		request.balance = *balance;
+		updated = "balance";
+		break;
+	}
+
+	case 2:{ //Update the badge count (badge level)
+		request.field = TrainerField::BADGE_LEVEL;
+		out << "Enter the new badge count (0 - " << MAX_BADGES << ")" << '\n';
+		std::optional<int> badgeLevel = co_await readNumber<int>(terminal);
+		while(!badgeLevel || !validBadgeLevel(*badgeLevel)){
+			out << "Invalid badge count entered. Please try again (0 - " << MAX_BADGES << ")." << '\n';
+			badgeLevel = co_await readNumber<int>(terminal);
+		}
+		request.badgeLevel = *badgeLevel;
+		updated = "badge count";
+		break;
+	}
+
+	case 3: //Update the phone number
+		request.field = TrainerField::PHONE;
+		out << "Enter the phone number (###-####)" << '\n';
+		request.phone = co_await getPhone(terminal, "Invalid phone number entered. Please try again (Please use this format ###-#### ex. 123-4567)");
+		updated = "phone number";
+		break;
+	}
+
+	OpResult result = updateTrainer(db, request);
+	if(!result.ok()){
+		out << result.error << '\n';
+		co_return;
+	}
+	out << "Updated " << updated << " for trainer " << request.trainerID << '\n';
+	out << '\n'; //Add an extra newline before the main menu
+}
+
+//This flow updates the phone number of an employee the clerk selects
+static SessionTask<> updateEmployee(sqlite3 *db, ClerkTerminal &terminal){
+	std::ostream &out = terminal.out;
+	UpdateEmployeeRequest request;
+	request.empID = co_await selectPerson(db, terminal, PersonTable::EMPLOYEE, "update");
+	if(request.empID == -1){co_return;}
+
+	out << "Enter the new phone number (###-####):" << '\n';
+	request.phone = co_await getPhone(terminal, "Invalid phone number entered. Please try again (Please use this format ###-#### ex. 123-4567)");
+
+	OpResult result = updateEmployee(db, request);
+	if(!result.ok()){
+		out << result.error << '\n';
+		co_return;
+	}
+	out << "Employee phone number updated" << '\n';
+	out << '\n'; //Add extra newline before the main menu
+}
+
+//This flow selects which table to delete from
+static SessionTask<> deleteFromTable(sqlite3 *db, ClerkTerminal &terminal){
+	std::ostream &out = terminal.out;
+	out << "Select which table to delete from:" << '\n';
+	out << "1. trainer_card" << '\n';
+	out << "2. employee" << '\n';
+	out << "3. Return to main menu" << '\n';
+	int choice = co_await getMenuChoice(terminal, 1, 3, "Invalid entry. Please try again.");
+
+	switch(choice){
+	case 1: co_await deleteTrainerCard(db, terminal); break;
+	case 2: co_await deleteEmployee(db, terminal); break;
+	}
+}
+
+static SessionTask<> deleteTrainerCard(sqlite3 *db, ClerkTerminal &terminal){
+	DeleteTrainerRequest request;
+	request.trainerID = co_await selectPerson(db, terminal, PersonTable::TRAINER_CARD, "delete"); //Get id of trainer to delete
+	if(request.trainerID == -1){co_return;}
+
+	DeleteResult result = deleteTrainer(db, request);
+	if(!result.ok()){
+		terminal.out << result.error << '\n';
+		co_return;
+	}
+	if(result.retired){terminal.out << "Trainer card ID " << request.trainerID << " still has invoices or ledger entries, so it was retired instead of deleted" << '\n';}
+	else{terminal.out << "Deleted trainer card ID " << request.trainerID << '\n';}
+	terminal.out << '\n';
+}
+
+static SessionTask<> deleteEmployee(sqlite3 *db, ClerkTerminal &terminal){
+	DeleteEmployeeRequest request;
+	request.empID = co_await selectPerson(db, terminal, PersonTable::EMPLOYEE, "delete"); //Get id of employee to delete
+	if(request.empID == -1){co_return;}
+
+	DeleteResult result = deleteEmployee(db, request);
+	if(!result.ok()){
+		terminal.out << result.error << '\n';
+		co_return;
+	}
+	if(result.retired){terminal.out << "Employee ID " << request.empID << " still has invoices, shifts or certification records, so it was retired instead of deleted" << '\n';}
+	else{terminal.out << "Deleted employee ID " << request.empID << '\n';}
+	terminal.out << '\n';
+}
+
+static SessionTask<int> selectPokemart(sqlite3 *db, ClerkTerminal &terminal){
+	PickerResult marts = listPokemarts(db);
+	if(marts.ok() && marts.rows.empty()){
+		terminal.out << "No PokeMarts to select. PokeMart requires at least one record for this action." << '\n';
+		co_return -1;
+	}
+	co_return co_await selectRow(terminal, marts, "Select the PokeMart for the invoice: ", "PokeMart");
+}
+
+//This flow builds a basket of products for a sale, then hands it to recordSale which inserts the invoice and its lines and updates trainer_card,
+//mart_balance_history and stock_history in one transaction. Nothing is written until the basket is complete, so a clerk who disconnects halfway
+//leaves no trace
+static SessionTask<> makeSale(sqlite3 *db, ClerkTerminal &terminal, StockCounters *counters){
+	std::ostream &out = terminal.out;
+	SaleRequest request;
+
+	//Attempt to get the attributes for the new invoice, return if unsuccessful with any
+	request.trainerID = co_await selectPerson(db, terminal, PersonTable::TRAINER_CARD, "invoice");
+	if(request.trainerID == -1){
+		out << "Cancelling sale" << '\n';
+		co_return;
+	}
+	request.empID = co_await selectPerson(db, terminal, PersonTable::EMPLOYEE, "invoice");
+	if(request.empID == -1){
+		out << "Cancelling sale" << '\n';
+		co_return;
+	}
+	request.martID = co_await selectPokemart(db, terminal);
+	if(request.martID == -1){
+		out << "Cancelling sale" << '\n';
+		co_return;
+	}
+
+	int choice; //Whether to keep adding new lines
+	do{
+		int rc = co_await selectProduct(db, terminal, request.martID, request); //Attempt to add a new line by selecting a product and the quantity to purchase
+		if(rc == SQLITE_DONE){break;} //Ring up the lines already in the basket
+		if(rc != SQLITE_OK){
+			out << "Cancelling sale" << '\n';
+			co_return;
+		}
+
+		out << "Would you like to add more items to the invoice?" << '\n';
+		out << "1. Yes" << '\n';
+		out << "2. No" << '\n';
+		choice = co_await getMenuChoice(terminal, 1, 2, "Invalid entry. Please try again.");
+	}while(choice != 2);
+
+	SaleResult result = counters != NULL ? recordSale(db, request, *counters) : recordSale(db, request); //Record the whole basket and return to main menu
+	if(!result.ok()){
+		out << result.error << '\n';
+		out << "Cancelling sale" << '\n';
+		co_return;
+	}
+	for(const SaleLineResult &line : result.lines){
+		if(line.reorderQty > 0){
+			out << line.prodName << " went below it's minimum stock quantity. Made order to vendor to replenish the stock." << '\n';
+		}
+	}
+	out << std::fixed << std::setprecision(2);
+	out << "Recorded invoice " << result.invoiceNum << ". Subtotal $" << result.subtotal << " + tax $" << result.tax << " = invoice total $" << result.total << '\n';
+	out << '\n';
+}
+
+//Prints the products stocked at the PokeMart that the trainer has the badges for, then adds the clerk's chosen product and quantity to the basket.
+//Stock already in the basket is not offered again, so a product with none left is not listed. Returns SQLITE_DONE if nothing is left to add to a basket
+//that already has lines
+static SessionTask<int> selectProduct(sqlite3 *db, ClerkTerminal &terminal, int martID, SaleRequest &request){
+	std::ostream &out = terminal.out;
+	ProductListResult result = listProducts(db, {martID, request.trainerID}); //Only what the trainer has the badges for
+	if(!result.ok()){
+		out << result.error << '\n';
+		co_return -1;
+	}
+	if(result.products.empty()){
+		out << "No products to select. The trainer does not have the badges for any product stocked here, or there are no products. Tell the DBA to add products." << '\n';
+		co_return -1;
+	}
+
+	//Take the quantities already in the basket off the listed stock, and drop what has none left
+	for(ProductListing &product : result.products){
+		for(const SaleLine &line : request.basket){
+			if(line.prodCode == product.prodCode){product.stockQty -= line.qty;}
+		}
+	}
+	std::erase_if(result.products, [](const ProductListing &product){return product.stockQty <= 0;});
+	if(result.products.empty()){
+		out << "Nothing left to sell. Every product the trainer can buy here is out of stock or already in the basket." << '\n';
+		co_return request.basket.empty() ? -1 : SQLITE_DONE;
+	}
+
+	out << "Select the product for the current line:" << '\n';
+	out << std::fixed << std::setprecision(2);
+	int count = 0; //Count the products listed
+	for(const ProductListing &product : result.products){
+		count++;
+		out << count << ". " << product.prodName << " - $" << product.unitPrice << " - " << product.stockQty << " in stock" << '\n';
+	}
+	int selected = co_await getMenuChoice(terminal, 1, count, "Invalid selection. Please try again.");
+	const ProductListing &product = result.products[selected - 1];
+
+	out << "Enter the amount of " << product.prodName << "s to be purchased:" << '\n';
+	int purchaseQty = (co_await readNumber<int>(terminal)).value_or(0); //A word that is not a number counts as ordering nothing
+	while(purchaseQty < 1 || purchaseQty > product.stockQty){
+		if(purchaseQty < 1){
+			out << "Invalid entry. You must order at least 1 product at a time. Please try again." << '\n';
+		}
+		if(purchaseQty > product.stockQty){
+			out << "Invalid entry. Cannot order more products than there are in stock (" << product.stockQty << " " << product.prodName << "s in stock). Please try again." << '\n';
+		}
+		purchaseQty = (co_await readNumber<int>(terminal)).value_or(0);
+	}
+
+	request.basket.push_back({product.prodCode, purchaseQty});
+	co_return SQLITE_OK;
+}
+
+static SessionTask<> viewInvoice(sqlite3 *db, ClerkTerminal &terminal){
+	PickerResult invoices = listInvoices(db);
+	if(invoices.ok() && invoices.rows.empty()){
+		terminal.out << "No invoices to select. Invoice requires at least one record for this action. Try to insert a new record into invoice first. By making a sale." << '\n';
+		co_return;
+	}
+	int invoiceID = co_await selectRow(terminal, invoices, "Select the invoice to view: ", "invoice");
+	if(invoiceID == -1){co_return;}
+
+	ReportWriter writer(terminal.out);
+	OpResult result = writeInvoiceReport(db, {invoiceID}, *makeRenderer(ReportFormat::TEXT, writer));
+	writer.flush();
+	if(!result.ok()){
+		terminal.out << result.error << '\n';
+	}
+}
+
+static SessionTask<> viewCertificates(sqlite3 *db, ClerkTerminal &terminal){
+	int empID = co_await selectPerson(db, terminal, PersonTable::EMPLOYEE, "viewing certificate records"); //Get empID of employee to view certificate records on
+	if(empID == -1){
+		terminal.out << "Error selecting an employee to view certificate records" << '\n';
+		co_return;
+	}
+
+	ReportWriter writer(terminal.out);
+	OpResult result = writeCertificationReport(db, {empID}, *makeRenderer(ReportFormat::TEXT, writer));
+	writer.flush();
+	if(!result.ok()){
+		terminal.out << result.error << '\n';
+	}
+}
+
+//Prints a numbered menu of picker rows under prompt and returns the id of the row the clerk selects, or -1 if the rows could not be loaded
+static SessionTask<int> selectRow(ClerkTerminal &terminal, const PickerResult &picker, std::string prompt, std::string context){
+	std::ostream &out = terminal.out;
+	if(!picker.ok()){
+		out << picker.error << '\n';
+		co_return -1;
+	}
+	if(picker.rows.empty()){
+		out << "No " << context << "s to select." << '\n';
+		co_return -1;
+	}
+
+	out << prompt << '\n';
+	int count = 0; //Count the rows printed
+	for(const PickerRow &row : picker.rows){
+		count++;
+		out << count << ". " << row.id << " - " << row.label << '\n';
+	}
+	int selected = co_await getMenuChoice(terminal, 1, count, "Invalid selection. Please try again.");
+	co_return picker.rows[selected - 1].id;
+}
+
+//Reads a menu choice between low and high (inclusive), printing errorMessage until the input is valid
+static SessionTask<int> getMenuChoice(ClerkTerminal &terminal, int low, int high, std::string errorMessage){
+	std::optional<int> choice = co_await readNumber<int>(terminal);
+	while(!choice || *choice < low || *choice > high){
+		terminal.out << errorMessage << '\n';
+		choice = co_await readNumber<int>(terminal);
+	}
+	co_return *choice;
+}
+
+//Reads a phone number, printing errorMessage until it is in the ###-#### format
+static SessionTask<std::string> getPhone(ClerkTerminal &terminal, std::string errorMessage){
+	std::string phone = co_await terminal.word();
+	while(!validPhone(phone)){
+		terminal.out << errorMessage << '\n';
+		phone = co_await terminal.word();
+	}
+	co_return phone;
+}
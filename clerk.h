@@ -0,0 +1,20 @@
+/* Program name: clerk.h
+* Purpose: Declares the clerk session: the PokeMart menu (adding, updating and deleting trainer cards and employees, making a sale, viewing invoices and
+*  certification records) written as a coroutine over a ClerkTerminal (session.h). main runs one session on the console; the clerk server
+*  (clerkserver.h) runs one per connected terminal, many to a thread.
+*/
+
+#ifndef CLERK_H
+#define CLERK_H
+
+#include <sqlite3.h>
+#include "session.h"
+#include "stockcounters.h"
+
+const int QUIT = -1; //The main menu choice that ends a session
+
+//Prints the welcome message and runs the main menu until the clerk quits. db must have its statements prepared and is only used by this session
+//between suspensions, so sessions sharing a thread can share its connection. Sales reserve their stock in counters first if any are given
+SessionTask<> clerkSession(sqlite3 *, ClerkTerminal &, StockCounters * = NULL);
+
+#endif
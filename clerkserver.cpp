@@ -0,0 +1,288 @@
+/* Program name: clerkserver.cpp
+* Purpose: Runs clerk sessions for terminals connected over TCP. Every event loop thread waits on its own epoll set, which holds the shared listening
+*  socket (registered with EPOLLEXCLUSIVE so a new terminal wakes one thread, not all of them) and the sockets of the terminals it accepted. Input is
+*  appended to the terminal and its session resumed on the spot; whatever the session wrote is then sent, and what the socket will not take yet is kept
+*  until it is writable again. A session that finishes is disconnected once its last screen has been sent, and a terminal that disconnects has its
+*  session destroyed wherever it was waiting, which discards a sale that was still being entered.
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "clerkserver.h"
+#include "clerk.h"
+#include "pricing.h"
+#include "slowlog.h"
+#include "walcheckpoint.h"
+#include "pokemart_internal.h"
+
+const int MAX_EVENTS = 64;
+const int WAIT_MS = 200; //How often a waiting thread checks whether the server is stopping
+const size_t READ_SIZE = 4096;
+const size_t MAX_UNREAD = 64 * 1024; //Unread input a terminal may send before it is disconnected
+const size_t MAX_PENDING = 1024 * 1024; //Unsent screen output a terminal may fall behind by before it is disconnected
+
+//One connected terminal and the session it is running
+struct ClerkConnection{
+	ClerkConnection(int fd, sqlite3 *db, StockCounters &counters) : fd(fd), session(clerkSession(db, terminal, &counters)) {}
+	~ClerkConnection(){close(fd);}
+
+	int fd;
+	std::ostringstream screen;
+	ClerkTerminal terminal{screen};
+	SessionTask<> session;
+	std::string pending; //Screen output the socket has not taken yet
+	bool writing = false; //Waiting for the socket to become writable
+};
+
+//State shared by every event loop thread
+struct ClerkServerShared{
+	int listener;
+	const ClerkServerRequest &request;
+	const std::atomic<bool> &stop;
+	std::atomic<int> connected{0};
+	std::atomic<int> peak{0};
+	StockCounters counters{}; //Every register's sales reserve stock here, so two terminals selling the last of a product do not both reach the database
+};
+
+struct ClerkLoop{
+	sqlite3 *db = NULL;
+	sqlite3_int64 sessions = 0;
+	OpResult status;
+};
+
+//Moves what the session wrote to pending and sends as much as the socket takes, watching for writability while anything is left. Returns false if the
+//terminal has to be disconnected
+static bool sendScreen(int epoll, ClerkConnection &connection){
+	std::string written = connection.screen.str();
+	if(!written.empty()){
+		connection.pending += written;
+		connection.screen.str("");
+	}
+	size_t sent = 0;
+	while(sent < connection.pending.size()){
+		ssize_t n = send(connection.fd, connection.pending.data() + sent, connection.pending.size() - sent, MSG_NOSIGNAL);
+		if(n < 0){
+			if(errno == EINTR){continue;}
+			if(errno == EAGAIN || errno == EWOULDBLOCK){break;}
+			return false;
+		}
+		sent += n;
+	}
+	connection.pending.erase(0, sent);
+	if(connection.pending.size() > MAX_PENDING){return false;}
+
+	bool writing = !connection.pending.empty();
+	if(writing != connection.writing){
+		epoll_event event{};
+		event.events = writing ? EPOLLIN | EPOLLOUT : EPOLLIN;
+		event.data.ptr = &connection;
+		epoll_ctl(epoll, EPOLL_CTL_MOD, connection.fd, &event);
+		connection.writing = writing;
+	}
+	return true;
+}
+
+//Reads everything the terminal sent and lets the session act on it. Returns false if the terminal has to be disconnected
+static bool readInput(ClerkConnection &connection){
+	char input[READ_SIZE];
+	while(true){
+		ssize_t n = recv(connection.fd, input, sizeof(input), 0);
+		if(n == 0){return false;}
+		if(n < 0){
+			if(errno == EINTR){continue;}
+			if(errno == EAGAIN || errno == EWOULDBLOCK){break;}
+			return false;
+		}
+		connection.terminal.input(std::string_view(input, n));
+		if(connection.terminal.buffered() > MAX_UNREAD){return false;}
+	}
+	connection.terminal.resume();
+	return true;
+}
+
+//Accepts every terminal waiting on the listener and starts its session on this thread
+static void acceptTerminals(int epoll, ClerkServerShared &shared, ClerkLoop &loop, std::unordered_map<ClerkConnection *, std::unique_ptr<ClerkConnection>> &connections){
+	while(true){
+		int fd = accept4(shared.listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if(fd < 0){
+			if(errno == EINTR || errno == ECONNABORTED){continue;}
+			return; //EAGAIN once the backlog is empty, or another thread took the terminal
+		}
+		if(shared.connected.load() >= shared.request.maxSessions){
+			const char busy[] = "The PokeMart server is busy. Please try again later.\n";
+			send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL);
+			close(fd);
+			continue;
+		}
+
+		std::unique_ptr<ClerkConnection> connection = std::make_unique<ClerkConnection>(fd, loop.db, shared.counters);
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.ptr = connection.get();
+		if(epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0){continue;}
+
+		int connected = ++shared.connected;
+		int peak = shared.peak.load();
+		while(connected > peak && !shared.peak.compare_exchange_weak(peak, connected)){}
+		loop.sessions++;
+
+		connection->session.start(); //Prints the welcome and main menu, then waits for the first choice
+		if(!sendScreen(epoll, *connection)){
+			shared.connected--;
+			continue;
+		}
+		ClerkConnection *key = connection.get();
+		connections.emplace(key, std::move(connection));
+	}
+}
+
+static void runLoop(ClerkServerShared &shared, ClerkLoop &loop){
+	int epoll = epoll_create1(EPOLL_CLOEXEC);
+	if(epoll < 0){
+		fail(loop.status, std::string("Error creating the clerk server event loop: ") + std::strerror(errno));
+		return;
+	}
+	epoll_event listen{};
+	listen.events = EPOLLIN | EPOLLEXCLUSIVE;
+	listen.data.ptr = NULL; //The listener is the only event without a connection
+	if(epoll_ctl(epoll, EPOLL_CTL_ADD, shared.listener, &listen) != 0){
+		fail(loop.status, std::string("Error watching the clerk server socket: ") + std::strerror(errno));
+		close(epoll);
+		return;
+	}
+
+	std::unordered_map<ClerkConnection *, std::unique_ptr<ClerkConnection>> connections;
+	epoll_event events[MAX_EVENTS];
+	while(!shared.stop.load()){
+		int ready = epoll_wait(epoll, events, MAX_EVENTS, WAIT_MS);
+		if(ready < 0){
+			if(errno == EINTR){continue;}
+			fail(loop.status, std::string("Error waiting for clerk terminals: ") + std::strerror(errno));
+			break;
+		}
+		for(int i = 0; i < ready; i++){
+			ClerkConnection *connection = static_cast<ClerkConnection *>(events[i].data.ptr);
+			if(connection == NULL){
+				acceptTerminals(epoll, shared, loop, connections);
+				continue;
+			}
+
+			bool keep = true;
+			if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)){keep = readInput(*connection);}
+			if(keep){keep = sendScreen(epoll, *connection);}
+			if(keep && connection->session.done() && connection->pending.empty()){keep = false;} //Quit, and the last screen has been sent
+			if(!keep){
+				epoll_ctl(epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+				connections.erase(connection); //Destroys the session wherever it was waiting and closes the socket
+				shared.connected--;
+			}
+		}
+	}
+
+	shared.connected -= connections.size();
+	connections.clear();
+	close(epoll);
+}
+
+//Opens the thread's own connection and runs its event loop on it
+static void runLoopOnThread(const std::string &path, ClerkServerShared &shared, ClerkLoop &loop){
+	int rc = sqlite3_open_v2(path.c_str(), &loop.db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, NULL);
+	if(rc != SQLITE_OK){
+		fail(loop.status, loop.db, NULL, "Error opening database for the clerk server");
+		sqlite3_close(loop.db);
+		return;
+	}
+	sqlite3_busy_timeout(loop.db, 5000); //Sales from the other threads' registers wait their turn instead of failing
+	loop.status = enableForeignKeys(loop.db);
+	if(loop.status.ok()){loop.status = prepareStatements(loop.db);}
+	if(loop.status.ok()){loop.status = traceSlowStatements(loop.db);} //Only if main opened the slow statement log
+	if(loop.status.ok()){loop.status = watchWalCommits(loop.db);} //Sales leave checkpoints to main's checkpoint thread
+	if(loop.status.ok()){runLoop(shared, loop);}
+	untraceSlowStatements(loop.db);
+	finalizeStatements(loop.db);
+	sqlite3_close(loop.db);
+}
+
+//Binds and listens on the request's address. Returns the socket, or -1 with the failure recorded on result
+static int openListener(const ClerkServerRequest &request, ClerkServerResult &result){
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(request.port);
+	if(request.port < 1 || request.port > 65535 || inet_pton(AF_INET, request.host.c_str(), &address.sin_addr) != 1){
+		fail(result, "Invalid clerk server address " + request.host + ":" + std::to_string(request.port));
+		return -1;
+	}
+	int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(listener < 0){
+		fail(result, std::string("Error creating the clerk server socket: ") + std::strerror(errno));
+		return -1;
+	}
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	if(bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0){
+		fail(result, "Error listening on " + request.host + ":" + std::to_string(request.port) + ": " + std::strerror(errno));
+		close(listener);
+		return -1;
+	}
+	return listener;
+}
+
+ClerkServerResult runClerkServer(sqlite3 *db, const ClerkServerRequest &request, const std::atomic<bool> &stop){
+	ClerkServerResult result;
+	int listener = openListener(request, result);
+	if(listener < 0){return result;}
+
+	//Threads need the database file to open their own connections, so an in-memory database is served on the caller's connection
+	const char *filename = sqlite3_db_filename(db, "main");
+	std::string path = filename == NULL ? "" : filename;
+	int threads = request.threads > 0 ? request.threads : std::thread::hardware_concurrency();
+	if(threads < 1 || path.empty()){threads = 1;}
+	result.threads = threads;
+
+	ClerkServerShared shared{listener, request, stop};
+	OpResult loaded = shared.counters.load(db);
+	if(loaded.ok()){loaded = loadPrices(db);} //Up front, so no register's first sale reads the price book
+	if(!loaded.ok()){
+		close(listener);
+		result.rc = loaded.rc;
+		result.error = loaded.error;
+		return result;
+	}
+	std::vector<ClerkLoop> loops(threads);
+	if(threads == 1){
+		loops[0].db = db;
+		runLoop(shared, loops[0]);
+	}
+	else{
+		std::vector<std::thread> workers;
+		for(ClerkLoop &loop : loops){
+			workers.emplace_back(runLoopOnThread, std::cref(path), std::ref(shared), std::ref(loop));
+		}
+		for(std::thread &worker : workers){
+			worker.join();
+		}
+	}
+	close(listener);
+
+	for(const ClerkLoop &loop : loops){
+		result.sessions += loop.sessions;
+		if(!loop.status.ok() && result.ok()){
+			result.rc = loop.status.rc;
+			result.error = loop.status.error;
+		}
+	}
+	result.peakSessions = shared.peak.load();
+	result.stockResyncs = shared.counters.resyncs();
+	return result;
+}
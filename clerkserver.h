@@ -0,0 +1,35 @@
+/* Program name: clerkserver.h
+* Purpose: Declares the clerk server, which lets one process serve every register in a region. Each clerk connects a plain text terminal (telnet or nc)
+*  to a TCP port and gets the same menu as the console, running as a clerk session (clerk.h). A few event loop threads share the listening socket; the
+*  thread that accepts a terminal keeps it, and resumes its session whenever the clerk's input arrives, so a thread serves as many waiting clerks as it
+*  has sockets. Each thread has its own connection to the database, shared by the sessions it runs one at a time. Sales reserve their stock in one set
+*  of stock counters (stockcounters.h) shared by every thread.
+*/
+
+#ifndef CLERKSERVER_H
+#define CLERKSERVER_H
+
+#include <atomic>
+#include <string>
+#include <sqlite3.h>
+#include "pokemart.h"
+
+struct ClerkServerRequest{
+	std::string host = "127.0.0.1"; //IPv4 address to listen on; 0.0.0.0 accepts terminals from other machines
+	int port = 0;
+	int threads = 0; //0 uses one thread per hardware thread
+	int maxSessions = 10000; //Terminals beyond this are told the server is busy and disconnected
+};
+
+struct ClerkServerResult : OpResult{
+	sqlite3_int64 sessions = 0; //Terminals served
+	int peakSessions = 0; //Most terminals connected at once
+	int threads = 0;
+	int stockResyncs = 0; //Stock counters found out of line with stock written outside the server, and reset from the database
+};
+
+//Serves terminals until stop is set, then disconnects them and returns. An in-memory database, or threads == 1, is served by one thread on the caller's
+//connection, which must have its statements prepared
+ClerkServerResult runClerkServer(sqlite3 *, const ClerkServerRequest &, const std::atomic<bool> &stop);
+
+#endif
@@ -0,0 +1,281 @@
+/* Program name: compaction.cpp
+* Purpose: Implements the history compaction job declared in compaction.h. The archive database is attached to the connection so each batch can copy its
+*  rows and delete them from pokemart.db in one transaction, which commits to both files atomically.
+*/
+
+#include "compaction.h"
+#include "asof.h"
+#include "pokemart_internal.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+//The SQL that moves one history table. A row is archived when it is dated before the cutoff and is not the newest row for its key, so the latest stock of
+//every product and the latest balance of every mart stay in pokemart.db whatever their age. Dates are compared as Unix time (@cutoff); only rows whose
+//text date could not be converted fall back to comparing text (@cutoffText)
+struct HistoryTable{
+	const char *name;
+	const char *idRange; //Lowest and highest id in the hot table
+	const char *createArchive;
+	const char *copyBatch; //Copies the qualifying rows with an id in (@after, @upto] into the archive
+	const char *deleteBatch; //Deletes the rows of the same id range that are now in the archive
+	std::vector<const char *> laterColumns; //Columns of createArchive added since the first archives were made, added to an older archive when it is next used
+};
+
+const HistoryTable STOCK_HISTORY = {
+	"stock_history",
+	"SELECT MIN(stock_id), MAX(stock_id) FROM main.stock_history",
+	"CREATE TABLE IF NOT EXISTS archive.stock_history (stock_id INTEGER PRIMARY KEY, prod_code VARCHAR(20) NOT NULL, stock_date TIMESTAMP NOT NULL, "
+	"mart_id SMALLINT NOT NULL, stock_qty SMALLINT NOT NULL, stock_epoch INTEGER, transfer_id INTEGER)",
+	"INSERT INTO archive.stock_history (stock_id, prod_code, stock_date, mart_id, stock_qty, stock_epoch, transfer_id) "
+	"SELECT s.stock_id, s.prod_code, s.stock_date, s.mart_id, s.stock_qty, s.stock_epoch, s.transfer_id FROM main.stock_history s "
+	"WHERE s.stock_id > @after AND s.stock_id <= @upto AND (s.stock_epoch < @cutoff OR (s.stock_epoch IS NULL AND s.stock_date < @cutoffText)) "
+	"AND s.stock_id < (SELECT MAX(l.stock_id) FROM main.stock_history l WHERE l.mart_id = s.mart_id AND l.prod_code = s.prod_code)",
+	"DELETE FROM main.stock_history WHERE stock_id IN (SELECT stock_id FROM archive.stock_history WHERE stock_id > @after AND stock_id <= @upto)",
+	{"stock_epoch INTEGER", "transfer_id INTEGER"} //transfer_id pairs archived rows with each other; stock_transfer itself is never archived
+};
+
+const HistoryTable BALANCE_HISTORY = {
+	"mart_balance_history",
+	"SELECT MIN(balance_id), MAX(balance_id) FROM main.mart_balance_history",
+	"CREATE TABLE IF NOT EXISTS archive.mart_balance_history (balance_id INTEGER PRIMARY KEY, balance NUMERIC(9,3) NOT NULL, balance_date TIMESTAMP NOT NULL, "
+	"mart_id SMALLINT NOT NULL, balance_epoch INTEGER)",
+	"INSERT INTO archive.mart_balance_history (balance_id, balance, balance_date, mart_id, balance_epoch) "
+	"SELECT b.balance_id, b.balance, b.balance_date, b.mart_id, b.balance_epoch FROM main.mart_balance_history b "
+	"WHERE b.balance_id > @after AND b.balance_id <= @upto AND (b.balance_epoch < @cutoff OR (b.balance_epoch IS NULL AND b.balance_date < @cutoffText)) "
+	"AND b.balance_id < (SELECT MAX(l.balance_id) FROM main.mart_balance_history l WHERE l.mart_id = b.mart_id)",
+	"DELETE FROM main.mart_balance_history WHERE balance_id IN (SELECT balance_id FROM archive.mart_balance_history WHERE balance_id > @after AND balance_id <= @upto)",
+	{"balance_epoch INTEGER"}
+};
+
+//Runs a single-value PRAGMA against the main database
+static int pragmaValue(sqlite3 *db, const char *pragma, sqlite3_int64 &value, OpResult &result){
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, pragma, -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, std::string("Error reading ") + pragma);}
+	rc = sqlite3_step(res);
+	if(rc != SQLITE_ROW){return fail(result, db, res, std::string("Error reading ") + pragma);}
+	value = sqlite3_column_int64(res, 0);
+	sqlite3_finalize(res);
+	return SQLITE_OK;
+}
+
+int databaseSize(sqlite3 *db, DatabaseSize &size, OpResult &result){
+	sqlite3_int64 pageSize, pageCount, freePages;
+	if(pragmaValue(db, "PRAGMA main.page_size", pageSize, result) != SQLITE_OK){return result.rc;}
+	if(pragmaValue(db, "PRAGMA main.page_count", pageCount, result) != SQLITE_OK){return result.rc;}
+	if(pragmaValue(db, "PRAGMA main.freelist_count", freePages, result) != SQLITE_OK){return result.rc;}
+	size.fileBytes = pageCount * pageSize;
+	size.usedBytes = (pageCount - freePages) * pageSize;
+	return SQLITE_OK;
+}
+
+//Adds the columns an archive made by an older version is missing. Rows archived before then are left NULL in them
+static int upgradeArchive(sqlite3 *db, const HistoryTable &table, OpResult &result){
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "SELECT 1 FROM pragma_table_info(?1, 'archive') WHERE name = ?2", -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, std::string("Error reading archive columns of ") + table.name);}
+	for(const char *column : table.laterColumns){
+		std::string definition = column;
+		std::string name = definition.substr(0, definition.find(' '));
+		sqlite3_bind_text(res, 1, table.name, -1, SQLITE_STATIC);
+		sqlite3_bind_text(res, 2, name.c_str(), -1, SQLITE_TRANSIENT);
+		rc = sqlite3_step(res);
+		sqlite3_reset(res);
+		if(rc == SQLITE_DONE){
+			std::string sql = std::string("ALTER TABLE archive.") + table.name + " ADD COLUMN " + definition;
+			rc = sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL);
+		}
+		else if(rc == SQLITE_ROW){rc = SQLITE_OK;}
+		if(rc != SQLITE_OK){return fail(result, db, res, std::string("Error adding ") + name + " to the archived " + table.name);}
+	}
+	sqlite3_finalize(res);
+	return SQLITE_OK;
+}
+
+//Binds the id range of one batch to a prepared copy or delete statement
+static int bindBatch(sqlite3_stmt *res, sqlite3_int64 after, sqlite3_int64 upto){
+	int rc = sqlite3_bind_int64(res, sqlite3_bind_parameter_index(res, "@after"), after);
+	if(rc == SQLITE_OK){rc = sqlite3_bind_int64(res, sqlite3_bind_parameter_index(res, "@upto"), upto);}
+	return rc;
+}
+
+//Moves the old rows of one table, walking its ids in windows of batchRows. Each window is its own IMMEDIATE transaction, so the write lock is taken up front
+//and held only for one batch; a sale waiting on the lock gets in between batches
+static int archiveTable(sqlite3 *db, const HistoryTable &table, const CompactionRequest &request, int &rowsArchived, CompactionResult &result){
+	int rc = sqlite3_exec(db, table.createArchive, NULL, NULL, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, NULL, std::string("Error creating archive table for ") + table.name);}
+	if(upgradeArchive(db, table, result) != SQLITE_OK){return result.rc;}
+
+	//Rows added after this point are newer than any cutoff in the past, so the walk stops at the highest id seen now
+	sqlite3_stmt *res;
+	rc = sqlite3_prepare_v2(db, table.idRange, -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, std::string("Error reading id range of ") + table.name);}
+	rc = sqlite3_step(res);
+	if(rc != SQLITE_ROW){return fail(result, db, res, std::string("Error reading id range of ") + table.name);}
+	if(sqlite3_column_type(res, 0) == SQLITE_NULL){ //Empty table
+		sqlite3_finalize(res);
+		return SQLITE_OK;
+	}
+	sqlite3_int64 after = sqlite3_column_int64(res, 0) - 1;
+	sqlite3_int64 lastID = sqlite3_column_int64(res, 1);
+	sqlite3_finalize(res);
+
+	sqlite3_stmt *copy, *remove;
+	rc = sqlite3_prepare_v2(db, table.copyBatch, -1, &copy, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, copy, std::string("Error preparing archive copy of ") + table.name);}
+	rc = sqlite3_prepare_v2(db, table.deleteBatch, -1, &remove, NULL);
+	if(rc != SQLITE_OK){
+		sqlite3_finalize(copy);
+		return fail(result, db, remove, std::string("Error preparing archive delete of ") + table.name);
+	}
+	sqlite3_int64 cutoff;
+	if(!parseTimestamp(request.cutoff, cutoff)){
+		sqlite3_finalize(copy);
+		sqlite3_finalize(remove);
+		return fail(result, "Invalid cutoff " + request.cutoff + ". Cutoffs must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+	}
+	rc = sqlite3_bind_int64(copy, sqlite3_bind_parameter_index(copy, "@cutoff"), cutoff);
+	if(rc == SQLITE_OK){rc = sqlite3_bind_text(copy, sqlite3_bind_parameter_index(copy, "@cutoffText"), request.cutoff.c_str(), -1, SQLITE_STATIC);}
+	if(rc != SQLITE_OK){
+		sqlite3_finalize(remove);
+		return fail(result, db, copy, "Error binding cutoff in archiveTable");
+	}
+
+	while(after < lastID){
+		sqlite3_int64 upto = after + request.batchRows;
+		rc = sqlite3_exec(db, "BEGIN IMMEDIATE", NULL, NULL, NULL);
+		if(rc != SQLITE_OK){break;}
+		rc = bindBatch(copy, after, upto);
+		if(rc == SQLITE_OK){rc = sqlite3_step(copy);}
+		if(rc == SQLITE_DONE){
+			int copied = sqlite3_changes(db);
+			rc = bindBatch(remove, after, upto);
+			if(rc == SQLITE_OK){rc = sqlite3_step(remove);}
+			if(rc == SQLITE_DONE && sqlite3_changes(db) != copied){ //The archive already had rows in this range that were never removed from pokemart.db
+				rc = SQLITE_CONSTRAINT;
+			}
+			if(rc == SQLITE_DONE){rc = sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);}
+			if(rc == SQLITE_OK){rowsArchived += copied;}
+		}
+		sqlite3_reset(copy);
+		sqlite3_reset(remove);
+		if(rc != SQLITE_OK){
+			fail(result, db, NULL, std::string("Error archiving ") + table.name + " rows " + std::to_string(after + 1) + " to " + std::to_string(upto));
+			sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+			break;
+		}
+		result.batches++;
+		after = upto;
+		if(request.pauseMs > 0 && after < lastID){std::this_thread::sleep_for(std::chrono::milliseconds(request.pauseMs));}
+	}
+	sqlite3_finalize(copy);
+	sqlite3_finalize(remove);
+	if(rc != SQLITE_OK && result.ok()){return fail(result, db, NULL, std::string("Error starting archive batch of ") + table.name);}
+	return result.rc;
+}
+
+//Reclaims the space freed by the batches. Without VACUUM the file keeps its size, but the free pages are reused by new history rows before it grows again
+static int reclaimSpace(sqlite3 *db, const CompactionRequest &request, CompactionResult &result){
+	if(request.vacuum){
+		int rc = sqlite3_exec(db, "VACUUM main", NULL, NULL, NULL);
+		if(rc != SQLITE_OK){return fail(result, db, NULL, "Error vacuuming pokemart.db");}
+		return SQLITE_OK;
+	}
+	sqlite3_int64 autoVacuum;
+	if(pragmaValue(db, "PRAGMA main.auto_vacuum", autoVacuum, result) != SQLITE_OK){return result.rc;}
+	if(autoVacuum == 2){ //INCREMENTAL: give the free pages back without rewriting the file
+		int rc = sqlite3_exec(db, "PRAGMA main.incremental_vacuum", NULL, NULL, NULL);
+		if(rc != SQLITE_OK){return fail(result, db, NULL, "Error running incremental vacuum on pokemart.db");}
+	}
+	return SQLITE_OK;
+}
+
+CompactionResult compactHistory(sqlite3 *db, const CompactionRequest &request){
+	CompactionResult result;
+	if(!validDate(request.cutoff)){
+		fail(result, "Cutoff must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return result;
+	}
+	if(request.batchRows <= 0){
+		fail(result, "Batch size must be greater than 0");
+		return result;
+	}
+	if(databaseSize(db, result.before, result) != SQLITE_OK){return result;}
+
+	sqlite3_int64 cutoff;
+	if(!parseTimestamp(request.cutoff, cutoff)){
+		fail(result, "Invalid cutoff " + request.cutoff + ". Cutoffs must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return result;
+	}
+	CheckpointResult checkpoint = takeCheckpoint(db, std::min(cutoff, currentTimestamp().epoch));
+	if(!checkpoint.ok()){
+		result.rc = checkpoint.rc;
+		result.error = checkpoint.error;
+		return result;
+	}
+	result.checkpoint = checkpoint.at;
+
+	//ATTACH only creates missing files when the connection was opened with SQLITE_OPEN_CREATE, so the archive is created here first
+	sqlite3 *archive;
+	int rc = sqlite3_open_v2(request.archivePath.c_str(), &archive, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+	sqlite3_close(archive);
+	if(rc != SQLITE_OK){
+		fail(result, "Error opening archive database " + request.archivePath);
+		return result;
+	}
+
+	sqlite3_stmt *res;
+	rc = sqlite3_prepare_v2(db, "ATTACH DATABASE @path AS archive", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error attaching archive database");
+		return result;
+	}
+	rc = sqlite3_bind_text(res, sqlite3_bind_parameter_index(res, "@path"), request.archivePath.c_str(), -1, SQLITE_STATIC);
+	if(rc == SQLITE_OK){rc = sqlite3_step(res);}
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error attaching archive database " + request.archivePath);
+		return result;
+	}
+	sqlite3_finalize(res);
+
+	if(archiveTable(db, STOCK_HISTORY, request, result.stockRowsArchived, result) == SQLITE_OK){
+		archiveTable(db, BALANCE_HISTORY, request, result.balanceRowsArchived, result);
+	}
+	sqlite3_exec(db, "DETACH DATABASE archive", NULL, NULL, NULL);
+	if(!result.ok()){return result;}
+
+	if(reclaimSpace(db, request, result) != SQLITE_OK){return result;}
+	databaseSize(db, result.after, result);
+	return result;
+}
+
+//Report fields
+const ReportField COMPACTION_REPORT = {"History Compaction", "compaction"};
+const ReportField ARCHIVE = {"Archive", "archive"};
+const ReportField CUTOFF = {"Archived Rows Dated Before", "cutoff"};
+const ReportField STOCK_ROWS = {"Stock History Rows Archived", "stock_rows_archived"};
+const ReportField BALANCE_ROWS = {"Balance History Rows Archived", "balance_rows_archived"};
+const ReportField BATCHES = {"Batches", "batches"};
+const ReportField CHECKPOINT = {"Checkpoint Taken At", "checkpoint"};
+const ReportField FILE_BEFORE = {"File Bytes Before", "file_bytes_before"};
+const ReportField FILE_AFTER = {"File Bytes After", "file_bytes_after"};
+const ReportField USED_BEFORE = {"Used Bytes Before", "used_bytes_before"};
+const ReportField USED_AFTER = {"Used Bytes After", "used_bytes_after"};
+
+void writeCompactionReport(const CompactionRequest &request, const CompactionResult &result, ReportRenderer &out){
+	out.beginReport(COMPACTION_REPORT);
+	out.field(ARCHIVE, request.archivePath);
+	out.field(CUTOFF, request.cutoff);
+	out.field(STOCK_ROWS, result.stockRowsArchived);
+	out.field(BALANCE_ROWS, result.balanceRowsArchived);
+	out.field(BATCHES, result.batches);
+	out.field(CHECKPOINT, result.checkpoint);
+	out.field(FILE_BEFORE, result.before.fileBytes);
+	out.field(FILE_AFTER, result.after.fileBytes);
+	out.field(USED_BEFORE, result.before.usedBytes);
+	out.field(USED_AFTER, result.after.usedBytes);
+	out.endReport();
+}
@@ -0,0 +1,45 @@
+/* Program name: compaction.h
+* Purpose: Declares the history compaction job. stock_history and mart_balance_history get a row for every sale line and are never trimmed, so the queries
+*  for the latest stock and balance slow down as they grow. compactHistory moves rows older than a cutoff into an archive database, always keeping the newest
+*  row for each (mart_id, prod_code) and each mart_id in pokemart.db. Rows are moved in small batches, each in its own short transaction, so registers
+*  can keep recording sales while it runs. A checkpoint (asof.h) is taken at the cutoff first, so as-of lookups from the cutoff on give the same answers
+*  after the rows they read are archived.
+*/
+
+#ifndef COMPACTION_H
+#define COMPACTION_H
+
+#include <string>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct CompactionRequest{
+	std::string archivePath = "pokemart_archive.db"; //Created if it does not exist. Rows from earlier runs are kept
+	std::string cutoff; //Rows dated before this ("YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS") are archived
+	int batchRows = 500; //Range of row ids examined per transaction; keeps each write lock short
+	int pauseMs = 0; //Sleep between batches to leave more room for sales
+	bool vacuum = false; //Run VACUUM at the end so the file actually shrinks. VACUUM blocks writers while it runs
+};
+
+//Size of the hot database file. usedBytes leaves out free pages, which SQLite reuses for new rows before it grows the file
+struct DatabaseSize{
+	sqlite3_int64 fileBytes = 0, usedBytes = 0;
+};
+
+struct CompactionResult : OpResult{
+	int stockRowsArchived = 0, balanceRowsArchived = 0;
+	int batches = 0;
+	std::string checkpoint; //Time of the checkpoint taken before archiving: the cutoff, or now if the cutoff is later
+	DatabaseSize before, after;
+};
+
+CompactionResult compactHistory(sqlite3 *, const CompactionRequest &);
+
+//Reads the size of the main database of a connection
+int databaseSize(sqlite3 *, DatabaseSize &, OpResult &);
+
+//Renders the rows moved and the hot file size before and after
+void writeCompactionReport(const CompactionRequest &, const CompactionResult &, ReportRenderer &);
+
+#endif
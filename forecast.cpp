@@ -0,0 +1,216 @@
+/* Program name: forecast.cpp
+* Purpose: Implements demand forecasting (forecast.h). stock_history is read in (mart_id, prod_code, stock_id) order from the stock_history_mart_prod
+*  index and decoded into fixed-size columnar batches. The drop in stock between consecutive rows is computed over a whole batch in one branch-free loop
+*  the compiler can vectorize, and only the rows that were sales are then added to their product's bucket. Each finished bucket is folded into the
+*  product's smoothed demand.
+*/
+
+#include "forecast.h"
+#include "pokemart_internal.h"
+#include "rowmap.h"
+#include <algorithm>
+#include <cmath>
+
+//A batch of stock_history rows stored column by column. key holds the index of the row's (mart_id, prod_code) in the scan's key list, and transfer is 1
+//for rows written by a stock transfer (rebalance.h). Slot 0 carries the last row of the previous batch, so the first row of a batch gets a delta too
+struct HistoryBatch{
+	std::vector<int> key, qty, transfer, sold;
+	std::vector<sqlite3_int64> bucket; //stock_epoch divided by the bucket length
+	int rows = 0;
+
+	explicit HistoryBatch(int capacity) : key(capacity + 1, -1), qty(capacity + 1, 0), transfer(capacity + 1, 0), sold(capacity + 1, 0), bucket(capacity + 1, 0) {}
+};
+
+//Demand of one (mart_id, prod_code). Keys are numbered in scan order, so all rows of a key are next to each other
+struct DemandKey{
+	int martID;
+	std::string prodCode;
+	int sales = 0;
+	int buckets = 0; //Buckets folded into demand
+	sqlite3_int64 bucket = 0; //The bucket being added up, once the key has a sale
+	int bucketQty = 0;
+	double demand = 0; //Smoothed quantity per bucket
+};
+
+//Folds the bucket being added up into the smoothed demand. The first bucket starts the average
+static void closeBucket(DemandKey &key, double alpha){
+	key.demand = key.buckets == 0 ? key.bucketQty : alpha * key.bucketQty + (1 - alpha) * key.demand;
+	key.buckets++;
+	key.bucketQty = 0;
+}
+
+//Folds the empty buckets after the key's current one, up to but not including bucket
+static void skipToBucket(DemandKey &key, sqlite3_int64 bucket, double alpha){
+	if(bucket > key.bucket + 1){
+		key.demand *= std::pow(1 - alpha, static_cast<double>(bucket - key.bucket - 1));
+		key.buckets += bucket - key.bucket - 1;
+	}
+	key.bucket = bucket;
+}
+
+//Quantity sold in each row: the drop from the row before it for the same key. Rises (vendor reorders), stock sent to another PokeMart and the first row
+//of each key count as 0
+static void computeSold(HistoryBatch &batch){
+	const int *key = batch.key.data();
+	const int *qty = batch.qty.data();
+	const int *transfer = batch.transfer.data();
+	int *sold = batch.sold.data();
+	for(int i = 1; i <= batch.rows; i++){
+		int drop = qty[i - 1] - qty[i];
+		sold[i] = (key[i] == key[i - 1] && drop > 0 && transfer[i] == 0) ? drop : 0;
+	}
+}
+
+//Adds the sales of a batch to each key's bucket, folding the buckets it finishes into the key's exponentially smoothed demand. Buckets start at the
+//key's first sale. A row dated before the bucket being added up (such as one with no stock_epoch) counts towards it
+static void smoothDemand(const HistoryBatch &batch, std::vector<DemandKey> &keys, double alpha){
+	for(int i = 1; i <= batch.rows; i++){
+		int sold = batch.sold[i];
+		if(sold == 0){continue;}
+		DemandKey &key = keys[batch.key[i]];
+		if(key.sales == 0){key.bucket = batch.bucket[i];}
+		else if(batch.bucket[i] > key.bucket){
+			closeBucket(key, alpha);
+			skipToBucket(key, batch.bucket[i], alpha);
+		}
+		key.bucketQty += sold;
+		key.sales++;
+	}
+}
+
+static void processBatch(HistoryBatch &batch, std::vector<DemandKey> &keys, double alpha, ForecastResult &result){
+	computeSold(batch);
+	smoothDemand(batch, keys, alpha);
+	batch.key[0] = batch.key[batch.rows];
+	batch.qty[0] = batch.qty[batch.rows];
+	result.rowsScanned += batch.rows;
+	result.batches++;
+	batch.rows = 0;
+}
+
+//Replaces the previous forecast with these reorder points in one transaction. The forecast covers the whole stock history, so a PokeMart and product
+//missing from it (too few sales left, such as after compaction archived them) loses its old reorder point and goes back to product.min_qty
+static int storeReorderPoints(sqlite3 *db, const std::vector<ReorderPoint> &points, ForecastResult &result){
+	int rc = startTransaction(db);
+	if(rc != SQLITE_OK){return fail(result, db, NULL, "Unable to start reorder point transaction");}
+
+	rc = sqlite3_exec(db, "DELETE FROM reorder_point", NULL, NULL, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, NULL, "Error clearing previous reorder points");
+		rollback(db);
+		return result.rc;
+	}
+
+	sqlite3_stmt *res;
+	std::string query = "INSERT INTO reorder_point (mart_id, prod_code, min_qty, demand, updated) VALUES (@martID, @prodCode, @minQty, @demand, datetime('now', 'localtime'))";
+	rc = sqlite3_prepare_v2(db, query.c_str(), -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error storing reorder points");
+		rollback(db);
+		return result.rc;
+	}
+	for(const ReorderPoint &point : points){
+		if(sqlite3_bind_int(res, sqlite3_bind_parameter_index(res, "@martID"), point.martID) != SQLITE_OK ||
+			sqlite3_bind_text(res, sqlite3_bind_parameter_index(res, "@prodCode"), point.prodCode.c_str(), -1, SQLITE_STATIC) != SQLITE_OK ||
+			sqlite3_bind_int(res, sqlite3_bind_parameter_index(res, "@minQty"), point.minQty) != SQLITE_OK ||
+			sqlite3_bind_double(res, sqlite3_bind_parameter_index(res, "@demand"), point.demand) != SQLITE_OK ||
+			sqlite3_step(res) != SQLITE_DONE){
+			fail(result, db, res, "Error storing reorder point for " + point.prodCode + " at PokeMart " + std::to_string(point.martID));
+			rollback(db);
+			return result.rc;
+		}
+		sqlite3_reset(res);
+	}
+	sqlite3_finalize(res);
+
+	rc = commit(db);
+	if(rc != SQLITE_OK){return fail(result, db, NULL, "Error committing reorder points");}
+	return SQLITE_OK;
+}
+
+ForecastResult forecastDemand(sqlite3 *db, const ForecastRequest &request){
+	ForecastResult result;
+	if(!(request.alpha > 0 && request.alpha <= 1)){
+		fail(result, "Smoothing weight must be greater than 0 and at most 1");
+		return result;
+	}
+	if(!(request.leadDays > 0) || request.bucketSeconds <= 0 || request.batchRows <= 0){
+		fail(result, "Lead days, bucket length and batch size must be greater than 0");
+		return result;
+	}
+
+	sqlite3_stmt *res;
+	std::string query = "SELECT mart_id, prod_code, stock_qty, transfer_id IS NOT NULL, COALESCE(stock_epoch, 0) FROM stock_history ORDER BY mart_id, prod_code, stock_id";
+	int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting stock history for forecasting");
+		return result;
+	}
+
+	std::vector<DemandKey> keys;
+	HistoryBatch batch(request.batchRows);
+	sqlite3_int64 lastBucket = 0; //The newest bucket in the whole history. Every key's demand is decayed up to it, so products that stopped selling fall off
+	rc = forEachRow<int, std::string_view, int, int, sqlite3_int64>(res, [&](int martID, std::string_view prodCode, int qty, int transfer, sqlite3_int64 epoch){
+		if(keys.empty() || keys.back().martID != martID || keys.back().prodCode != prodCode){
+			keys.push_back({martID, std::string(prodCode)});
+		}
+		batch.rows++;
+		batch.key[batch.rows] = keys.size() - 1;
+		batch.qty[batch.rows] = qty;
+		batch.transfer[batch.rows] = transfer;
+		batch.bucket[batch.rows] = epoch / request.bucketSeconds;
+		lastBucket = std::max(lastBucket, batch.bucket[batch.rows]);
+		if(batch.rows == request.batchRows){processBatch(batch, keys, request.alpha, result);}
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading stock history for forecasting");
+		return result;
+	}
+	sqlite3_finalize(res);
+	if(batch.rows > 0){processBatch(batch, keys, request.alpha, result);}
+
+	double bucketsPerDay = 86400.0 / request.bucketSeconds;
+	for(DemandKey &key : keys){
+		if(key.sales < request.minSales){continue;}
+		closeBucket(key, request.alpha);
+		skipToBucket(key, lastBucket + 1, request.alpha);
+		double demand = key.demand * bucketsPerDay;
+		int minQty = std::ceil(demand * request.leadDays);
+		result.points.push_back({key.martID, key.prodCode, key.sales, demand, minQty < 1 ? 1 : minQty});
+	}
+	if(request.apply){storeReorderPoints(db, result.points, result);}
+	return result;
+}
+
+//Report fields
+const ReportField FORECAST_REPORT = {"Demand Forecast", "forecast"};
+const ReportField ALPHA = {"Smoothing Weight", "alpha"};
+const ReportField LEAD_DAYS = {"Lead Days", "lead_days"};
+const ReportField BUCKET_SECONDS = {"Bucket Seconds", "bucket_seconds"};
+const ReportField ROWS_SCANNED = {"Stock History Rows Scanned", "rows_scanned"};
+const ReportField REORDER_POINTS = {"Reorder Points", "reorder_points"};
+const ReportField MART_ID = {"PokeMart ID", "mart_id"};
+const ReportField PROD_CODE = {"Product Code", "prod_code"};
+const ReportField SALES = {"Sales", "sales"};
+const ReportField DEMAND = {"Smoothed Quantity per Day", "demand"};
+const ReportField MIN_QTY = {"Reorder Point", "min_qty"};
+
+void writeForecastReport(const ForecastRequest &request, const ForecastResult &result, ReportRenderer &out){
+	out.beginReport(FORECAST_REPORT);
+	out.decimalField(ALPHA, request.alpha);
+	out.decimalField(LEAD_DAYS, request.leadDays);
+	out.field(BUCKET_SECONDS, request.bucketSeconds);
+	out.field(ROWS_SCANNED, result.rowsScanned);
+	out.beginRows(REORDER_POINTS);
+	for(const ReorderPoint &point : result.points){
+		out.beginRow();
+		out.field(MART_ID, point.martID);
+		out.field(PROD_CODE, point.prodCode);
+		out.field(SALES, point.sales);
+		out.decimalField(DEMAND, point.demand);
+		out.field(MIN_QTY, point.minQty);
+		out.endRow();
+	}
+	out.endRows();
+	out.endReport();
+}
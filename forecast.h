@@ -0,0 +1,45 @@
+/* Program name: forecast.h
+* Purpose: Declares demand forecasting. A sale lowers the stock of a product at a PokeMart in its own stock_history row and a vendor reorder raises it in
+*  the next, so the drops between consecutive rows of a (mart_id, prod_code) are its sales, apart from stock sent to another PokeMart (rebalance.h).
+*  forecastDemand adds those sales up per time bucket (a day by default), smooths the buckets exponentially into an expected quantity sold per day, and
+*  turns that into a reorder point covering the lead time, written to reorder_point. recordSale reorders below that point instead of product.min_qty.
+*/
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct ForecastRequest{
+	double alpha = 0.3; //Weight of the newest bucket in the smoothed demand (0 < alpha <= 1). Higher values follow recent sales more closely
+	double leadDays = 7; //Days of sales the stock left at reorder time should cover. The reorder point is the smoothed demand per day times this
+	int bucketSeconds = 86400; //Length of a bucket. Buckets with no sales count as selling nothing, up to the last bucket in the history
+	int minSales = 3; //Products with fewer sales than this at a PokeMart keep using product.min_qty
+	int batchRows = 4096; //stock_history rows decoded per columnar batch
+	bool apply = true; //Replace the contents of reorder_point with the reorder points. Otherwise they are only returned
+};
+
+struct ReorderPoint{
+	int martID;
+	std::string prodCode;
+	int sales; //Sales found in the history
+	double demand; //Smoothed quantity sold per day
+	int minQty; //Recommended reorder point
+};
+
+struct ForecastResult : OpResult{
+	std::vector<ReorderPoint> points; //Ordered by mart_id, then prod_code
+	sqlite3_int64 rowsScanned = 0;
+	int batches = 0;
+};
+
+ForecastResult forecastDemand(sqlite3 *, const ForecastRequest &);
+
+//Renders one row per recommended reorder point
+void writeForecastReport(const ForecastRequest &, const ForecastResult &, ReportRenderer &);
+
+#endif
@@ -49,7 +49,7 @@ INSERT INTO invoice (trainer_id, emp_id, mart_id)
 VALUES (1, 1, 1), (2, 1, 1), (3, 1, 1), (4, 1, 1), (5, 1, 1);
 
 INSERT INTO line (invoice_num, line_num, prod_code, qty)
-VALUES (1, 1, 'PKB', 1),
+VALUES (1, 1, 'PB', 1),
         (1, 2, 'GB', 1),
         (1, 3, 'UB', 1),
         (1, 4, 'BP', 1),
@@ -84,6 +84,16 @@ VALUES  ('PB', 1, 2741, '2024-03-02 10:00:00'),
         ('BP', 5, 4125, '2024-03-06 09:32:17'),
         ('SP', 5, 1520, '2024-2-28 06:44:02');
 
+-- The seed sales only list what was bought; price their lines and total their invoices from the current product prices like schema migration 1 does
+UPDATE line SET unit_price = COALESCE((SELECT p.unit_price FROM product p WHERE p.prod_code = line.prod_code), 0);
+UPDATE line SET line_total = unit_price * qty;
+UPDATE invoice SET subtotal = COALESCE((SELECT SUM(l.line_total) FROM line l WHERE l.invoice_num = invoice.invoice_num), 0);
+UPDATE invoice SET tax = subtotal * tax_rate, total = subtotal + subtotal * tax_rate;
 
+-- The seed rows give local time text only; fill in the matching Unix time like schema migration 5 does
+UPDATE stock_history SET stock_epoch = CAST(strftime('%s', stock_date, 'utc') AS INTEGER);
+UPDATE mart_balance_history SET balance_epoch = CAST(strftime('%s', balance_date, 'utc') AS INTEGER);
 
-
+-- The seed balances are each trainer's opening ledger entry, like schema migration 6 makes them
+INSERT INTO trainer_ledger (trainer_id, entry_kind, amount, balance, entry_date, entry_epoch)
+SELECT trainer_id, 'opening', balance, balance, datetime('now', 'localtime'), CAST(strftime('%s', 'now') AS INTEGER) FROM trainer_card WHERE COALESCE(balance, 0) <> 0;
@@ -0,0 +1,206 @@
+/* Program name: invoice_bench.cpp
+* Purpose: Benchmarks batch receipts (writeInvoiceBatch in report.h). Builds a database from tables.sql with one day of invoices at 50 PokeMarts, then writes
+*  every receipt of the day to a file twice: once with writeInvoiceBatch, and once the way viewInvoice prints one, with writeInvoiceReport per invoice.
+*  Prints the receipts written per second by each and fails if the two files differ.
+*  Usage: invoice_bench [invoices] [lines_per_invoice] (run from the source directory; invoice_bench.db is rebuilt on every run)
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "report.h"
+
+const int DB_MARTS = 50;
+const int DB_PRODUCTS = 100;
+const char *const DAY = "2024-06-01";
+const char *const NEXT_DAY = "2024-06-02";
+
+static double secondsSince(std::chrono::steady_clock::time_point start){
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+static bool execOrReport(sqlite3 *db, const std::string &sql, const char *what){
+	if(sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error " << what << ": " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+//Creates the schema and a chain with one day of sales, dated in invoice_num order through the day. Invoices and lines are inserted with their own prepared
+//statements, as the registry has no bulk insert
+static bool buildDatabase(sqlite3 *db, int invoices, int linesPerInvoice){
+	std::ifstream tablesFile("tables.sql");
+	if(!tablesFile){
+		std::cerr << "tables.sql not found; run the benchmark from the source directory\n";
+		return false;
+	}
+	std::stringstream tables;
+	tables << tablesFile.rdbuf();
+	if(!execOrReport(db, tables.str(), "creating schema")){return false;}
+
+	std::string sql = "BEGIN;INSERT INTO trainer_card (trainer_fname, trainer_lname) VALUES ('Bench', 'Trainer');"
+		"INSERT INTO employee (emp_fname, emp_lname) VALUES ('Bench', 'Clerk');";
+	for(int m = 1; m <= DB_MARTS; m++){
+		sql += "INSERT INTO pokemart (city, region, street_address, phone_num) VALUES ('Bench', 'Kanto', '" + std::to_string(m) + " Bench Road', '" +
+			std::to_string(m) + "');";
+	}
+	for(int p = 1; p <= DB_PRODUCTS; p++){
+		sql += "INSERT INTO product (prod_code, prod_name, prod_descript, unit_price, min_qty, vendor_price) VALUES ('P" + std::to_string(p) + "', 'Product " +
+			std::to_string(p) + "', 'Benchmark item', " + std::to_string(p) + ".25, 10, 1);";
+	}
+	if(!execOrReport(db, sql, "filling benchmark database")){return false;}
+
+	sqlite3_stmt *invoice, *line;
+	sqlite3_prepare_v2(db, "INSERT INTO invoice (trainer_id, emp_id, mart_id, invoice_date, subtotal, tax, total) VALUES (1, 1, ?, datetime(1717200000 + ?, "
+		"'unixepoch'), ?, ?, ?)", -1, &invoice, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO line (invoice_num, line_num, prod_code, qty, unit_price, line_total) VALUES (?, ?, ?, ?, ?, ?)", -1, &line, NULL);
+	std::mt19937 random(49);
+	int rc = SQLITE_OK;
+	for(int i = 1; i <= invoices && rc == SQLITE_OK; i++){
+		int lines = 1 + random() % (2 * linesPerInvoice - 1); //Averages linesPerInvoice
+		double subtotal = 0;
+		for(int l = 1; l <= lines && rc == SQLITE_OK; l++){
+			int product = 1 + random() % DB_PRODUCTS, qty = 1 + random() % 9;
+			double price = product + 0.25;
+			std::string code = "P" + std::to_string(product);
+			sqlite3_bind_int(line, 1, i);
+			sqlite3_bind_int(line, 2, l);
+			sqlite3_bind_text(line, 3, code.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int(line, 4, qty);
+			sqlite3_bind_double(line, 5, price);
+			sqlite3_bind_double(line, 6, price * qty);
+			subtotal += price * qty;
+			rc = sqlite3_step(line) == SQLITE_DONE ? SQLITE_OK : sqlite3_errcode(db);
+			sqlite3_reset(line);
+		}
+		double tax = static_cast<long long>(subtotal * 70 + 0.5) / 1000.0; //7%, rounded to the column's thousandths
+		sqlite3_bind_int(invoice, 1, 1 + random() % DB_MARTS);
+		sqlite3_bind_int64(invoice, 2, static_cast<sqlite3_int64>(i - 1) * 86400 / invoices);
+		sqlite3_bind_double(invoice, 3, subtotal);
+		sqlite3_bind_double(invoice, 4, tax);
+		sqlite3_bind_double(invoice, 5, subtotal + tax);
+		if(rc == SQLITE_OK){rc = sqlite3_step(invoice) == SQLITE_DONE ? SQLITE_OK : sqlite3_errcode(db);}
+		sqlite3_reset(invoice);
+	}
+	sqlite3_finalize(invoice);
+	sqlite3_finalize(line);
+	if(rc != SQLITE_OK){
+		std::cerr << "Error filling benchmark database: " << sqlite3_errmsg(db) << '\n';
+		sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+		return false;
+	}
+	return execOrReport(db, "COMMIT", "filling benchmark database");
+}
+
+//The day's invoices in the order the batch writes them
+static bool readInvoiceNums(sqlite3 *db, std::vector<int> &invoiceNums){
+	sqlite3_stmt *res;
+	sqlite3_prepare_v2(db, "SELECT invoice_num FROM invoice WHERE invoice_date >= ?1 AND invoice_date < ?2 ORDER BY invoice_date, invoice_num", -1, &res, NULL);
+	sqlite3_bind_text(res, 1, DAY, -1, SQLITE_STATIC);
+	sqlite3_bind_text(res, 2, NEXT_DAY, -1, SQLITE_STATIC);
+	int rc;
+	while((rc = sqlite3_step(res)) == SQLITE_ROW){invoiceNums.push_back(sqlite3_column_int(res, 0));}
+	sqlite3_finalize(res);
+	if(rc != SQLITE_DONE){
+		std::cerr << "Error reading invoice numbers: " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+static bool sameFile(const char *first, const char *second){
+	std::ifstream a(first, std::ios::binary), b(second, std::ios::binary);
+	std::stringstream aText, bText;
+	aText << a.rdbuf();
+	bText << b.rdbuf();
+	return a && b && aText.str() == bText.str();
+}
+
+int main(int argc, char *argv[]){
+	int invoices = argc > 1 ? std::atoi(argv[1]) : 100000;
+	int linesPerInvoice = argc > 2 ? std::atoi(argv[2]) : 5;
+	if(invoices < 1 || linesPerInvoice < 1){
+		std::cerr << "Usage: " << argv[0] << " [invoices] [lines_per_invoice]\n";
+		return 2;
+	}
+
+	std::string path = "invoice_bench.db";
+	std::remove(path.c_str());
+	sqlite3 *db;
+	if(sqlite3_open(path.c_str(), &db) != SQLITE_OK){
+		std::cerr << "Error opening " << path << ": " << sqlite3_errmsg(db) << '\n';
+		sqlite3_close(db);
+		return 1;
+	}
+	auto start = std::chrono::steady_clock::now();
+	OpResult prepared;
+	if(buildDatabase(db, invoices, linesPerInvoice)){prepared = enableForeignKeys(db);}
+	else{prepared.rc = -1;}
+	if(prepared.ok()){prepared = prepareStatements(db);}
+	std::vector<int> invoiceNums;
+	if(prepared.ok() && !readInvoiceNums(db, invoiceNums)){prepared.rc = -1;}
+	if(!prepared.ok()){
+		if(!prepared.error.empty()){std::cerr << prepared.error << '\n';}
+		finalizeStatements(db);
+		sqlite3_close(db);
+		return 1;
+	}
+	std::cout << "Built " << invoices << " invoices in " << secondsSince(start) << " s\n";
+
+	const char *batchPath = "invoice_bench_batch.txt";
+	const char *loopPath = "invoice_bench_loop.txt";
+	bool ok = true;
+
+	start = std::chrono::steady_clock::now();
+	InvoiceBatchResult batch;
+	{
+		std::ofstream file(batchPath, std::ios::binary);
+		ReportWriter writer(file);
+		batch = writeInvoiceBatch(db, {DAY, NEXT_DAY, 0}, *makeRenderer(ReportFormat::TEXT, writer));
+	}
+	double batchSeconds = secondsSince(start);
+	if(!batch.ok()){
+		std::cerr << batch.error << '\n';
+		ok = false;
+	}
+
+	//What viewInvoice does for each invoice once it is picked. The picker itself (listInvoices) is left out, as running it per invoice would make the loop
+	//quadratic
+	start = std::chrono::steady_clock::now();
+	{
+		std::ofstream file(loopPath, std::ios::binary);
+		ReportWriter writer(file);
+		std::unique_ptr<ReportRenderer> renderer = makeRenderer(ReportFormat::TEXT, writer);
+		for(size_t i = 0; ok && i < invoiceNums.size(); i++){
+			OpResult result = writeInvoiceReport(db, {invoiceNums[i]}, *renderer);
+			if(!result.ok()){
+				std::cerr << result.error << '\n';
+				ok = false;
+			}
+		}
+	}
+	double loopSeconds = secondsSince(start);
+
+	if(ok){
+		std::cout << "Batch: " << batch.invoices << " receipts (" << batch.lines << " lines) in " << batchSeconds << " s, " << batch.invoices / batchSeconds
+			<< " receipts/s\n";
+		std::cout << "Loop over writeInvoiceReport: " << invoiceNums.size() << " receipts in " << loopSeconds << " s, " << invoiceNums.size() / loopSeconds
+			<< " receipts/s (" << loopSeconds / batchSeconds << "x the batch time)\n";
+		if(batch.invoices != static_cast<int>(invoiceNums.size()) || !sameFile(batchPath, loopPath)){
+			std::cerr << "The batch receipts do not match the receipts written one at a time\n";
+			ok = false;
+		}
+	}
+	std::remove(batchPath);
+	std::remove(loopPath);
+	finalizeStatements(db);
+	sqlite3_close(db);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+/* Program name: ledger.cpp
+* Purpose: Implements the trainer statements and ledger reconciliation declared in ledger.h. Reconciliation reads each trainer_id range in a single
+*  statement, so each range sees one snapshot of the database. A sale changes a balance and appends its ledger entry in the same transaction, so a trainer
+*  is never seen with one and not the other, even while registers keep selling.
+*/
+
+#include "ledger.h"
+#include "pokemart_internal.h"
+#include "rowmap.h"
+#include "timestamp.h"
+#include <cmath>
+#include <limits>
+#include <thread>
+
+const double BALANCE_TOLERANCE = 0.005;
+
+TrainerStatementResult getTrainerStatement(sqlite3 *db, const TrainerStatementRequest &request){
+	TrainerStatementResult result;
+	sqlite3_int64 periodStart = std::numeric_limits<sqlite3_int64>::min(), periodEnd = std::numeric_limits<sqlite3_int64>::max();
+	if((!request.periodStart.empty() && !parseTimestamp(request.periodStart, periodStart)) || (!request.periodEnd.empty() && !parseTimestamp(request.periodEnd, periodEnd))){
+		fail(result, "Statement dates must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return result;
+	}
+	if(periodStart >= periodEnd){
+		fail(result, "The statement period must end after it starts");
+		return result;
+	}
+
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "SELECT trainer_fname || ' ' || trainer_lname FROM trainer_card WHERE trainer_id = ?1", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting trainer for statement");
+		return result;
+	}
+	sqlite3_bind_int(res, 1, request.trainerID);
+	rc = sqlite3_step(res);
+	if(rc != SQLITE_ROW){
+		sqlite3_finalize(res);
+		fail(result, "Trainer " + std::to_string(request.trainerID) + " does not exist");
+		return result;
+	}
+	result.trainerName = std::string(readColumn<std::string_view>(res, 0));
+	sqlite3_finalize(res);
+
+	//The opening balance is the balance left by the last entry before the period, found with one seek backwards through the index
+	rc = sqlite3_prepare_v2(db, "SELECT balance FROM trainer_ledger WHERE trainer_id = ?1 AND entry_epoch < ?2 ORDER BY entry_epoch DESC, ledger_id DESC LIMIT 1",
+		-1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting opening balance");
+		return result;
+	}
+	sqlite3_bind_int(res, 1, request.trainerID);
+	sqlite3_bind_int64(res, 2, periodStart);
+	rc = sqlite3_step(res);
+	if(rc == SQLITE_ROW){result.openingBalance = sqlite3_column_double(res, 0);}
+	else if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading opening balance");
+		return result;
+	}
+	sqlite3_finalize(res);
+
+	const char *query = "SELECT ledger_id, entry_date, entry_kind, COALESCE(invoice_num, 0), amount, balance FROM trainer_ledger "
+		"WHERE trainer_id = ?1 AND entry_epoch >= ?2 AND entry_epoch < ?3 ORDER BY entry_epoch, ledger_id";
+	rc = sqlite3_prepare_v2(db, query, -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting ledger entries");
+		return result;
+	}
+	sqlite3_bind_int(res, 1, request.trainerID);
+	sqlite3_bind_int64(res, 2, periodStart);
+	sqlite3_bind_int64(res, 3, periodEnd);
+	result.closingBalance = result.openingBalance;
+	rc = forEachRow<sqlite3_int64, std::string_view, std::string_view, int, double, double>(res,
+		[&](sqlite3_int64 ledgerID, std::string_view date, std::string_view kind, int invoiceNum, double amount, double balance){
+		result.entries.push_back({ledgerID, std::string(date), std::string(kind), invoiceNum, amount, balance});
+		if(kind == "sale"){result.charges += amount;}
+		else{result.adjustments += amount;}
+		result.closingBalance = balance;
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading ledger entries");
+		return result;
+	}
+	sqlite3_finalize(res);
+	return result;
+}
+
+//One trainer_id range of a reconciliation and what was found in it
+struct ReconcilePartition{
+	sqlite3_int64 firstTrainer, lastTrainer; //Inclusive
+	sqlite3_int64 trainers = 0, entries = 0;
+	std::vector<BalanceMismatch> mismatches;
+	OpResult status;
+};
+
+//Checks every trainer of one range over an open connection. The ledger is summed per trainer through the trainer_ledger_trainer_epoch index
+static void reconcilePartition(sqlite3 *db, ReconcilePartition &part){
+	sqlite3_stmt *res;
+	const char *query = "SELECT t.trainer_id, COALESCE(t.balance, 0), (SELECT COALESCE(SUM(l.amount), 0) FROM trainer_ledger l WHERE l.trainer_id = t.trainer_id), "
+		"(SELECT COUNT(*) FROM trainer_ledger l WHERE l.trainer_id = t.trainer_id) FROM trainer_card t WHERE t.trainer_id BETWEEN ?1 AND ?2 ORDER BY t.trainer_id";
+	int rc = sqlite3_prepare_v2(db, query, -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(part.status, db, res, "Error selecting trainers to reconcile");
+		return;
+	}
+	sqlite3_bind_int64(res, 1, part.firstTrainer);
+	sqlite3_bind_int64(res, 2, part.lastTrainer);
+	rc = forEachRow<int, double, double, sqlite3_int64>(res, [&](int trainerID, double balance, double ledgerBalance, sqlite3_int64 entries){
+		part.trainers++;
+		part.entries += entries;
+		if(std::fabs(balance - ledgerBalance) >= BALANCE_TOLERANCE){part.mismatches.push_back({trainerID, balance, ledgerBalance, entries});}
+	});
+	if(rc != SQLITE_DONE){
+		fail(part.status, db, res, "Error reading trainers to reconcile");
+		return;
+	}
+	sqlite3_finalize(res);
+}
+
+//Runs one partition on its own thread and connection
+static void reconcilePartitionOnThread(const std::string &path, ReconcilePartition &part){
+	sqlite3 *db;
+	int rc = sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+	if(rc != SQLITE_OK){
+		fail(part.status, db, NULL, "Error opening database for reconciliation");
+		sqlite3_close(db);
+		return;
+	}
+	sqlite3_busy_timeout(db, 5000);
+	reconcilePartition(db, part);
+	sqlite3_close(db);
+}
+
+ReconcileResult reconcileLedger(sqlite3 *db, const ReconcileRequest &request){
+	ReconcileResult result;
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "SELECT MIN(trainer_id), MAX(trainer_id) FROM trainer_card", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error reading trainer range for reconciliation");
+		return result;
+	}
+	rc = sqlite3_step(res);
+	if(rc != SQLITE_ROW){
+		fail(result, db, res, "Error reading trainer range for reconciliation");
+		return result;
+	}
+	bool noTrainers = sqlite3_column_type(res, 0) == SQLITE_NULL;
+	sqlite3_int64 firstTrainer = sqlite3_column_int64(res, 0);
+	sqlite3_int64 lastTrainer = sqlite3_column_int64(res, 1);
+	sqlite3_finalize(res);
+	if(noTrainers){return result;}
+
+	//Threads need the database file to open their own connections, so an in-memory database is checked on the caller's connection
+	const char *filename = sqlite3_db_filename(db, "main");
+	std::string path = filename == NULL ? "" : filename;
+	sqlite3_int64 threads = request.threads > 0 ? request.threads : std::thread::hardware_concurrency();
+	if(threads < 1 || path.empty()){threads = 1;}
+	if(threads > lastTrainer - firstTrainer + 1){threads = lastTrainer - firstTrainer + 1;}
+	result.threads = threads;
+
+	std::vector<ReconcilePartition> parts(threads);
+	sqlite3_int64 span = (lastTrainer - firstTrainer + 1) / threads;
+	for(sqlite3_int64 i = 0; i < threads; i++){
+		parts[i].firstTrainer = firstTrainer + i * span;
+		parts[i].lastTrainer = i == threads - 1 ? lastTrainer : parts[i].firstTrainer + span - 1;
+	}
+
+	if(threads == 1){
+		reconcilePartition(db, parts[0]);
+	}
+	else{
+		std::vector<std::thread> workers;
+		for(ReconcilePartition &part : parts){
+			workers.emplace_back(reconcilePartitionOnThread, std::cref(path), std::ref(part));
+		}
+		for(std::thread &worker : workers){
+			worker.join();
+		}
+	}
+
+	//The partitions are in trainer_id order, so appending them keeps the mismatches sorted
+	for(ReconcilePartition &part : parts){
+		if(!part.status.ok()){
+			static_cast<OpResult &>(result) = part.status;
+			return result;
+		}
+		result.trainers += part.trainers;
+		result.entries += part.entries;
+		result.mismatches.insert(result.mismatches.end(), part.mismatches.begin(), part.mismatches.end());
+	}
+	return result;
+}
+
+//Report fields
+const ReportField STATEMENT_REPORT = {"Trainer Statement", "trainer_statement"};
+const ReportField TRAINER_ID = {"Trainer ID", "trainer_id"};
+const ReportField TRAINER_NAME = {"Trainer", "trainer"};
+const ReportField PERIOD_START = {"Period Start", "period_start"};
+const ReportField PERIOD_END = {"Period End (exclusive)", "period_end"};
+const ReportField OPENING_BALANCE = {"Opening Balance", "opening_balance"};
+const ReportField ENTRIES = {"Entries", "entries"};
+const ReportField DATE = {"Date", "date"};
+const ReportField KIND = {"Entry", "entry"};
+const ReportField INVOICE_NUM = {"Invoice", "invoice_num"};
+const ReportField AMOUNT = {"Amount", "amount"};
+const ReportField BALANCE = {"Balance", "balance"};
+const ReportField CHARGES = {"Sales", "sales"};
+const ReportField ADJUSTMENTS = {"Adjustments", "adjustments"};
+const ReportField CLOSING_BALANCE = {"Closing Balance", "closing_balance"};
+const ReportField RECONCILE_REPORT = {"Ledger Reconciliation", "ledger_reconciliation"};
+const ReportField THREADS = {"Threads", "threads"};
+const ReportField TRAINERS = {"Trainers Checked", "trainers"};
+const ReportField LEDGER_ENTRIES = {"Ledger Entries", "ledger_entries"};
+const ReportField MISMATCHES = {"Mismatches", "mismatches"};
+const ReportField LEDGER_BALANCE = {"Ledger Balance", "ledger_balance"};
+
+void writeTrainerStatementReport(const TrainerStatementRequest &request, const TrainerStatementResult &result, ReportRenderer &out){
+	out.beginReport(STATEMENT_REPORT);
+	out.field(TRAINER_ID, request.trainerID);
+	out.field(TRAINER_NAME, result.trainerName);
+	out.field(PERIOD_START, request.periodStart.empty() ? "start of ledger" : request.periodStart);
+	out.field(PERIOD_END, request.periodEnd.empty() ? "end of ledger" : request.periodEnd);
+	out.moneyField(OPENING_BALANCE, result.openingBalance);
+	out.beginRows(ENTRIES);
+	for(const LedgerEntry &entry : result.entries){
+		out.beginRow();
+		out.field(DATE, entry.date);
+		out.field(KIND, entry.kind);
+		out.field(INVOICE_NUM, entry.invoiceNum);
+		out.moneyField(AMOUNT, entry.amount);
+		out.moneyField(BALANCE, entry.balance);
+		out.endRow();
+	}
+	out.endRows();
+	out.moneyField(CHARGES, result.charges);
+	out.moneyField(ADJUSTMENTS, result.adjustments);
+	out.moneyField(CLOSING_BALANCE, result.closingBalance);
+	out.endReport();
+}
+
+void writeReconcileReport(const ReconcileRequest &, const ReconcileResult &result, ReportRenderer &out){
+	out.beginReport(RECONCILE_REPORT);
+	out.field(THREADS, result.threads);
+	out.field(TRAINERS, result.trainers);
+	out.field(LEDGER_ENTRIES, result.entries);
+	out.beginRows(MISMATCHES);
+	for(const BalanceMismatch &mismatch : result.mismatches){
+		out.beginRow();
+		out.field(TRAINER_ID, mismatch.trainerID);
+		out.moneyField(BALANCE, mismatch.balance);
+		out.moneyField(LEDGER_BALANCE, mismatch.ledgerBalance);
+		out.field(ENTRIES, mismatch.entries);
+		out.endRow();
+	}
+	out.endRows();
+	out.endReport();
+}
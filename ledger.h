@@ -0,0 +1,65 @@
+/* Program name: ledger.h
+* Purpose: Declares trainer account statements and ledger reconciliation. Every change to trainer_card.balance appends a trainer_ledger entry in the same
+*  transaction (an adjustment from the menu, or one entry per sale), so a statement for any date range is read from one trainer's ledger entries through
+*  the trainer_ledger_trainer_epoch index instead of being rebuilt from invoices. Reconciliation checks that every balance equals the sum of its ledger,
+*  splitting the trainers into trainer_id ranges that are checked on separate threads, each reading through its own connection.
+*/
+
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+//Entries dated from periodStart up to but not including periodEnd ("YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS"). An empty date leaves that end of the range open
+struct TrainerStatementRequest{
+	int trainerID;
+	std::string periodStart, periodEnd;
+};
+
+struct LedgerEntry{
+	sqlite3_int64 ledgerID;
+	std::string date, kind; //kind is opening, sale or adjustment
+	int invoiceNum; //0 unless kind is sale
+	double amount, balance; //balance is the trainer's balance after the entry
+};
+
+struct TrainerStatementResult : OpResult{
+	std::string trainerName;
+	double openingBalance = 0; //Balance after the last entry before the period
+	double closingBalance = 0;
+	double charges = 0; //Sales in the period
+	double adjustments = 0; //Every other change in the period
+	std::vector<LedgerEntry> entries; //In the order they were written
+};
+
+TrainerStatementResult getTrainerStatement(sqlite3 *, const TrainerStatementRequest &);
+
+void writeTrainerStatementReport(const TrainerStatementRequest &, const TrainerStatementResult &, ReportRenderer &);
+
+struct ReconcileRequest{
+	int threads = 0; //0 uses one thread per hardware thread
+};
+
+//A trainer whose balance is not the sum of their ledger
+struct BalanceMismatch{
+	int trainerID;
+	double balance, ledgerBalance;
+	sqlite3_int64 entries;
+};
+
+//mismatches is ordered by trainer_id. A balance is trusted to within half a cent of its ledger, since both are stored as reals
+struct ReconcileResult : OpResult{
+	sqlite3_int64 trainers = 0, entries = 0;
+	std::vector<BalanceMismatch> mismatches;
+	int threads = 0;
+};
+
+ReconcileResult reconcileLedger(sqlite3 *, const ReconcileRequest &);
+
+void writeReconcileReport(const ReconcileRequest &, const ReconcileResult &, ReportRenderer &);
+
+#endif
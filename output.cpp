@@ -0,0 +1,336 @@
+/* Program name: output.cpp
+* Purpose: Implements the libpokemart output subsystem: the report buffer and writer, and the text, CSV and JSON renderers.
+*/
+
+#include "output.h"
+#include <charconv>
+
+const std::string_view REPORT_RULE = "//////////////////////////////////////////////////////////\n"; //Line printed above and below each text report
+
+ReportBuffer &ReportBuffer::appendInt(sqlite3_int64 value){
+	char digits[24];
+	std::to_chars_result converted = std::to_chars(digits, digits + sizeof(digits), value);
+	text.append(digits, converted.ptr);
+	return *this;
+}
+
+ReportBuffer &ReportBuffer::appendFixed(double value, int precision){
+	char digits[352]; //Large enough for any double printed in fixed notation with a small precision
+	std::to_chars_result converted = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, precision);
+	text.append(digits, converted.ptr);
+	return *this;
+}
+
+void ReportWriter::flush(){
+	if(pending.size() > 0){
+		std::string_view text = pending.view();
+		stream.write(text.data(), text.size());
+		pending.clear();
+	}
+	stream.flush();
+}
+
+bool parseReportFormat(std::string_view name, ReportFormat &format){
+	if(name == "text"){format = ReportFormat::TEXT;}
+	else if(name == "csv"){format = ReportFormat::CSV;}
+	else if(name == "json"){format = ReportFormat::JSON;}
+	else{return false;}
+	return true;
+}
+
+//The menu layout: a ruled block with one "Label: value" per line, and each row as its first field followed by its other fields indented underneath
+class TextRenderer : public ReportRenderer{
+public:
+	using ReportRenderer::ReportRenderer;
+
+	void beginReport(const ReportField &title) override {
+		out.append(REPORT_RULE).append(title.label).append(":\n");
+	}
+	void field(const ReportField &name, std::string_view value) override {
+		beginField(name);
+		out.append(value);
+		endField();
+	}
+	void field(const ReportField &name, sqlite3_int64 value) override {
+		beginField(name);
+		out.appendInt(value);
+		endField();
+	}
+	void moneyField(const ReportField &name, double value) override {
+		beginField(name);
+		out.append('$').appendFixed(value);
+		endField();
+	}
+	void decimalField(const ReportField &name, double value) override {
+		beginField(name);
+		out.appendFixed(value);
+		endField();
+	}
+	void beginRows(const ReportField &section) override {
+		out.append(section.label).append(":\n");
+	}
+	void beginRow() override {
+		inRow = true;
+		firstInRow = true;
+	}
+	void endRow() override {
+		out.append('\n');
+		inRow = false;
+		ReportRenderer::endRow();
+	}
+	void endRows() override {}
+	void endReport() override {
+		out.append(REPORT_RULE).append('\n');
+	}
+
+private:
+	bool inRow = false, firstInRow = false;
+
+	//Row fields after the first are indented under it
+	void beginField(const ReportField &name){
+		if(inRow && !firstInRow){out.append("\n\t");}
+		firstInRow = false;
+		out.append(name.label).append(": ");
+	}
+	//Header and footer fields get a line each
+	void endField(){
+		if(!inRow){out.append('\n');}
+	}
+};
+
+//One CSV line per row. The header fields of the report are repeated at the start of each of its rows so every line stands on its own (e.g. for sort or
+//grep), and the column names are written once, before the first row. Footer fields such as totals are left out since they can be derived from the rows.
+//A report with more than one section of rows (analytics) starts a new table for each after the first: a blank line, then that section's column names.
+//Fields written between two sections are added to the header fields repeated on the later section's rows
+class CsvRenderer : public ReportRenderer{
+public:
+	using ReportRenderer::ReportRenderer;
+
+	void beginReport(const ReportField &) override {
+		if(sectionsInReport > 1){wroteColumns = false;} //The last report ended on another section's columns
+		headerCells.clear();
+		headerColumns.clear();
+		betweenCells.clear();
+		betweenColumns.clear();
+		sectionsInReport = 0;
+		rowsInReport = 0;
+		inRows = false;
+		afterRows = false;
+	}
+	void field(const ReportField &name, std::string_view value) override {
+		ReportBuffer *target = beginCell(name);
+		if(target != NULL){appendEscaped(*target, value);}
+	}
+	void field(const ReportField &name, sqlite3_int64 value) override {
+		ReportBuffer *target = beginCell(name);
+		if(target != NULL){target->appendInt(value);}
+	}
+	void moneyField(const ReportField &name, double value) override {
+		ReportBuffer *target = beginCell(name);
+		if(target != NULL){target->appendFixed(value);}
+	}
+	void decimalField(const ReportField &name, double value) override {
+		moneyField(name, value);
+	}
+	void beginRows(const ReportField &) override {
+		if(++sectionsInReport > 1){
+			wroteColumns = false;
+			appendCells(headerCells, betweenCells.view());
+			appendCells(headerColumns, betweenColumns.view());
+			betweenCells.clear();
+			betweenColumns.clear();
+		}
+		inRows = true;
+	}
+	void beginRow() override {
+		firstCell = true;
+		rowsInReport++;
+		if(!wroteColumns){
+			firstRow.clear();
+			rowColumns.clear();
+		}
+		target().append(headerCells.view());
+		firstCell = headerCells.size() == 0;
+	}
+	void endRow() override {
+		if(!wroteColumns){
+			writeColumns(rowColumns.view());
+			out.append(firstRow.view());
+		}
+		out.append('\n');
+		ReportRenderer::endRow();
+	}
+	void endRows() override {
+		inRows = false;
+		afterRows = true;
+	}
+	void endReport() override {
+		if(rowsInReport == 0 && headerCells.size() > 0){ //A report without rows is written as its header fields alone
+			if(!wroteColumns){writeColumns(std::string_view());}
+			out.append(headerCells.view()).append('\n');
+		}
+	}
+
+private:
+	ReportBuffer headerCells, headerColumns, rowColumns, firstRow; //Reused between reports, so they stop allocating after the first
+	ReportBuffer betweenCells, betweenColumns; //Fields since the last section, kept in case another section follows
+	bool wroteColumns = false, wroteTable = false;
+	bool inRows = false, afterRows = false, firstCell = true;
+	int sectionsInReport = 0, rowsInReport = 0;
+
+	//Until the column names have been written, the first row is held back so its columns can be named first
+	ReportBuffer &target(){
+		return wroteColumns ? out : firstRow;
+	}
+
+	//Returns where the cell's value should be written, or NULL if the field is dropped
+	ReportBuffer *beginCell(const ReportField &name){
+		if(afterRows && !inRows){
+			if(betweenCells.size() > 0){betweenCells.append(',');}
+			if(betweenColumns.size() > 0){betweenColumns.append(',');}
+			betweenColumns.append(name.key);
+			return &betweenCells;
+		}
+		if(!inRows){
+			if(headerCells.size() > 0){headerCells.append(',');}
+			if(headerColumns.size() > 0){headerColumns.append(',');}
+			headerColumns.append(name.key);
+			return &headerCells;
+		}
+		ReportBuffer &row = target();
+		if(!firstCell){row.append(',');}
+		firstCell = false;
+		if(!wroteColumns){
+			if(rowColumns.size() > 0){rowColumns.append(',');}
+			rowColumns.append(name.key);
+		}
+		return &row;
+	}
+
+	void writeColumns(std::string_view columns){
+		if(wroteTable){out.append('\n');}
+		wroteTable = true;
+		out.append(headerColumns.view());
+		if(headerColumns.size() > 0 && columns.size() > 0){out.append(',');}
+		out.append(columns).append('\n');
+		wroteColumns = true;
+	}
+
+	static void appendCells(ReportBuffer &buffer, std::string_view cells){
+		if(cells.empty()){return;}
+		if(buffer.size() > 0){buffer.append(',');}
+		buffer.append(cells);
+	}
+
+	//Quotes a value if it contains a comma, quote or line break, doubling any quotes inside it
+	static void appendEscaped(ReportBuffer &buffer, std::string_view value){
+		if(value.find_first_of(",\"\r\n") == std::string_view::npos){
+			buffer.append(value);
+			return;
+		}
+		buffer.append('"');
+		for(char c : value){
+			if(c == '"'){buffer.append('"');}
+			buffer.append(c);
+		}
+		buffer.append('"');
+	}
+};
+
+//One JSON object per report, on its own line (JSON Lines), so a stream of reports can be read one line at a time
+class JsonRenderer : public ReportRenderer{
+public:
+	using ReportRenderer::ReportRenderer;
+
+	void beginReport(const ReportField &title) override {
+		out.append("{\"report\":");
+		appendString(title.key);
+		needComma = true;
+	}
+	void field(const ReportField &name, std::string_view value) override {
+		beginMember(name);
+		appendString(value);
+	}
+	void field(const ReportField &name, sqlite3_int64 value) override {
+		beginMember(name);
+		out.appendInt(value);
+	}
+	void moneyField(const ReportField &name, double value) override {
+		beginMember(name);
+		out.appendFixed(value);
+	}
+	void decimalField(const ReportField &name, double value) override {
+		moneyField(name, value);
+	}
+	void beginRows(const ReportField &section) override {
+		beginMember(section);
+		out.append('[');
+		firstRow = true;
+	}
+	void beginRow() override {
+		if(!firstRow){out.append(',');}
+		firstRow = false;
+		out.append('{');
+		needComma = false;
+	}
+	void endRow() override {
+		out.append('}');
+		ReportRenderer::endRow();
+	}
+	void endRows() override {
+		out.append(']');
+		needComma = true;
+	}
+	void endReport() override {
+		out.append("}\n");
+	}
+
+private:
+	bool needComma = false, firstRow = true;
+
+	void beginMember(const ReportField &name){
+		if(needComma){out.append(',');}
+		needComma = true;
+		appendString(name.key);
+		out.append(':');
+	}
+
+	void appendString(std::string_view value){
+		static const char HEX[] = "0123456789abcdef";
+		out.append('"');
+		for(char c : value){
+			switch(c){
+			case '"': out.append("\\\""); break;
+			case '\\': out.append("\\\\"); break;
+			case '\n': out.append("\\n"); break;
+			case '\r': out.append("\\r"); break;
+			case '\t': out.append("\\t"); break;
+			default:
+				if(static_cast<unsigned char>(c) < 0x20){
+					out.append("\\u00").append(HEX[(c >> 4) & 0xF]).append(HEX[c & 0xF]);
+				}
+				else{
+					out.append(c);
+				}
+			}
+		}
+		out.append('"');
+	}
+};
+
+std::unique_ptr<ReportRenderer> makeRenderer(ReportFormat format, ReportWriter &writer){
+	switch(format){
+	case ReportFormat::CSV: return std::make_unique<CsvRenderer>(writer);
+	case ReportFormat::JSON: return std::make_unique<JsonRenderer>(writer);
+	case ReportFormat::TEXT: break;
+	}
+	return std::make_unique<TextRenderer>(writer);
+}
+
+void StampedRenderer::beginReport(const ReportField &title){
+	inner.beginReport(title);
+	for(const Stamp &stamp : stamps){
+		if(stamp.isNumber){inner.field(stamp.name, stamp.number);}
+		else{inner.field(stamp.name, stamp.text);}
+	}
+}
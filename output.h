@@ -0,0 +1,120 @@
+/* Program name: output.h
+* Purpose: The libpokemart output subsystem. Reports are described to a ReportRenderer as titled sections of named fields, and the renderer formats them as
+*  text, CSV or JSON into the buffer of a ReportWriter. The writer only touches its stream when flushed (once per report, or in large chunks for very large
+*  reports), so a report with thousands of rows costs a handful of writes instead of one flush per line.
+*/
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sqlite3.h>
+
+//A growable text buffer. clear() keeps the capacity, so a reused buffer stops allocating once it has grown to the size of the largest report
+class ReportBuffer{
+public:
+	void clear(){text.clear();}
+	void reserve(size_t bytes){text.reserve(bytes);}
+	ReportBuffer &append(std::string_view value){text.append(value); return *this;}
+	ReportBuffer &append(char value){text.push_back(value); return *this;}
+	ReportBuffer &appendInt(sqlite3_int64);
+	ReportBuffer &appendFixed(double, int precision = 2); //Formats like std::fixed << std::setprecision(precision)
+	std::string_view view() const {return text;}
+	size_t size() const {return text.size();}
+
+private:
+	std::string text;
+};
+
+//Buffers output for a stream and writes it with a single call per flush
+class ReportWriter{
+public:
+	static const size_t DEFAULT_FLUSH_THRESHOLD = 64 * 1024;
+
+	explicit ReportWriter(std::ostream &stream, size_t flushThreshold = DEFAULT_FLUSH_THRESHOLD) : stream(stream), flushThreshold(flushThreshold) {}
+	~ReportWriter(){flush();}
+	ReportWriter(const ReportWriter &) = delete;
+	ReportWriter &operator=(const ReportWriter &) = delete;
+
+	ReportBuffer &buffer(){return pending;}
+	void flush(); //Writes everything buffered so far and flushes the stream
+	void flushIfFull(){if(pending.size() >= flushThreshold){flush();}} //Lets very large reports go out in chunks instead of all at the end
+
+private:
+	std::ostream &stream;
+	size_t flushThreshold;
+	ReportBuffer pending;
+};
+
+enum class ReportFormat {TEXT, CSV, JSON};
+
+//Parses "text", "csv" or "json". Returns false and leaves format unchanged for anything else
+bool parseReportFormat(std::string_view, ReportFormat &format);
+
+//Every report field has a label for people (text output) and a key for programs (CSV column names and JSON keys)
+struct ReportField{
+	std::string_view label;
+	std::string_view key;
+};
+
+//Receives a report as: beginReport, header fields, any number of row sections (beginRows, rows of fields, endRows), footer fields, endReport. Text values
+//only have to stay valid for the duration of the call, so rows can be passed straight from rowmap.h string_views
+class ReportRenderer{
+public:
+	explicit ReportRenderer(ReportWriter &writer) : writer(writer), out(writer.buffer()) {}
+	virtual ~ReportRenderer() = default;
+
+	virtual void beginReport(const ReportField &title) = 0;
+	virtual void field(const ReportField &, std::string_view value) = 0;
+	virtual void field(const ReportField &, sqlite3_int64 value) = 0;
+	virtual void moneyField(const ReportField &, double value) = 0; //Dollar amounts, always shown with two decimal places
+	virtual void decimalField(const ReportField &, double value) = 0; //Other fractional amounts such as hours, also shown with two decimal places
+	virtual void beginRows(const ReportField &section) = 0;
+	virtual void beginRow() = 0;
+	virtual void endRow(){writer.flushIfFull();}
+	virtual void endRows() = 0;
+	virtual void endReport() = 0;
+
+protected:
+	ReportWriter &writer;
+	ReportBuffer &out;
+};
+
+std::unique_ptr<ReportRenderer> makeRenderer(ReportFormat, ReportWriter &);
+
+//Passes reports through to another renderer, adding the same header fields to each one right after its title. Used to stamp reports with facts about
+//where their data came from, such as the age of a replica, without the report writers knowing about it
+class StampedRenderer : public ReportRenderer{
+public:
+	StampedRenderer(ReportWriter &writer, ReportRenderer &inner) : ReportRenderer(writer), inner(inner) {}
+
+	void stamp(const ReportField &name, std::string_view value){stamps.push_back({name, std::string(value), 0, false});}
+	void stamp(const ReportField &name, sqlite3_int64 value){stamps.push_back({name, std::string(), value, true});}
+
+	void beginReport(const ReportField &title) override;
+	void field(const ReportField &name, std::string_view value) override {inner.field(name, value);}
+	void field(const ReportField &name, sqlite3_int64 value) override {inner.field(name, value);}
+	void moneyField(const ReportField &name, double value) override {inner.moneyField(name, value);}
+	void decimalField(const ReportField &name, double value) override {inner.decimalField(name, value);}
+	void beginRows(const ReportField &section) override {inner.beginRows(section);}
+	void beginRow() override {inner.beginRow();}
+	void endRow() override {inner.endRow();}
+	void endRows() override {inner.endRows();}
+	void endReport() override {inner.endReport();}
+
+private:
+	struct Stamp{
+		ReportField name;
+		std::string text;
+		sqlite3_int64 number;
+		bool isNumber;
+	};
+	ReportRenderer &inner;
+	std::vector<Stamp> stamps;
+};
+
+#endif
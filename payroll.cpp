@@ -0,0 +1,207 @@
+/* Program name: payroll.cpp
+* Purpose: Implements the payroll engine declared in payroll.h. Each thread opens its own read-only connection to the database file and pays one emp_id
+*  range. Within a range, shifts come back ordered by emp_id (from the shift_emp_date index), so each employee's total is finished as soon as the next
+*  employee's first shift is read, and nothing is held in memory per shift.
+*/
+
+#include "payroll.h"
+#include "pokemart_internal.h"
+#include "rowmap.h"
+#include <map>
+#include <thread>
+
+//One emp_id range of a payroll run and what was paid in it
+struct PayrollPartition{
+	sqlite3_int64 firstEmp, lastEmp; //Inclusive
+	std::vector<EmployeePay> employees;
+	std::map<int, MartPay> marts;
+	sqlite3_int64 shifts = 0;
+	OpResult status;
+};
+
+//Pays every shift of one emp_id range over an open connection
+static void payPartition(sqlite3 *db, const PayrollRequest &request, PayrollPartition &part){
+	sqlite3_stmt *res;
+	std::string query = "SELECT s.emp_id, s.mart_id, s.hours_worked, s.hours_worked * c.cert_payrate FROM shift s JOIN certification c ON s.cert_id = c.cert_id ";
+	query += "WHERE s.emp_id BETWEEN @firstEmp AND @lastEmp AND s.shift_date >= @periodStart AND s.shift_date < @periodEnd ORDER BY s.emp_id";
+	int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(part.status, db, res, "Error selecting shifts for payroll");
+		return;
+	}
+	rc = sqlite3_bind_int64(res, sqlite3_bind_parameter_index(res, "@firstEmp"), part.firstEmp);
+	if(rc == SQLITE_OK){rc = sqlite3_bind_int64(res, sqlite3_bind_parameter_index(res, "@lastEmp"), part.lastEmp);}
+	if(rc == SQLITE_OK){rc = sqlite3_bind_text(res, sqlite3_bind_parameter_index(res, "@periodStart"), request.periodStart.c_str(), -1, SQLITE_STATIC);}
+	if(rc == SQLITE_OK){rc = sqlite3_bind_text(res, sqlite3_bind_parameter_index(res, "@periodEnd"), request.periodEnd.c_str(), -1, SQLITE_STATIC);}
+	if(rc != SQLITE_OK){
+		fail(part.status, db, res, "Error binding payroll parameters");
+		return;
+	}
+
+	MartPay *mart = NULL; //Consecutive shifts are usually at the same PokeMart, so the last one is checked before the map
+	rc = forEachRow<int, int, double, double>(res, [&](int empID, int martID, double hours, double pay){
+		if(part.employees.empty() || part.employees.back().empID != empID){
+			part.employees.push_back({empID, 0, 0, 0});
+		}
+		EmployeePay &employee = part.employees.back();
+		employee.shifts++;
+		employee.hours += hours;
+		employee.pay += pay;
+
+		if(mart == NULL || mart->martID != martID){
+			mart = &part.marts.try_emplace(martID, MartPay{martID, 0, 0, 0}).first->second;
+		}
+		mart->shifts++;
+		mart->hours += hours;
+		mart->pay += pay;
+		part.shifts++;
+	});
+	if(rc != SQLITE_DONE){
+		fail(part.status, db, res, "Error reading shifts for payroll");
+		return;
+	}
+	sqlite3_finalize(res);
+}
+
+//Runs one partition on its own thread and connection. Connections are not shared between threads so that the reads run in parallel
+static void payPartitionOnThread(const std::string &path, const PayrollRequest &request, PayrollPartition &part){
+	sqlite3 *db;
+	int rc = sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+	if(rc != SQLITE_OK){
+		fail(part.status, db, NULL, "Error opening database for payroll");
+		sqlite3_close(db);
+		return;
+	}
+	sqlite3_busy_timeout(db, 5000);
+	payPartition(db, request, part);
+	sqlite3_close(db);
+}
+
+PayrollResult runPayroll(sqlite3 *db, const PayrollRequest &request){
+	PayrollResult result;
+	if(!validDate(request.periodStart) || !validDate(request.periodEnd)){
+		fail(result, "Pay period dates must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return result;
+	}
+	if(request.periodStart >= request.periodEnd){
+		fail(result, "The pay period must end after it starts");
+		return result;
+	}
+
+	//The emp_id range that has shifts is split evenly between the threads
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "SELECT MIN(emp_id), MAX(emp_id) FROM shift", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error reading employee range for payroll");
+		return result;
+	}
+	rc = sqlite3_step(res);
+	if(rc != SQLITE_ROW){
+		fail(result, db, res, "Error reading employee range for payroll");
+		return result;
+	}
+	bool noShifts = sqlite3_column_type(res, 0) == SQLITE_NULL;
+	sqlite3_int64 firstEmp = sqlite3_column_int64(res, 0);
+	sqlite3_int64 lastEmp = sqlite3_column_int64(res, 1);
+	sqlite3_finalize(res);
+	if(noShifts){return result;}
+
+	//Threads need the database file to open their own connections, so an in-memory database is paid on the caller's connection
+	const char *filename = sqlite3_db_filename(db, "main");
+	std::string path = filename == NULL ? "" : filename;
+	sqlite3_int64 threads = request.threads > 0 ? request.threads : std::thread::hardware_concurrency();
+	if(threads < 1 || path.empty()){threads = 1;}
+	if(threads > lastEmp - firstEmp + 1){threads = lastEmp - firstEmp + 1;}
+	result.threads = threads;
+
+	std::vector<PayrollPartition> parts(threads);
+	sqlite3_int64 span = (lastEmp - firstEmp + 1) / threads;
+	for(sqlite3_int64 i = 0; i < threads; i++){
+		parts[i].firstEmp = firstEmp + i * span;
+		parts[i].lastEmp = i == threads - 1 ? lastEmp : parts[i].firstEmp + span - 1;
+	}
+
+	if(threads == 1){
+		payPartition(db, request, parts[0]);
+	}
+	else{
+		std::vector<std::thread> workers;
+		for(PayrollPartition &part : parts){
+			workers.emplace_back(payPartitionOnThread, std::cref(path), std::cref(request), std::ref(part));
+		}
+		for(std::thread &worker : workers){
+			worker.join();
+		}
+	}
+
+	//The partitions are in emp_id order, so appending them keeps the employees sorted
+	std::map<int, MartPay> marts;
+	for(PayrollPartition &part : parts){
+		if(!part.status.ok()){
+			static_cast<OpResult &>(result) = part.status;
+			return result;
+		}
+		result.employees.insert(result.employees.end(), part.employees.begin(), part.employees.end());
+		for(const auto &[martID, pay] : part.marts){
+			MartPay &total = marts.try_emplace(martID, MartPay{martID, 0, 0, 0}).first->second;
+			total.shifts += pay.shifts;
+			total.hours += pay.hours;
+			total.pay += pay.pay;
+		}
+		result.shifts += part.shifts;
+	}
+	for(const auto &[martID, pay] : marts){
+		result.marts.push_back(pay);
+		result.hours += pay.hours;
+		result.pay += pay.pay;
+	}
+	return result;
+}
+
+//Report fields
+const ReportField PAYROLL_REPORT = {"Payroll", "payroll"};
+const ReportField PERIOD_START = {"Period Start", "period_start"};
+const ReportField PERIOD_END = {"Period End (exclusive)", "period_end"};
+const ReportField EMPLOYEES = {"Employees", "employees"};
+const ReportField MARTS = {"PokeMarts", "marts"};
+const ReportField EMP_ID = {"Employee ID", "emp_id"};
+const ReportField MART_ID = {"PokeMart ID", "mart_id"};
+const ReportField SHIFTS = {"Shifts", "shifts"};
+const ReportField HOURS = {"Hours", "hours"};
+const ReportField PAY = {"Pay", "pay"};
+const ReportField TOTAL_SHIFTS = {"Total Shifts", "total_shifts"};
+const ReportField TOTAL_HOURS = {"Total Hours", "total_hours"};
+const ReportField TOTAL_PAY = {"Total Pay", "total_pay"};
+
+void writePayrollReport(const PayrollRequest &request, const PayrollResult &result, PayrollView view, ReportRenderer &out){
+	out.beginReport(PAYROLL_REPORT);
+	out.field(PERIOD_START, request.periodStart);
+	out.field(PERIOD_END, request.periodEnd);
+	if(view == PayrollView::EMPLOYEES){
+		out.beginRows(EMPLOYEES);
+		for(const EmployeePay &employee : result.employees){
+			out.beginRow();
+			out.field(EMP_ID, employee.empID);
+			out.field(SHIFTS, employee.shifts);
+			out.decimalField(HOURS, employee.hours);
+			out.moneyField(PAY, employee.pay);
+			out.endRow();
+		}
+	}
+	else{
+		out.beginRows(MARTS);
+		for(const MartPay &mart : result.marts){
+			out.beginRow();
+			out.field(MART_ID, mart.martID);
+			out.field(SHIFTS, mart.shifts);
+			out.decimalField(HOURS, mart.hours);
+			out.moneyField(PAY, mart.pay);
+			out.endRow();
+		}
+	}
+	out.endRows();
+	out.field(TOTAL_SHIFTS, result.shifts);
+	out.decimalField(TOTAL_HOURS, result.hours);
+	out.moneyField(TOTAL_PAY, result.pay);
+	out.endReport();
+}
@@ -0,0 +1,51 @@
+/* Program name: payroll.h
+* Purpose: Declares the payroll engine. A payroll run covers one pay period and streams every shift in it, joined with the certification it was worked
+*  under, in a single pass. Pay is hours_worked * cert_payrate, totalled per employee, per PokeMart and for the whole period. The employees are split into
+*  emp_id ranges that are paid on separate threads, each reading through its own connection.
+*/
+
+#ifndef PAYROLL_H
+#define PAYROLL_H
+
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+//Shifts dated from periodStart up to but not including periodEnd are paid ("YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS")
+struct PayrollRequest{
+	std::string periodStart, periodEnd;
+	int threads = 0; //0 uses one thread per hardware thread
+};
+
+struct EmployeePay{
+	int empID;
+	int shifts;
+	double hours, pay;
+};
+
+struct MartPay{
+	int martID;
+	int shifts;
+	double hours, pay;
+};
+
+//employees is ordered by emp_id and marts by mart_id. Employees and PokeMarts without shifts in the period are left out
+struct PayrollResult : OpResult{
+	std::vector<EmployeePay> employees;
+	std::vector<MartPay> marts;
+	sqlite3_int64 shifts = 0;
+	double hours = 0, pay = 0;
+	int threads = 0; //Threads the run was split across
+};
+
+PayrollResult runPayroll(sqlite3 *, const PayrollRequest &);
+
+//Which breakdown of a payroll run a report lists, one row each
+enum class PayrollView {EMPLOYEES, MARTS};
+
+//Renders the pay period, one row per employee or PokeMart, and the totals for the period
+void writePayrollReport(const PayrollRequest &, const PayrollResult &, PayrollView, ReportRenderer &);
+
+#endif
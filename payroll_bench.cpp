@@ -0,0 +1,113 @@
+/* Program name: payroll_bench.cpp
+* Purpose: Benchmarks the payroll engine (payroll.h). Builds a database from tables.sql with 100,000 employees and 10 shifts each in a two week pay
+*  period, then times a payroll run with 1, 2 and 4 threads and one per hardware thread, and checks that every run pays the same total.
+*  Usage: payroll_bench [database_path] [employees] (the database is rebuilt on every run)
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "payroll.h"
+
+const int SHIFTS_PER_EMPLOYEE = 10;
+const int MARTS = 50;
+const int CERTIFICATIONS = 5;
+
+//Creates the schema from tables.sql and fills it with employees, certifications and shifts
+static bool buildDatabase(sqlite3 *db, int employees){
+	std::ifstream tablesFile("tables.sql");
+	if(!tablesFile){
+		std::cerr << "tables.sql not found; run the benchmark from the source directory\n";
+		return false;
+	}
+	std::stringstream tables;
+	tables << tablesFile.rdbuf();
+	if(sqlite3_exec(db, tables.str().c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error creating schema: " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+
+	sqlite3_exec(db, "BEGIN", NULL, NULL, NULL);
+	for(int cert = 1; cert <= CERTIFICATIONS; cert++){
+		std::string sql = "INSERT INTO certification (cert_payrate, cert_descript, cert_title) VALUES (" + std::to_string(10 + cert * 2.5) + ", 'Benchmark', 'Level " + std::to_string(cert) + "')";
+		sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL);
+	}
+
+	sqlite3_stmt *employee, *shift;
+	sqlite3_prepare_v2(db, "INSERT INTO employee (emp_fname, emp_lname, emp_phone) VALUES ('Bench', @lname, '555-0000')", -1, &employee, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO shift (emp_id, hours_worked, mart_id, cert_id, shift_date) VALUES (@empID, @hours, @martID, @certID, @shiftDate)", -1, &shift, NULL);
+	char shiftDate[32];
+	for(int emp = 1; emp <= employees; emp++){
+		std::string lname = std::to_string(emp);
+		sqlite3_bind_text(employee, 1, lname.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_step(employee);
+		sqlite3_reset(employee);
+		for(int day = 1; day <= SHIFTS_PER_EMPLOYEE; day++){
+			std::snprintf(shiftDate, sizeof(shiftDate), "2024-03-%02d 09:00:00", day);
+			sqlite3_bind_int(shift, 1, emp);
+			sqlite3_bind_double(shift, 2, 4 + (emp + day) % 5);
+			sqlite3_bind_int(shift, 3, 1 + (emp % MARTS));
+			sqlite3_bind_int(shift, 4, 1 + (emp % CERTIFICATIONS));
+			sqlite3_bind_text(shift, 5, shiftDate, -1, SQLITE_STATIC);
+			sqlite3_step(shift);
+			sqlite3_reset(shift);
+		}
+	}
+	sqlite3_finalize(employee);
+	sqlite3_finalize(shift);
+	if(sqlite3_exec(db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error filling benchmark database: " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]){
+	std::string path = argc > 1 ? argv[1] : "payroll_bench.db";
+	int employees = argc > 2 ? std::atoi(argv[2]) : 100000;
+	std::remove(path.c_str());
+
+	sqlite3 *db;
+	if(sqlite3_open(path.c_str(), &db) != SQLITE_OK){
+		std::cerr << "Error opening " << path << ": " << sqlite3_errmsg(db) << '\n';
+		return 1;
+	}
+	auto start = std::chrono::steady_clock::now();
+	if(!buildDatabase(db, employees)){
+		sqlite3_close(db);
+		return 1;
+	}
+	std::chrono::duration<double> built = std::chrono::steady_clock::now() - start;
+	std::cout << "Built " << employees << " employees and " << employees * SHIFTS_PER_EMPLOYEE << " shifts in " << built.count() << " s\n";
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::vector<int> threadCounts = {1, 2, 4, static_cast<int>(std::thread::hardware_concurrency())};
+	double firstPay = -1;
+	int exitCode = 0;
+	for(int threads : threadCounts){
+		PayrollRequest request{"2024-03-01", "2024-03-15", threads};
+		start = std::chrono::steady_clock::now();
+		PayrollResult result = runPayroll(db, request);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if(!result.ok()){
+			std::cerr << result.error << '\n';
+			exitCode = 1;
+			break;
+		}
+		std::cout << "threads " << result.threads << ": " << result.employees.size() << " employees, " << result.shifts << " shifts, $" << result.pay
+			<< " in " << elapsed.count() << " s (" << static_cast<long long>(result.shifts / elapsed.count()) << " shifts/s)\n";
+		if(firstPay < 0){firstPay = result.pay;}
+		else if(std::fabs(result.pay - firstPay) > 0.005){
+			std::cerr << "Total pay differs between thread counts\n";
+			exitCode = 1;
+		}
+	}
+	sqlite3_close(db);
+	return exitCode;
+}
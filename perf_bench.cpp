@@ -0,0 +1,198 @@
+/* Program name: perf_bench.cpp
+* Purpose: Measures throughput of the sale and report paths, and is the training run for the profile-guided build (make pgo). Builds a database from
+*  tables.sql and inserts.sql with enough stock and money that no sale triggers a vendor reorder, then times recordSale over one and three line baskets
+*  at every PokeMart, writeInvoiceReport over the invoices those sales made, and getTrainerStatement for every trainer. Each result is printed as
+*  "name operations_per_second", the best of ROUNDS runs on a freshly built database, since a slower run only says something else was using the machine.
+*  Durability is turned off so the numbers measure the program rather than the disk.
+*  With a baseline file, every result is also compared with the one stored there and the run fails if any is more than the tolerance slower. record
+*  writes the results as the new baseline.
+*  Usage: perf_bench [check|record <baseline_file> [tolerance_percent]] (run from the source directory; perf_bench.db is rebuilt on every run)
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "pokemart.h"
+#include "report.h"
+#include "ledger.h"
+
+const int ROUNDS = 3;
+const int SALES = 3000;
+const int MARTS = 5;
+const int TRAINERS = 5;
+const int REPORT_PASSES = 3; //Invoice reports are fast, so each invoice is written this many times
+const int STATEMENT_PASSES = 200;
+const double DEFAULT_TOLERANCE = 20; //Percent. Best-of-three runs on a busy machine still vary by about 15%
+
+//Runs one sql file from the source directory
+static bool runFile(sqlite3 *db, const std::string &fileName){
+	std::ifstream file(fileName);
+	if(!file){
+		std::cerr << fileName << " not found; run the benchmark from the source directory\n";
+		return false;
+	}
+	std::stringstream sql;
+	sql << file.rdbuf();
+	if(sqlite3_exec(db, sql.str().c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error running " << fileName << ": " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+//Gives every PokeMart plenty of every product and enough money that no sale reorders
+static bool buildDatabase(sqlite3 *db){
+	if(!runFile(db, "tables.sql") || !runFile(db, "inserts.sql")){return false;}
+	std::string sql = "INSERT INTO stock_history (prod_code, mart_id, stock_qty, stock_date) SELECT prod_code, mart_id, 1000000000, '2024-03-01 00:00:00' FROM product, pokemart;";
+	sql += "INSERT INTO mart_balance_history (balance, mart_id, balance_date) SELECT 1000000000, mart_id, '2024-03-01 00:00:00' FROM pokemart;";
+	if(sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error stocking benchmark database: " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+typedef std::map<std::string, double> Results; //Operations per second by benchmark name
+
+static double perSecond(int operations, std::chrono::steady_clock::time_point start){
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return operations / elapsed.count();
+}
+
+static bool runWorkload(sqlite3 *db, Results &results){
+	const SaleLine products[] = {{"PB", 1}, {"GB", 2}, {"UB", 1}, {"BP", 3}, {"SP", 1}};
+	std::vector<int> invoices;
+	invoices.reserve(SALES);
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < SALES; i++){
+		SaleRequest request{i % TRAINERS + 1, 1, i % MARTS + 1, {products[i % 5]}};
+		if(i % 2 == 1){
+			request.basket.push_back(products[(i + 1) % 5]);
+			request.basket.push_back(products[(i + 2) % 5]);
+		}
+		SaleResult result = recordSale(db, request);
+		if(!result.ok()){
+			std::cerr << result.error << '\n';
+			return false;
+		}
+		invoices.push_back(result.invoiceNum);
+	}
+	results["sales"] = perSecond(SALES, start);
+
+	std::ostringstream sink;
+	ReportWriter writer(sink);
+	std::unique_ptr<ReportRenderer> renderer = makeRenderer(ReportFormat::TEXT, writer);
+	start = std::chrono::steady_clock::now();
+	for(int pass = 0; pass < REPORT_PASSES; pass++){
+		for(int invoiceNum : invoices){
+			OpResult result = writeInvoiceReport(db, {invoiceNum}, *renderer);
+			if(!result.ok()){
+				std::cerr << result.error << '\n';
+				return false;
+			}
+			writer.flush();
+			sink.str("");
+		}
+	}
+	results["invoice_reports"] = perSecond(REPORT_PASSES * invoices.size(), start);
+
+	start = std::chrono::steady_clock::now();
+	for(int pass = 0; pass < STATEMENT_PASSES; pass++){
+		for(int trainerID = 1; trainerID <= TRAINERS; trainerID++){
+			TrainerStatementResult result = getTrainerStatement(db, {trainerID});
+			if(!result.ok()){
+				std::cerr << result.error << '\n';
+				return false;
+			}
+		}
+	}
+	results["trainer_statements"] = perSecond(STATEMENT_PASSES * TRAINERS, start);
+	return true;
+}
+
+//One round on a new database. Keeps the best result of each benchmark in results
+static bool runRound(Results &results){
+	std::string path = "perf_bench.db";
+	std::remove(path.c_str());
+	sqlite3 *db;
+	if(sqlite3_open(path.c_str(), &db) != SQLITE_OK){
+		std::cerr << "Error opening " << path << ": " << sqlite3_errmsg(db) << '\n';
+		sqlite3_close(db);
+		return false;
+	}
+	sqlite3_exec(db, "PRAGMA synchronous = OFF", NULL, NULL, NULL);
+	OpResult prepared;
+	if(buildDatabase(db)){prepared = enableForeignKeys(db);} //Sales pay for the foreign key checks, as they do in main
+	else{prepared.rc = -1;}
+	if(prepared.ok()){prepared = prepareStatements(db);}
+	if(!prepared.ok() && !prepared.error.empty()){std::cerr << prepared.error << '\n';}
+	Results round;
+	bool ok = prepared.ok() && runWorkload(db, round);
+	finalizeStatements(db);
+	sqlite3_close(db);
+	for(const auto &[name, value] : round){
+		if(value > results[name]){results[name] = value;}
+	}
+	return ok;
+}
+
+static bool readBaseline(const std::string &path, Results &baseline){
+	std::ifstream file(path);
+	if(!file){
+		std::cerr << "Cannot read baseline " << path << "; create one with make perf-baseline\n";
+		return false;
+	}
+	std::string name;
+	double value;
+	while(file >> name >> value){baseline[name] = value;}
+	return true;
+}
+
+int main(int argc, char *argv[]){
+	std::string mode = argc > 1 ? argv[1] : "";
+	if((!mode.empty() && mode != "check" && mode != "record") || (!mode.empty() && argc < 3)){
+		std::cerr << "Usage: " << argv[0] << " [check|record <baseline_file> [tolerance_percent]]\n";
+		return 2;
+	}
+	std::string baselinePath = argc > 2 ? argv[2] : "";
+	double tolerance = argc > 3 ? std::atof(argv[3]) : DEFAULT_TOLERANCE;
+
+	Results results;
+	for(int round = 0; round < ROUNDS; round++){
+		if(!runRound(results)){return 1;}
+	}
+
+	for(const auto &[name, value] : results){std::cout << name << ' ' << value << '\n';}
+	if(mode == "record"){
+		std::ofstream file(baselinePath);
+		for(const auto &[name, value] : results){file << name << ' ' << value << '\n';}
+		if(!file){
+			std::cerr << "Cannot write baseline " << baselinePath << '\n';
+			return 1;
+		}
+		std::cout << "Recorded baseline " << baselinePath << '\n';
+		return 0;
+	}
+	if(mode != "check"){return 0;}
+
+	Results baseline;
+	if(!readBaseline(baselinePath, baseline)){return 1;}
+	bool regressed = false;
+	for(const auto &[name, value] : results){
+		auto stored = baseline.find(name);
+		if(stored == baseline.end()){continue;} //A benchmark newer than the baseline has nothing to regress from
+		double change = (value / stored->second - 1) * 100;
+		std::cout << name << ": " << change << "% against baseline " << stored->second << '\n';
+		if(change < -tolerance){
+			std::cerr << name << " is " << -change << "% slower than the baseline (tolerance " << tolerance << "%)\n";
+			regressed = true;
+		}
+	}
+	return regressed ? 1 : 0;
+}
@@ -0,0 +1,580 @@
+/* Program name: pokemart.cpp
+* Purpose: Implements libpokemart. These functions hold the SQL that used to live inside the menu functions of main.cpp. Nothing in here reads from std::cin or
+*  prints to std::cout; failures are reported through the rc and error members of the returned result.
+*/
+
+#include "pokemart.h"
+#include "pokemart_internal.h"
+#include "pricing.h"
+#include "rowmap.h"
+#include "statements.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <regex>
+#include <ctime>
+
+const std::regex PHONE_FORMAT("\\d{3}-\\d{4}"); //Declare a constant regular expression to define the proper phone number formart (###-####)
+const std::regex DATE_FORMAT("\\d{4}-\\d{2}-\\d{2}( \\d{2}:\\d{2}:\\d{2})?"); //Dates and times as stored by the program (YYYY-MM-DD or YYYY-MM-DD HH:MM:SS)
+
+//Internal helpers for recordSale
+static int writeSale(sqlite3 *, const SaleRequest &, SaleResult &);
+static int insertInvoice(sqlite3 *, const SaleRequest &, SaleResult &);
+static int insertLine(sqlite3 *, const SaleRequest &, int, const Timestamp &, const PriceSnapshot &, SaleResult &);
+static int storeInvoiceTotals(sqlite3 *, SaleResult &);
+static int selectProduct(sqlite3 *, int, const SaleLine &, const PriceSnapshot &, SaleLineResult &, int &, double &, OpResult &);
+static int insertStockHistory(sqlite3 *, const std::string &, int, int, const Timestamp &, OpResult &);
+static int chargeTrainer(sqlite3 *, int, const Timestamp &, SaleResult &);
+static int insertMartBalance(sqlite3 *, int, double, const Timestamp &, OpResult &);
+
+int fail(OpResult &result, sqlite3 *db, sqlite3_stmt *res, const std::string &message){
+	result.rc = -1;
+	result.error = message + ": " + sqlite3_errmsg(db); //Grab the message before finalize can clear it
+	if(res != NULL){sqlite3_finalize(res);}
+	return -1;
+}
+
+int fail(OpResult &result, const std::string &message){
+	result.rc = -1;
+	result.error = message;
+	return -1;
+}
+
+bool validPhone(const std::string &phone){
+	return std::regex_match(phone, PHONE_FORMAT);
+}
+
+bool validBadgeLevel(int badgeLevel){
+	return badgeLevel >= 0 && badgeLevel <= MAX_BADGES;
+}
+
+bool validDate(const std::string &date){
+	return std::regex_match(date, DATE_FORMAT);
+}
+
+//Collects every row of a picker statement, whose first column is an integer id and second column is a display label, for a menu picker
+static PickerResult listRows(sqlite3 *db, const PickerStatement &statement, const std::string &context){
+	PickerResult result;
+	Query query(db, statement);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Error selecting from " + context);
+		return result;
+	}
+
+	int rc = query.forEach([&](int id, std::string_view label){
+		result.rows.push_back({id, std::string(label)});
+	});
+	if(rc != SQLITE_DONE){fail(result, db, NULL, "Error reading from " + context);}
+	return result;
+}
+
+PickerResult listPeople(sqlite3 *db, PersonTable table){
+	if(table == PersonTable::TRAINER_CARD){return listRows(db, LIST_TRAINERS, "trainer_card");}
+	return listRows(db, LIST_EMPLOYEES, "employee");
+}
+
+PickerResult listPokemarts(sqlite3 *db){
+	return listRows(db, LIST_POKEMARTS, "pokemart");
+}
+
+PickerResult listInvoices(sqlite3 *db){
+	return listRows(db, LIST_INVOICES, "invoice");
+}
+
+//Lists every product with its most recent stock record at the requested PokeMart. The newest record is the one with the highest stock_id, which unlike
+//stock_date does not depend on every row using the same date format
+ProductListResult listProducts(sqlite3 *db, const ProductListRequest &request){
+	ProductListResult result;
+	Query query(db, LIST_PRODUCTS);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Error selecting from product");
+		return result;
+	}
+	if(query.bind(request.martID, request.trainerID, MAX_BADGES) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding mart ID to product query");
+		return result;
+	}
+
+	int rc = query.forEach([&](std::string_view prodCode, std::string_view prodName, double unitPrice, int stockQty){
+		result.products.push_back({std::string(prodCode), std::string(prodName), unitPrice, stockQty});
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, NULL, "Error reading products");
+		return result;
+	}
+
+	//Show the prices checkout would charge now rather than the list prices, keeping the listing in price order
+	std::shared_ptr<const PriceSnapshot> prices = pricesAt(db, currentTimestamp().epoch, result);
+	if(prices == NULL){return result;}
+	for(ProductListing &product : result.products){
+		product.unitPrice = prices->find(request.martID, product.prodCode, product.unitPrice).price;
+	}
+	std::stable_sort(result.products.begin(), result.products.end(), [](const ProductListing &a, const ProductListing &b){return a.unitPrice < b.unitPrice;});
+	return result;
+}
+
+//Insert a new trainer card
+CreateTrainerResult createTrainer(sqlite3 *db, const CreateTrainerRequest &request){
+	CreateTrainerResult result;
+	if(!validBadgeLevel(request.badgeLevel)){
+		fail(result, "Invalid badge count. Valid badges counts are between 0 and " + std::to_string(MAX_BADGES));
+		return result;
+	}
+	if(!validPhone(request.phone)){
+		fail(result, "Invalid phone number. Phone numbers must be formatted as ###-####");
+		return result;
+	}
+
+	Query query(db, INSERT_TRAINER);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Unable to insert trainer card");
+		return result;
+	}
+	if(query.bind(request.fname, request.lname, request.badgeLevel, request.phone) != SQLITE_OK){
+		fail(result, db, NULL, "Unable to bind a trainer card variable");
+		return result;
+	}
+	if(query.step() != SQLITE_DONE){
+		fail(result, db, NULL, "Error inserting into trainer_card");
+		return result;
+	}
+	result.trainerID = sqlite3_last_insert_rowid(db);
+	return result;
+}
+
+//Insert a new employee
+CreateEmployeeResult createEmployee(sqlite3 *db, const CreateEmployeeRequest &request){
+	CreateEmployeeResult result;
+	if(!validPhone(request.phone)){
+		fail(result, "Invalid phone number. Phone numbers must be formatted as ###-####");
+		return result;
+	}
+
+	Query query(db, INSERT_EMPLOYEE);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Unable to insert employee");
+		return result;
+	}
+	if(query.bind(request.fname, request.lname, request.phone) != SQLITE_OK){
+		fail(result, db, NULL, "Unable to bind an employee variable");
+		return result;
+	}
+	if(query.step() != SQLITE_DONE){
+		fail(result, db, NULL, "Error inserting into employee");
+		return result;
+	}
+	result.empID = sqlite3_last_insert_rowid(db);
+	return result;
+}
+
+//Runs one of the single-row UPDATE statements, which all take the new value and then the id of the row
+template<typename Value>
+static OpResult updateRow(sqlite3 *db, const StatementDef<ParamTypes<Value, int>, ColumnTypes<>> &statement, const Value &value, int id, const std::string &context){
+	OpResult result;
+	Query query(db, statement);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Error updating " + context);
+		return result;
+	}
+	if(query.bind(value, id) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding " + context + " update parameter");
+		return result;
+	}
+	if(query.step() != SQLITE_DONE){fail(result, db, NULL, "Error executing the " + context + " update query");}
+	return result;
+}
+
+//Sets a trainer's balance and appends the change to trainer_ledger in the same transaction, so the ledger always sums to the balance
+static OpResult setTrainerBalance(sqlite3 *db, const UpdateTrainerRequest &request){
+	OpResult result;
+	if(startTransaction(db) != SQLITE_OK){
+		fail(result, db, NULL, "Unable to start transaction");
+		return result;
+	}
+	Timestamp now = currentTimestamp();
+	{
+		Query query(db, INSERT_ADJUSTMENT_LEDGER);
+		if(!query.prepared() || query.bind(request.trainerID, request.balance, now.view(), now.epoch) != SQLITE_OK || query.step() != SQLITE_DONE){
+			fail(result, db, NULL, "Error recording the balance change in trainer_ledger");
+		}
+	}
+	if(result.ok()){result = updateRow(db, UPDATE_TRAINER_BALANCE, request.balance, request.trainerID, "trainer card");}
+	if(!result.ok()){
+		rollback(db);
+		return result;
+	}
+	if(commit(db) != SQLITE_OK){fail(result, db, NULL, "There was an error committing transaction");}
+	return result;
+}
+
+//Update one attribute (balance, badge count, or phone number) of a trainer card
+OpResult updateTrainer(sqlite3 *db, const UpdateTrainerRequest &request){
+	OpResult result;
+	switch(request.field){
+	case TrainerField::BALANCE:
+		if(request.balance < 0){
+			fail(result, "Invalid balance. Balances cannot be negative");
+			return result;
+		}
+		return setTrainerBalance(db, request);
+	case TrainerField::BADGE_LEVEL:
+		if(!validBadgeLevel(request.badgeLevel)){
+			fail(result, "Invalid badge count. Valid badges counts are between 0 and " + std::to_string(MAX_BADGES));
+			return result;
+		}
+		return updateRow(db, UPDATE_TRAINER_BADGES, request.badgeLevel, request.trainerID, "trainer card");
+	case TrainerField::PHONE:
+		if(!validPhone(request.phone)){
+			fail(result, "Invalid phone number. Phone numbers must be formatted as ###-####");
+			return result;
+		}
+		return updateRow(db, UPDATE_TRAINER_PHONE, std::string_view(request.phone), request.trainerID, "trainer card");
+	}
+	return result;
+}
+
+//Update an employee's phone number
+OpResult updateEmployee(sqlite3 *db, const UpdateEmployeeRequest &request){
+	if(!validPhone(request.phone)){
+		OpResult result;
+		fail(result, "Invalid phone number. Phone numbers must be formatted as ###-####");
+		return result;
+	}
+	return updateRow(db, UPDATE_EMPLOYEE_PHONE, std::string_view(request.phone), request.empID, "employee phone number");
+}
+
+//Deletes the row with the given id from a person table
+static DeleteResult deleteRow(sqlite3 *db, const DeleteStatement &statement, const RetireStatement &retire, int id, const std::string &context){
+	DeleteResult result;
+	Query query(db, statement);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Error with " + context + " delete");
+		return result;
+	}
+	if(query.bind(id) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding id to " + context + " delete query");
+		return result;
+	}
+	if(query.step() == SQLITE_DONE){return result;}
+	if(sqlite3_extended_errcode(db) != SQLITE_CONSTRAINT_FOREIGNKEY){
+		fail(result, db, NULL, "Error executing the " + context + " delete query");
+		return result;
+	}
+
+	//Other rows still refer to this one. Only the failed DELETE was undone, so it is retired in its place, in the caller's transaction if there is one
+	Query retired(db, retire);
+	if(!retired.prepared() || retired.bind(currentTimestamp().view(), id) != SQLITE_OK || retired.step() != SQLITE_DONE){
+		fail(result, db, NULL, "Error retiring " + context + " row that other records refer to");
+		return result;
+	}
+	result.retired = true;
+	return result;
+}
+
+DeleteResult deleteTrainer(sqlite3 *db, const DeleteTrainerRequest &request){
+	return deleteRow(db, DELETE_TRAINER, RETIRE_TRAINER, request.trainerID, "trainer_card");
+}
+
+DeleteResult deleteEmployee(sqlite3 *db, const DeleteEmployeeRequest &request){
+	return deleteRow(db, DELETE_EMPLOYEE, RETIRE_EMPLOYEE, request.empID, "employee");
+}
+
+//This function is a transaction that records a sale. This entails inserting a new invoice and one line per basket entry, recording the effect of each
+//line on stock_history and mart_balance_history, and charging the trainer_card (and its ledger) for the sale. Nothing is written unless every line succeeds
+SaleResult recordSale(sqlite3 *db, const SaleRequest &request){
+	SaleResult result;
+	if(request.basket.empty()){
+		fail(result, "Cannot record a sale with no products");
+		return result;
+	}
+
+	int rc = startTransaction(db); //Attempt to start the transaction, quit if unsuccessful
+	if(rc != SQLITE_OK){
+		fail(result, db, NULL, "Unable to start transaction");
+		return result;
+	}
+
+	result.lines.reserve(request.basket.size());
+	rc = writeSale(db, request, result);
+	if(rc != SQLITE_OK){
+		rollback(db);
+		return result;
+	}
+
+	rc = commit(db); //Commit all changes to the database
+	if(rc != SQLITE_OK){
+		fail(result, db, NULL, "There was an error committing transaction");
+	}
+	return result;
+}
+
+//Writes the invoice, its lines and their effects inside the transaction opened by recordSale
+static int writeSale(sqlite3 *db, const SaleRequest &request, SaleResult &result){
+	Timestamp saleTime = currentTimestamp(); //Every row of the sale is stamped with the second it was rung up
+	std::shared_ptr<const PriceSnapshot> prices = pricesAt(db, saleTime.epoch, result); //Held to the end, so a book swapped in meanwhile does not split the basket
+	if(prices == NULL){return result.rc;}
+	int rc = insertInvoice(db, request, result);
+	for(size_t i = 0; rc == SQLITE_OK && i < request.basket.size(); i++){
+		rc = insertLine(db, request, i, saleTime, *prices, result); //Lines are numbered from 1
+	}
+	if(rc == SQLITE_OK){
+		rc = storeInvoiceTotals(db, result);
+	}
+	if(rc == SQLITE_OK){
+		rc = chargeTrainer(db, request.trainerID, saleTime, result);
+	}
+	return rc;
+}
+
+//Insert the invoice header for a sale
+static int insertInvoice(sqlite3 *db, const SaleRequest &request, SaleResult &result){
+	Query query(db, INSERT_INVOICE);
+	if(!query.prepared()){return fail(result, db, NULL, "Error inserting invoice");}
+	if(query.bind(request.trainerID, request.empID, request.martID) != SQLITE_OK){return fail(result, db, NULL, "Error binding invoice parameters");}
+	if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error executing the invoice insert");}
+	result.invoiceNum = sqlite3_last_insert_rowid(db); //Extract the invoice number so the lines can reference the new invoice
+	return SQLITE_OK;
+}
+
+//This function inserts one basket entry as a line of the invoice being created in recordSale, then records its effect on stock and balances
+static int insertLine(sqlite3 *db, const SaleRequest &request, int index, const Timestamp &saleTime, const PriceSnapshot &prices, SaleResult &result){
+	const SaleLine &saleLine = request.basket[index];
+	SaleLineResult line;
+	line.lineNum = index + 1;
+	line.prodCode = saleLine.prodCode;
+	line.qty = saleLine.qty;
+
+	//Find the most recent balance at the PokeMart so the vendor reorder (if any) can be taken out of it
+	double balance;
+	{
+		Query query(db, LATEST_MART_BALANCE);
+		if(!query.prepared()){return fail(result, db, NULL, "Error selecting most recent balance_history at PokeMart " + std::to_string(request.martID));}
+		if(query.bind(request.martID) != SQLITE_OK){return fail(result, db, NULL, "Error binding mart ID to balance_history query");}
+		if(query.step() != SQLITE_ROW){return fail(result, "PokeMart " + std::to_string(request.martID) + " has no balance history");}
+		std::tie(balance) = query.row(); //Extract the balance before the order
+	}
+
+	int minQty;
+	double vendorPrice;
+	int rc = selectProduct(db, request.martID, saleLine, prices, line, minQty, vendorPrice, result);
+	if(rc != SQLITE_OK){return rc;}
+
+	double lineAmount = line.unitPrice * line.qty;
+
+	//Insert the line itself, keeping the price it was sold at
+	{
+		Query query(db, INSERT_LINE);
+		if(!query.prepared()){return fail(result, db, NULL, "Error inserting line");}
+		if(query.bind(result.invoiceNum, line.lineNum, line.prodCode, line.qty, line.unitPrice, lineAmount) != SQLITE_OK){
+			return fail(result, db, NULL, "Error binding line parameters");
+		}
+		if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error executing the line insert");}
+	}
+
+	line.stockAfter -= line.qty; //selectProduct left the current stock in stockAfter
+	line.reorderQty = 0;
+	rc = insertStockHistory(db, line.prodCode, request.martID, line.stockAfter, saleTime, result);
+	if(rc != SQLITE_OK){return rc;}
+
+	//If the stock quantity goes below the PokeMart's reorder point, order from the vendor to bring it back up to 1.5 times the reorder point. The restock is
+	//its own stock_history row after the sale's, so the history keeps the drop the sale made (forecast.h reads sales from it)
+	if(line.stockAfter < minQty){
+		int stockReplenishAmount = minQty * 1.5;
+		line.reorderQty = stockReplenishAmount - line.stockAfter;
+		balance -= line.reorderQty * vendorPrice; //Take the price of the vendor order out of the PokeMart balance
+		if(balance < 0){
+			return fail(result, "PokeMart " + std::to_string(request.martID) + " does not have enough money in its balance to order " + line.prodName + "s from the vendor");
+		}
+		line.stockAfter = stockReplenishAmount;
+		rc = insertStockHistory(db, line.prodCode, request.martID, line.stockAfter, saleTime, result);
+		if(rc != SQLITE_OK){return rc;}
+	}
+
+	rc = insertMartBalance(db, request.martID, balance, saleTime, result);
+	if(rc != SQLITE_OK){return rc;}
+
+	result.subtotal += lineAmount;
+	result.lines.push_back(std::move(line));
+	return SQLITE_OK;
+}
+
+//Stores the subtotal of the finished sale on its invoice, along with the tax and total at the invoice's tax rate, so reports never have to add up the
+//lines or look at current product prices
+static int storeInvoiceTotals(sqlite3 *db, SaleResult &result){
+	Query query(db, STORE_INVOICE_TOTALS);
+	if(!query.prepared()){return fail(result, db, NULL, "Error storing invoice totals");}
+	if(query.bind(result.subtotal, result.invoiceNum) != SQLITE_OK){return fail(result, db, NULL, "Error binding invoice totals");}
+	if(query.step() != SQLITE_ROW){return fail(result, db, NULL, "Error storing invoice totals");}
+	std::tie(result.tax, result.total) = query.row();
+	return SQLITE_OK;
+}
+
+//Looks up a basket entry's product and its most recent stock at the PokeMart, and checks that the quantity can be sold. minQty is the PokeMart's forecast
+//reorder point for the product, or product.min_qty if it has none. The price is the one the snapshot has scheduled, or product.unit_price as read here when
+//nothing is
+static int selectProduct(sqlite3 *db, int martID, const SaleLine &saleLine, const PriceSnapshot &prices, SaleLineResult &line, int &minQty, double &vendorPrice,
+	OpResult &result){
+	{
+		Query query(db, SALE_PRODUCT);
+		if(!query.prepared()){return fail(result, db, NULL, "Error selecting from product");}
+		if(query.bind(saleLine.prodCode, martID) != SQLITE_OK){return fail(result, db, NULL, "Error binding product parameters");}
+		if(query.step() != SQLITE_ROW){
+			return fail(result, "Product " + saleLine.prodCode + " is not stocked at PokeMart " + std::to_string(martID));
+		}
+
+		//Extract the information from the product
+		std::string_view prodName;
+		std::tie(prodName, line.unitPrice, line.stockAfter, minQty, vendorPrice) = query.row();
+		line.prodName = prodName;
+	}
+	line.unitPrice = prices.find(martID, saleLine.prodCode, line.unitPrice).price;
+
+	if(saleLine.qty < 1){
+		return fail(result, "You must order at least 1 product at a time");
+	}
+	if(saleLine.qty > line.stockAfter){
+		return fail(result, "Cannot order more products than there are in stock (" + std::to_string(line.stockAfter) + " " + line.prodName + "s in stock)");
+	}
+	return SQLITE_OK;
+}
+
+//This function provides insert into the stock_history table to create a new record of a new quantity of stock as a result of selling a quantity of a product from a particular store
+static int insertStockHistory(sqlite3 *db, const std::string &prodCode, int martID, int newQty, const Timestamp &stockDate, OpResult &result){
+	Query query(db, INSERT_STOCK_HISTORY);
+	if(!query.prepared()){return fail(result, db, NULL, "Error inserting stock_history");}
+	if(query.bind(prodCode, martID, newQty, stockDate.view(), stockDate.epoch) != SQLITE_OK){return fail(result, db, NULL, "Error binding stock_history insert parameters");}
+	if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error inserting stock_history");}
+	return SQLITE_OK;
+}
+
+//Charges the trainer the invoice total of the sale, tax included, and appends the charge to trainer_ledger. One entry per invoice keeps the trainer's statement to one line a sale
+//NOTE: balance is the trainer_card's attribute and represents how much money the trainer on the trainer card owes PokeMart. On the other hand, mart_balance_history
+//is a table that records the amount of money that a particular PokeMart has to spend.
+static int chargeTrainer(sqlite3 *db, int trainerID, const Timestamp &saleTime, SaleResult &result){
+	{
+		Query query(db, CHARGE_TRAINER);
+		if(!query.prepared()){return fail(result, db, NULL, "Error updating trainer_card balance in chargeTrainer");}
+		if(query.bind(result.total, trainerID) != SQLITE_OK){return fail(result, db, NULL, "Error binding trainer balance parameters in chargeTrainer");}
+		if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error updating trainer_card balance after bind in chargeTrainer");}
+	}
+
+	Query query(db, INSERT_SALE_LEDGER);
+	if(!query.prepared()){return fail(result, db, NULL, "Error with trainer_ledger insert in chargeTrainer");}
+	if(query.bind(trainerID, result.total, result.invoiceNum, saleTime.view(), saleTime.epoch) != SQLITE_OK){
+		return fail(result, db, NULL, "Error binding trainer_ledger insert parameters");
+	}
+	if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error inserting into trainer_ledger");}
+	return SQLITE_OK;
+}
+
+//This inserts a new mart_balance_history record with the PokeMart's balance after one line of a sale
+static int insertMartBalance(sqlite3 *db, int martID, double balanceAfter, const Timestamp &balanceDate, OpResult &result){
+	Query query(db, INSERT_MART_BALANCE);
+	if(!query.prepared()){return fail(result, db, NULL, "Error with insert balance_history query in insertMartBalance");}
+	if(query.bind(balanceAfter, martID, balanceDate.view(), balanceDate.epoch) != SQLITE_OK){return fail(result, db, NULL, "Error binding balance_history insert parameters");}
+	if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error inserting new balance_history");}
+	return SQLITE_OK;
+}
+
+//Collects the header and lines of one invoice. Joins invoice, line, pokemart, employee, trainer_card, and product tables
+InvoiceResult getInvoice(sqlite3 *db, const InvoiceRequest &request){
+	InvoiceResult result;
+	{
+		Query query(db, INVOICE_HEADER);
+		if(!query.prepared()){
+			fail(result, db, NULL, "Error selecting invoice information");
+			return result;
+		}
+		if(query.bind(request.invoiceNum) != SQLITE_OK){
+			fail(result, db, NULL, "Error binding invoice id to parameter in getInvoice");
+			return result;
+		}
+		if(query.step() != SQLITE_ROW){
+			fail(result, "Invoice " + std::to_string(request.invoiceNum) + " was not found");
+			return result;
+		}
+		std::string_view trainerName, empName, address, invoiceDate;
+		std::tie(trainerName, empName, result.martID, address, invoiceDate, result.subtotal, result.tax, result.total) = query.row();
+		result.trainerName = trainerName;
+		result.empName = empName;
+		result.address = address;
+		result.invoiceDate = invoiceDate;
+	}
+
+	//Collect each line on the invoice, as it was priced at the time of sale
+	Query query(db, INVOICE_LINES);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Error selecting invoice line information");
+		return result;
+	}
+	if(query.bind(request.invoiceNum) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding invoice id to parameter in getInvoice");
+		return result;
+	}
+	int rc = query.forEach([&](std::string_view prodName, std::string_view prodDescript, int qty, double unitPrice, double lineTotal){
+		result.lines.push_back({std::string(prodName), std::string(prodDescript), qty, unitPrice, lineTotal});
+	});
+	if(rc != SQLITE_DONE){fail(result, db, NULL, "Error reading invoice lines");}
+	return result;
+}
+
+//Reads the totals stored on one invoice when it was sold. This is a single primary key lookup on invoice; the lines are not read
+InvoiceSummaryResult getInvoiceSummary(sqlite3 *db, const InvoiceRequest &request){
+	InvoiceSummaryResult result;
+	Query query(db, INVOICE_SUMMARY);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Error selecting invoice summary");
+		return result;
+	}
+	if(query.bind(request.invoiceNum) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding invoice id to parameter in getInvoiceSummary");
+		return result;
+	}
+	if(query.step() != SQLITE_ROW){
+		fail(result, "Invoice " + std::to_string(request.invoiceNum) + " was not found");
+		return result;
+	}
+
+	std::string_view invoiceDate;
+	std::tie(result.trainerID, result.empID, result.martID, invoiceDate, result.taxRate, result.subtotal, result.tax, result.total) = query.row();
+	result.invoiceDate = invoiceDate;
+	return result;
+}
+
+//Collects the certification records of one employee. Joins certification, employee, and certification_record
+CertificationResult getCertifications(sqlite3 *db, const CertificationRequest &request){
+	CertificationResult result;
+	Query query(db, EMPLOYEE_CERTIFICATIONS);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Error selecting employee certification information");
+		return result;
+	}
+	if(query.bind(request.empID) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding employee id to parameter in getCertifications");
+		return result;
+	}
+
+	//For each row in the results, extract the certification record. Every row repeats the employee name
+	int rc = query.forEach([&](std::string_view empName, std::string_view certDescript, double payrate, std::string_view certDate, std::string_view certTitle){
+		result.empName = empName;
+		result.records.push_back({std::string(certTitle), std::string(certDescript), std::string(certDate), payrate});
+	});
+	if(rc != SQLITE_DONE){fail(result, db, NULL, "Error reading employee certification information");}
+	return result;
+}
+
+int startTransaction(sqlite3 *db){
+	return sqlite3_exec(db, "begin transaction", NULL, NULL, NULL);
+}
+
+int rollback(sqlite3 *db){
+	return sqlite3_exec(db, "rollback", NULL, NULL, NULL);
+}
+
+//Commits the open transaction, rolling it back if the commit fails
+int commit(sqlite3 *db){
+	int rc = sqlite3_exec(db, "commit", NULL, NULL, NULL);
+	if(rc != SQLITE_OK){
+		rollback(db);
+	}
+	return rc;
+}
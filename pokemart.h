@@ -0,0 +1,206 @@
+/* Program name: pokemart.h
+* Purpose: Declares libpokemart, the business logic behind the PokeMart database. Every operation takes a request struct and returns a result struct and never
+*  touches std::cin or std::cout, so the same code can be driven by the menu in main.cpp, a batch job, a server, or a benchmark.
+*/
+
+#ifndef POKEMART_H
+#define POKEMART_H
+
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+
+const int MAX_BADGES = 8; //Declare int constant to define the maximum number of badges a trainer can have
+
+//Every result carries the return code of the operation (SQLITE_OK on success, -1 or an SQLite error code otherwise) and a message describing any failure
+struct OpResult{
+	int rc = SQLITE_OK;
+	std::string error;
+	bool ok() const {return rc == SQLITE_OK;}
+};
+
+//A selectable row (trainer card, employee, PokeMart, invoice) used to build the menu pickers
+struct PickerRow{
+	int id;
+	std::string label;
+};
+
+//The person tables listPeople can list
+enum class PersonTable{TRAINER_CARD, EMPLOYEE};
+
+struct PickerResult : OpResult{
+	std::vector<PickerRow> rows;
+};
+
+//Insert related
+struct CreateTrainerRequest{
+	std::string fname, lname, phone;
+	int badgeLevel = 0;
+};
+
+struct CreateTrainerResult : OpResult{
+	int trainerID = -1;
+};
+
+struct CreateEmployeeRequest{
+	std::string fname, lname, phone;
+};
+
+struct CreateEmployeeResult : OpResult{
+	int empID = -1;
+};
+
+//Update related
+enum class TrainerField {BALANCE, BADGE_LEVEL, PHONE};
+
+struct UpdateTrainerRequest{
+	int trainerID;
+	TrainerField field;
+	double balance = 0; //Used when field is BALANCE
+	int badgeLevel = 0; //Used when field is BADGE_LEVEL
+	std::string phone; //Used when field is PHONE
+};
+
+struct UpdateEmployeeRequest{
+	int empID;
+	std::string phone;
+};
+
+//Delete related
+struct DeleteTrainerRequest{
+	int trainerID;
+};
+
+struct DeleteEmployeeRequest{
+	int empID;
+};
+
+//A trainer or employee still referred to by invoices, shifts, certification records or ledger entries cannot be deleted, so it is retired instead:
+//retired_date is set and it no longer appears in the pickers
+struct DeleteResult : OpResult{
+	bool retired = false;
+};
+
+//Transaction related
+struct ProductListRequest{
+	int martID;
+	int trainerID = 0; //Only products the trainer has enough badges for (product.req_badges) are listed. 0 lists every product
+};
+
+struct ProductListing{
+	std::string prodCode, prodName;
+	double unitPrice;
+	int stockQty; //Most recent stock_history quantity at the requested PokeMart
+};
+
+struct ProductListResult : OpResult{
+	std::vector<ProductListing> products;
+};
+
+struct SaleLine{
+	std::string prodCode;
+	int qty;
+};
+
+//A whole basket is recorded in one transaction: one invoice, one line per basket entry, the matching stock and balance history, and one trainer_ledger entry
+struct SaleRequest{
+	int trainerID, empID, martID;
+	std::vector<SaleLine> basket;
+};
+
+struct SaleLineResult{
+	int lineNum;
+	std::string prodCode, prodName;
+	int qty;
+	double unitPrice;
+	int stockAfter; //Stock left at the PokeMart after this line, including any vendor reorder
+	int reorderQty; //Quantity ordered from the vendor because stock fell below min_qty (0 if no order was made)
+};
+
+//The totals are stored on the invoice when the sale is committed, so later price changes do not alter them
+struct SaleResult : OpResult{
+	int invoiceNum = -1;
+	double subtotal = 0, tax = 0, total = 0;
+	std::vector<SaleLineResult> lines;
+};
+
+//User reports
+struct InvoiceRequest{
+	int invoiceNum;
+};
+
+struct InvoiceLine{
+	std::string prodName, prodDescript;
+	int qty;
+	double unitPrice, lineTotal; //As charged at the time of sale
+};
+
+struct InvoiceResult : OpResult{
+	int martID = -1;
+	std::string trainerName, empName, address, invoiceDate;
+	std::vector<InvoiceLine> lines;
+	double subtotal = 0, tax = 0, total = 0;
+};
+
+//The totals stored on the invoice row, read without touching its lines
+struct InvoiceSummaryResult : OpResult{
+	int trainerID = -1, empID = -1, martID = -1;
+	std::string invoiceDate;
+	double taxRate = 0, subtotal = 0, tax = 0, total = 0;
+};
+
+struct CertificationRequest{
+	int empID;
+};
+
+struct CertificationRecord{
+	std::string certTitle, certDescript, certDate;
+	double payrate;
+};
+
+struct CertificationResult : OpResult{
+	std::string empName;
+	std::vector<CertificationRecord> records;
+};
+
+//Database setup. Call migrateSchema once after opening a database, before any other operation, then prepareStatements to prepare the library's statements
+//up front (otherwise they are prepared by the first operation). Call finalizeStatements before closing any connection the library has used.
+//Every connection that writes calls enableForeignKeys first, since SQLite leaves them off per connection
+OpResult migrateSchema(sqlite3 *);
+OpResult enableForeignKeys(sqlite3 *);
+OpResult prepareStatements(sqlite3 *);
+void finalizeStatements(sqlite3 *);
+
+//Input validation shared by the library and its clients
+bool validPhone(const std::string &);
+bool validBadgeLevel(int);
+bool validDate(const std::string &); //YYYY-MM-DD or YYYY-MM-DD HH:MM:SS, which compare correctly as text
+
+//Pickers
+PickerResult listPeople(sqlite3 *, PersonTable);
+PickerResult listPokemarts(sqlite3 *);
+PickerResult listInvoices(sqlite3 *);
+ProductListResult listProducts(sqlite3 *, const ProductListRequest &);
+
+//Insert, update and delete
+CreateTrainerResult createTrainer(sqlite3 *, const CreateTrainerRequest &);
+CreateEmployeeResult createEmployee(sqlite3 *, const CreateEmployeeRequest &);
+OpResult updateTrainer(sqlite3 *, const UpdateTrainerRequest &);
+OpResult updateEmployee(sqlite3 *, const UpdateEmployeeRequest &);
+DeleteResult deleteTrainer(sqlite3 *, const DeleteTrainerRequest &);
+DeleteResult deleteEmployee(sqlite3 *, const DeleteEmployeeRequest &);
+
+//Sales
+SaleResult recordSale(sqlite3 *, const SaleRequest &);
+
+//Reports
+InvoiceResult getInvoice(sqlite3 *, const InvoiceRequest &);
+InvoiceSummaryResult getInvoiceSummary(sqlite3 *, const InvoiceRequest &);
+CertificationResult getCertifications(sqlite3 *, const CertificationRequest &);
+
+//SQL wrapper functions
+int startTransaction(sqlite3 *);
+int rollback(sqlite3 *);
+int commit(sqlite3 *);
+
+#endif
@@ -0,0 +1,18 @@
+/* Program name: pokemart_internal.h
+* Purpose: Helpers shared by the libpokemart source files. These are not part of the public API in pokemart.h.
+*/
+
+#ifndef POKEMART_INTERNAL_H
+#define POKEMART_INTERNAL_H
+
+#include <string>
+#include <sqlite3.h>
+#include "pokemart.h"
+
+//Records a failure on result (including the SQLite error message), finalizes res if there is one, and returns -1 so callers can return it directly
+int fail(OpResult &result, sqlite3 *db, sqlite3_stmt *res, const std::string &message);
+
+//Records a failure that did not come from SQLite
+int fail(OpResult &result, const std::string &message);
+
+#endif
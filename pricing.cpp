@@ -0,0 +1,426 @@
+/* Program name: pricing.cpp
+* Purpose: Implements the price book declared in pricing.h. Loading resolves every schedule into segments for the (PokeMart, product) pairs it applies to,
+*  each holding the scheduled price and promotion from its start until the next segment's, so checkout does no resolving at all. Pairs nothing is scheduled
+*  for are not stored. The published book is a std::atomic<std::shared_ptr>, so sales never take a lock; the book is read by whoever schedules a price and
+*  by a refresher thread with its own connection, never by a sale once the process has a book.
+*/
+
+#include "pricing.h"
+#include "pokemart_internal.h"
+#include "rowmap.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+const sqlite3_int64 NEVER = std::numeric_limits<sqlite3_int64>::max();
+const sqlite3_int64 ALWAYS = std::numeric_limits<sqlite3_int64>::min();
+
+//One row of product_price or promotion
+struct ScheduledPrice{
+	sqlite3_int64 id;
+	int martID; //0 unless the row is for one PokeMart
+	std::string region; //Empty unless the row is for a region
+	double value; //unit_price or percent_off
+	sqlite3_int64 start, end; //end is NEVER for an open end
+
+	//Mart beats region beats chain
+	int rank() const {return martID != 0 ? 2 : (!region.empty() ? 1 : 0);}
+	bool appliesTo(int mart, const std::string &martRegion) const {return martID != 0 ? martID == mart : (region.empty() || region == martRegion);}
+	bool covers(sqlite3_int64 at) const {return start <= at && at < end;}
+};
+
+//What is scheduled for a (PokeMart, product) pair from start until the start of the next segment of its timeline. The list price is not stored, so an
+//edit to product.unit_price takes effect at once wherever no price is scheduled
+struct PriceSegment{
+	sqlite3_int64 start;
+	bool scheduled; //Whether a product_price row is in effect; if not the price is product.unit_price
+	double basePrice; //The scheduled price, if there is one
+	double percentOff;
+
+	bool samePrice(const PriceSegment &other) const {return scheduled == other.scheduled && basePrice == other.basePrice && percentOff == other.percentOff;}
+};
+
+class PriceTimelines{
+public:
+	int load(sqlite3 *, OpResult &);
+
+	//The segments of a pair in start order, the first starting at ALWAYS, or NULL if nothing was ever scheduled for it
+	const std::vector<PriceSegment> *timeline(int martID, const std::string &prodCode) const{
+		auto product = timelines.find(prodCode);
+		if(product == timelines.end()){return NULL;}
+		auto mart = product->second.find(martID);
+		return mart == product->second.end() ? NULL : &mart->second;
+	}
+
+	sqlite3_int64 loadedAt = 0;
+
+private:
+	//prod_code -> mart_id -> timeline, holding only the pairs some schedule applies to
+	std::unordered_map<std::string, std::unordered_map<int, std::vector<PriceSegment>>> timelines;
+
+	static void buildTimeline(int martID, const std::string &region, const std::vector<ScheduledPrice> &prices, const std::vector<ScheduledPrice> &promotions,
+		std::vector<PriceSegment> &segments);
+};
+
+//Reads product_price or promotion into one list per product
+static int readSchedules(sqlite3 *db, const char *query, std::unordered_map<std::string, std::vector<ScheduledPrice>> &byProduct, OpResult &result){
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, query, -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error selecting price schedules");}
+	rc = forEachRow<sqlite3_int64, std::string_view, int, std::string_view, double, sqlite3_int64, sqlite3_int64>(res,
+		[&](sqlite3_int64 id, std::string_view prodCode, int martID, std::string_view region, double value, sqlite3_int64 start, sqlite3_int64 end){
+		byProduct[std::string(prodCode)].push_back({id, martID, std::string(region), value, start, end});
+	});
+	if(rc != SQLITE_DONE){return fail(result, db, res, "Error reading price schedules");}
+	sqlite3_finalize(res);
+	return SQLITE_OK;
+}
+
+//What is scheduled for one (PokeMart, product) at a time, from the schedules that apply to it
+static PriceSegment resolvePrice(sqlite3_int64 at, const std::vector<const ScheduledPrice *> &prices, const std::vector<const ScheduledPrice *> &promotions){
+	const ScheduledPrice *best = NULL;
+	for(const ScheduledPrice *price : prices){
+		if(!price->covers(at)){continue;}
+		//The most specific scope wins, then the price that started last, then the one scheduled last
+		if(best == NULL || std::make_tuple(price->rank(), price->start, price->id) > std::make_tuple(best->rank(), best->start, best->id)){best = price;}
+	}
+	double percentOff = 0;
+	for(const ScheduledPrice *promotion : promotions){
+		if(promotion->covers(at)){percentOff = std::max(percentOff, promotion->value);}
+	}
+	return {at, best != NULL, best != NULL ? best->value : 0, percentOff};
+}
+
+void PriceTimelines::buildTimeline(int martID, const std::string &region, const std::vector<ScheduledPrice> &prices, const std::vector<ScheduledPrice> &promotions,
+	std::vector<PriceSegment> &segments){
+	std::vector<const ScheduledPrice *> applyingPrices, applyingPromotions;
+	std::vector<sqlite3_int64> changes = {ALWAYS};
+	for(const ScheduledPrice &price : prices){
+		if(!price.appliesTo(martID, region)){continue;}
+		applyingPrices.push_back(&price);
+		changes.push_back(price.start);
+		if(price.end != NEVER){changes.push_back(price.end);}
+	}
+	for(const ScheduledPrice &promotion : promotions){
+		if(!promotion.appliesTo(martID, region)){continue;}
+		applyingPromotions.push_back(&promotion);
+		changes.push_back(promotion.start);
+		if(promotion.end != NEVER){changes.push_back(promotion.end);}
+	}
+	if(applyingPrices.empty() && applyingPromotions.empty()){return;}
+	std::sort(changes.begin(), changes.end());
+	changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+
+	for(sqlite3_int64 change : changes){
+		PriceSegment segment = resolvePrice(change, applyingPrices, applyingPromotions);
+		if(!segments.empty() && segments.back().samePrice(segment)){continue;} //Nothing actually changes here, such as a price replaced by the same price
+		segments.push_back(segment);
+	}
+}
+
+int PriceTimelines::load(sqlite3 *db, OpResult &result){
+	loadedAt = currentTimestamp().epoch;
+	std::unordered_map<std::string, std::vector<ScheduledPrice>> prices, promotions;
+	if(readSchedules(db, "SELECT price_id, prod_code, COALESCE(mart_id, 0), COALESCE(region, ''), unit_price, start_epoch, "
+		"COALESCE(end_epoch, 9223372036854775807) FROM product_price", prices, result) != SQLITE_OK){return result.rc;}
+	if(readSchedules(db, "SELECT promo_id, prod_code, COALESCE(mart_id, 0), COALESCE(region, ''), percent_off, start_epoch, "
+		"COALESCE(end_epoch, 9223372036854775807) FROM promotion", promotions, result) != SQLITE_OK){return result.rc;}
+	if(prices.empty() && promotions.empty()){return SQLITE_OK;}
+
+	std::vector<std::pair<int, std::string>> marts;
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "SELECT mart_id, region FROM pokemart ORDER BY mart_id", -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error selecting PokeMarts for the price book");}
+	rc = forEachRow<int, std::string_view>(res, [&](int martID, std::string_view region){marts.emplace_back(martID, std::string(region));});
+	if(rc != SQLITE_DONE){return fail(result, db, res, "Error reading PokeMarts for the price book");}
+	sqlite3_finalize(res);
+
+	//Only the products something is scheduled for, at the PokeMarts it applies to
+	static const std::vector<ScheduledPrice> none;
+	auto scheduleProduct = [&](const std::string &prodCode){
+		if(timelines.count(prodCode) != 0){return;}
+		auto price = prices.find(prodCode), promotion = promotions.find(prodCode);
+		const std::vector<ScheduledPrice> &productPrices = price != prices.end() ? price->second : none;
+		const std::vector<ScheduledPrice> &productPromotions = promotion != promotions.end() ? promotion->second : none;
+		std::unordered_map<int, std::vector<PriceSegment>> &byMart = timelines[prodCode];
+		for(const auto &[martID, region] : marts){
+			std::vector<PriceSegment> segments;
+			buildTimeline(martID, region, productPrices, productPromotions, segments);
+			if(!segments.empty()){byMart.emplace(martID, std::move(segments));}
+		}
+	};
+	for(const auto &[prodCode, schedules] : prices){scheduleProduct(prodCode);}
+	for(const auto &[prodCode, schedules] : promotions){scheduleProduct(prodCode);}
+	return SQLITE_OK;
+}
+
+PricePoint PriceSnapshot::find(int martID, const std::string &prodCode, double listPrice) const{
+	PricePoint point = {listPrice, listPrice, 0, listPrice};
+	const std::vector<PriceSegment> *segments = book->timeline(martID, prodCode);
+	if(segments == NULL){return point;}
+	auto next = std::upper_bound(segments->begin(), segments->end(), at, [](sqlite3_int64 epoch, const PriceSegment &segment){return epoch < segment.start;});
+	const PriceSegment &current = *std::prev(next); //Every timeline starts at ALWAYS, so there is one
+	if(current.scheduled){point.basePrice = current.basePrice;}
+	point.percentOff = current.percentOff;
+	point.price = std::round(point.basePrice * (100 - point.percentOff) * 10) / 1000; //To the thousandth, the scale of line.unit_price
+	return point;
+}
+
+static std::mutex bookMutex; //Held while the book is read, so an older read never replaces a newer one
+static std::atomic<std::shared_ptr<const PriceTimelines>> published; //The book sales are priced from
+
+//Reads the timelines and publishes them. Called with bookMutex held
+static int reloadBook(sqlite3 *db, OpResult &result){
+	std::shared_ptr<PriceTimelines> timelines = std::make_shared<PriceTimelines>();
+	if(timelines->load(db, result) != SQLITE_OK){return result.rc;}
+	published.store(timelines);
+	return SQLITE_OK;
+}
+
+//Reads the book again every PRICE_RELOAD_SECONDS on its own connection, so schedules added by another process reach this one without a sale waiting on them
+struct PriceRefresher{
+	std::string path;
+	std::thread thread;
+	std::mutex stopMutex;
+	std::condition_variable stopSignal;
+	bool stopping = false;
+
+	~PriceRefresher(){
+		{
+			std::lock_guard<std::mutex> lock(stopMutex);
+			stopping = true;
+		}
+		stopSignal.notify_one();
+		if(thread.joinable()){thread.join();}
+	}
+};
+
+static std::mutex refresherMutex; //Held while the refresher is started or replaced
+static std::unique_ptr<PriceRefresher> refresher; //Stopped when the process exits
+
+static void runRefresher(PriceRefresher &self){
+	sqlite3 *db = NULL;
+	std::unique_lock<std::mutex> lock(self.stopMutex);
+	while(!self.stopSignal.wait_for(lock, std::chrono::seconds(PRICE_RELOAD_SECONDS), [&]{return self.stopping;})){
+		lock.unlock();
+		if(db == NULL){
+			if(sqlite3_open_v2(self.path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL) == SQLITE_OK){sqlite3_busy_timeout(db, 1000);}
+			else{ //Tried again next time
+				sqlite3_close(db);
+				db = NULL;
+			}
+		}
+		if(db != NULL){
+			OpResult result;
+			std::lock_guard<std::mutex> bookLock(bookMutex);
+			reloadBook(db, result); //On failure sales keep the book they have
+		}
+		lock.lock();
+	}
+	sqlite3_close(db);
+}
+
+//Starts the refresher on db's file unless it already follows it. An in-memory database has no file, and nothing else can schedule in it
+static void followDatabase(sqlite3 *db){
+	const char *filename = sqlite3_db_filename(db, "main");
+	if(filename == NULL || filename[0] == '\0'){return;}
+	std::lock_guard<std::mutex> lock(refresherMutex);
+	if(refresher && refresher->path == filename){return;}
+	refresher.reset();
+	refresher = std::make_unique<PriceRefresher>();
+	refresher->path = filename;
+	refresher->thread = std::thread(runRefresher, std::ref(*refresher));
+}
+
+OpResult loadPrices(sqlite3 *db){
+	OpResult result;
+	{
+		std::lock_guard<std::mutex> lock(bookMutex);
+		if(reloadBook(db, result) != SQLITE_OK){return result;}
+	}
+	followDatabase(db); //Outside bookMutex, since replacing a refresher waits for it to finish a reload
+	return result;
+}
+
+std::shared_ptr<const PriceSnapshot> pricesAt(sqlite3 *db, sqlite3_int64 epoch, OpResult &result){
+	std::shared_ptr<const PriceTimelines> book = published.load();
+	if(book == NULL){ //Only the first sale of a process that did not load the book up front
+		OpResult loaded = loadPrices(db);
+		if(!loaded.ok()){
+			result.rc = loaded.rc;
+			result.error = loaded.error;
+			return NULL;
+		}
+		book = published.load();
+	}
+	return std::make_shared<const PriceSnapshot>(book, epoch);
+}
+
+//Checks a schedule's scope and period and converts its times. Returns false with the error on result
+static bool validSchedule(sqlite3 *db, const std::string &starts, const std::string &ends, const PriceScope &scope, sqlite3_int64 &startEpoch,
+	sqlite3_int64 &endEpoch, OpResult &result){
+	if(!parseTimestamp(starts, startEpoch) || (!ends.empty() && !parseTimestamp(ends, endEpoch))){
+		fail(result, "Start and end must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return false;
+	}
+	if(!ends.empty() && endEpoch <= startEpoch){
+		fail(result, "The end must be after the start");
+		return false;
+	}
+	if(scope.martID != 0 && !scope.region.empty()){
+		fail(result, "A price is for one PokeMart or one region, not both");
+		return false;
+	}
+	if(scope.region.empty()){return true;} //A mart_id is checked by its foreign key
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "SELECT 1 FROM pokemart WHERE region = ? LIMIT 1", -1, &res, NULL);
+	if(rc == SQLITE_OK){rc = sqlite3_bind_text(res, 1, scope.region.c_str(), -1, SQLITE_STATIC);}
+	if(rc == SQLITE_OK){rc = sqlite3_step(res);}
+	if(rc != SQLITE_ROW && rc != SQLITE_DONE){
+		fail(result, db, res, "Error checking region " + scope.region);
+		return false;
+	}
+	sqlite3_finalize(res);
+	if(rc == SQLITE_DONE){
+		fail(result, "No PokeMart is in region " + scope.region);
+		return false;
+	}
+	return true;
+}
+
+//Inserts one schedule row into product_price or promotion, whose columns are bound in the same order, then reloads the book so sales see it at once
+static OpResult scheduleRow(sqlite3 *db, const char *insert, const std::string &prodCode, double value, const std::string &starts, const std::string &ends,
+	const PriceScope &scope){
+	OpResult result;
+	sqlite3_int64 startEpoch, endEpoch = 0;
+	if(!validSchedule(db, starts, ends, scope, startEpoch, endEpoch, result)){return result;}
+
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, insert, -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error preparing price schedule insert");
+		return result;
+	}
+	rc = sqlite3_bind_text(res, 1, prodCode.c_str(), -1, SQLITE_STATIC);
+	if(rc == SQLITE_OK){rc = scope.martID != 0 ? sqlite3_bind_int(res, 2, scope.martID) : sqlite3_bind_null(res, 2);}
+	if(rc == SQLITE_OK){rc = !scope.region.empty() ? sqlite3_bind_text(res, 3, scope.region.c_str(), -1, SQLITE_STATIC) : sqlite3_bind_null(res, 3);}
+	if(rc == SQLITE_OK){rc = sqlite3_bind_double(res, 4, value);}
+	if(rc == SQLITE_OK){rc = sqlite3_bind_text(res, 5, starts.c_str(), -1, SQLITE_STATIC);}
+	if(rc == SQLITE_OK){rc = !ends.empty() ? sqlite3_bind_text(res, 6, ends.c_str(), -1, SQLITE_STATIC) : sqlite3_bind_null(res, 6);}
+	if(rc == SQLITE_OK){rc = sqlite3_bind_int64(res, 7, startEpoch);}
+	if(rc == SQLITE_OK){rc = !ends.empty() ? sqlite3_bind_int64(res, 8, endEpoch) : sqlite3_bind_null(res, 8);}
+	if(rc == SQLITE_OK){rc = sqlite3_step(res);}
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error scheduling price of " + prodCode);
+		return result;
+	}
+	sqlite3_finalize(res);
+	return loadPrices(db);
+}
+
+OpResult schedulePrice(sqlite3 *db, const PriceChangeRequest &request){
+	if(request.unitPrice <= 0){
+		OpResult result;
+		fail(result, "A price must be greater than 0");
+		return result;
+	}
+	return scheduleRow(db, "INSERT INTO product_price (prod_code, mart_id, region, unit_price, starts, ends, start_epoch, end_epoch) VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+		request.prodCode, request.unitPrice, request.starts, request.ends, request.scope);
+}
+
+OpResult schedulePromotion(sqlite3 *db, const PromotionRequest &request){
+	if(request.percentOff <= 0 || request.percentOff > 100){
+		OpResult result;
+		fail(result, "A promotion must take more than 0 and at most 100 percent off");
+		return result;
+	}
+	return scheduleRow(db, "INSERT INTO promotion (prod_code, mart_id, region, percent_off, starts, ends, start_epoch, end_epoch) VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+		request.prodCode, request.percentOff, request.starts, request.ends, request.scope);
+}
+
+PriceListResult listPrices(sqlite3 *db, const PriceListRequest &request){
+	PriceListResult result;
+	sqlite3_int64 epoch = currentTimestamp().epoch;
+	if(!request.at.empty() && !parseTimestamp(request.at, epoch)){
+		fail(result, "Invalid time " + request.at + ". Times must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return result;
+	}
+	result.at = std::string(timestampAt(epoch).view());
+	OpResult loaded = loadPrices(db); //Shows what was scheduled up to now, even from another process
+	if(!loaded.ok()){
+		result.rc = loaded.rc;
+		result.error = loaded.error;
+		return result;
+	}
+	std::shared_ptr<const PriceSnapshot> prices = pricesAt(db, epoch, result);
+	if(prices == NULL){return result;}
+
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "SELECT 1 FROM pokemart WHERE mart_id = ?", -1, &res, NULL);
+	if(rc == SQLITE_OK){rc = sqlite3_bind_int(res, 1, request.martID);}
+	if(rc == SQLITE_OK){rc = sqlite3_step(res);}
+	if(rc != SQLITE_ROW && rc != SQLITE_DONE){
+		fail(result, db, res, "Error selecting PokeMart " + std::to_string(request.martID));
+		return result;
+	}
+	sqlite3_finalize(res);
+	if(rc == SQLITE_DONE){
+		fail(result, "No PokeMart with mart_id " + std::to_string(request.martID));
+		return result;
+	}
+
+	rc = sqlite3_prepare_v2(db, "SELECT prod_code, prod_name, unit_price FROM product ORDER BY prod_code", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting products");
+		return result;
+	}
+	rc = forEachRow<std::string_view, std::string_view, double>(res, [&](std::string_view prodCode, std::string_view prodName, double unitPrice){
+		std::string code(prodCode);
+		result.prices.push_back({code, std::string(prodName), prices->find(request.martID, code, unitPrice)});
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading products");
+		return result;
+	}
+	sqlite3_finalize(res);
+	return result;
+}
+
+//Report fields
+const ReportField PRICE_LIST_REPORT = {"Price List", "price_list"};
+const ReportField MART_ID = {"PokeMart", "mart_id"};
+const ReportField AT = {"As Of", "at"};
+const ReportField PRICES = {"Prices", "prices"};
+const ReportField PROD_CODE = {"Product Code", "prod_code"};
+const ReportField PROD_NAME = {"Product", "prod_name"};
+const ReportField LIST_PRICE = {"List Price", "list_price"};
+const ReportField BASE_PRICE = {"Scheduled Price", "base_price"};
+const ReportField PERCENT_OFF = {"Percent Off", "percent_off"};
+const ReportField PRICE = {"Price", "price"};
+
+void writePriceListReport(const PriceListRequest &request, const PriceListResult &result, ReportRenderer &out){
+	out.beginReport(PRICE_LIST_REPORT);
+	out.field(MART_ID, request.martID);
+	out.field(AT, result.at);
+	out.beginRows(PRICES);
+	for(const PriceListing &listing : result.prices){
+		out.beginRow();
+		out.field(PROD_CODE, listing.prodCode);
+		out.field(PROD_NAME, listing.prodName);
+		out.moneyField(LIST_PRICE, listing.point.listPrice);
+		out.moneyField(BASE_PRICE, listing.point.basePrice);
+		out.decimalField(PERCENT_OFF, listing.point.percentOff);
+		out.moneyField(PRICE, listing.point.price);
+		out.endRow();
+	}
+	out.endRows();
+	out.endReport();
+}
@@ -0,0 +1,97 @@
+/* Program name: pricing.h
+* Purpose: Declares effective-dated pricing. Prices and promotions are scheduled ahead in product_price and promotion, for one PokeMart, a region or the
+*  whole chain, and take effect on their own at their start time. The process keeps a price book: the schedules resolved into a timeline for each
+*  (PokeMart, product) that something is scheduled for, a list of the times its scheduled price or promotion changes. Every other pair sells at
+*  product.unit_price. Checkout reads a price with two hash lookups and a search of that one pair's changes, so a change falling due costs nothing. The
+*  book is read again when a price is scheduled and by a background thread every PRICE_RELOAD_SECONDS, never inside a sale once the process has one, and
+*  swapped in atomically. A sale holds the book and time it started with, so every line of a basket is priced at the same moment.
+*/
+
+#ifndef PRICING_H
+#define PRICING_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+//How often the background thread reads the book again, so schedules added by another process reach every register within this time
+const int PRICE_RELOAD_SECONDS = 60;
+
+//Where a price or promotion applies. With neither set it applies at every PokeMart
+struct PriceScope{
+	int martID = 0;
+	std::string region;
+};
+
+struct PriceChangeRequest{
+	std::string prodCode;
+	double unitPrice = 0;
+	std::string starts, ends; //"YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS". An empty end keeps the price until a later one replaces it
+	PriceScope scope;
+};
+
+struct PromotionRequest{
+	std::string prodCode;
+	double percentOff = 0; //Taken off the price in effect
+	std::string starts, ends;
+	PriceScope scope;
+};
+
+//A price as resolved for one (PokeMart, product) at one time
+struct PricePoint{
+	double listPrice; //product.unit_price
+	double basePrice; //The scheduled price in effect, or listPrice
+	double percentOff; //The best promotion in effect, or 0
+	double price; //What a sale charges: basePrice less percentOff, to the thousandth
+};
+
+class PriceTimelines;
+
+//The book as of one moment. Immutable, so it can be read from any thread
+class PriceSnapshot{
+public:
+	PriceSnapshot(std::shared_ptr<const PriceTimelines> book, sqlite3_int64 at) : book(std::move(book)), at(at) {}
+
+	//The price of a product at a PokeMart given its product.unit_price, which is charged as it is unless something is scheduled for the pair
+	PricePoint find(int martID, const std::string &prodCode, double listPrice) const;
+
+private:
+	std::shared_ptr<const PriceTimelines> book;
+	sqlite3_int64 at;
+};
+
+//The prices in effect at epoch from this process's book, which is loaded from db first only if the process has none yet. NULL (with the error on result)
+//only if that load failed
+std::shared_ptr<const PriceSnapshot> pricesAt(sqlite3 *, sqlite3_int64 epoch, OpResult &);
+
+//Reads the schedules again now, swapping the new book in for sales that start afterwards, and starts the thread that rereads them for db's file
+OpResult loadPrices(sqlite3 *);
+
+//Schedule a price or promotion and reload this process's book. Other processes pick it up within PRICE_RELOAD_SECONDS
+OpResult schedulePrice(sqlite3 *, const PriceChangeRequest &);
+OpResult schedulePromotion(sqlite3 *, const PromotionRequest &);
+
+struct PriceListRequest{
+	int martID;
+	std::string at; //"YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS". Empty for now
+};
+
+struct PriceListing{
+	std::string prodCode, prodName;
+	PricePoint point;
+};
+
+struct PriceListResult : OpResult{
+	std::string at;
+	std::vector<PriceListing> prices; //In prod_code order
+};
+
+//Every product's price at a PokeMart at a time, as checkout would charge it
+PriceListResult listPrices(sqlite3 *, const PriceListRequest &);
+
+void writePriceListReport(const PriceListRequest &, const PriceListResult &, ReportRenderer &);
+
+#endif
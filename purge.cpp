@@ -0,0 +1,134 @@
+/* Program name: purge.cpp
+* Purpose: Implements the inactive people purge declared in purge.h. Each batch picks the next inactive people by id and removes them in the same IMMEDIATE
+*  transaction, so a sale rung up between batches either lands before its trainer is picked or finds the trainer still there. Whether a person is deleted
+*  or retired is left to the foreign keys: the DELETE fails when any invoice, shift, certification record or ledger entry still refers to them, which the
+*  indexes on those columns (schema version 9) answer with one seek per table.
+*/
+
+#include "purge.h"
+#include "pokemart_internal.h"
+#include "timestamp.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+//The next batchRows people after @after with no activity on or after @since (text) / @sinceEpoch, who are not already retired
+struct PurgeTable{
+	const char *name;
+	const char *inactive;
+};
+
+const PurgeTable TRAINERS = {
+	"trainer_card",
+	"SELECT t.trainer_id FROM trainer_card t WHERE t.trainer_id > @after AND t.retired_date IS NULL AND t.registration_date < @since "
+	"AND NOT EXISTS (SELECT 1 FROM invoice i WHERE i.trainer_id = t.trainer_id AND i.invoice_date >= @since) "
+	"AND NOT EXISTS (SELECT 1 FROM trainer_ledger l WHERE l.trainer_id = t.trainer_id AND l.entry_epoch >= @sinceEpoch) "
+	"ORDER BY t.trainer_id LIMIT @batch"
+};
+
+const PurgeTable EMPLOYEES = {
+	"employee",
+	"SELECT e.emp_id FROM employee e WHERE e.emp_id > @after AND e.retired_date IS NULL AND e.hire_date < @since "
+	"AND NOT EXISTS (SELECT 1 FROM certification_record c WHERE c.emp_id = e.emp_id AND c.cert_date >= @since) "
+	"AND NOT EXISTS (SELECT 1 FROM shift s WHERE s.emp_id = e.emp_id AND s.shift_date >= @since) "
+	"AND NOT EXISTS (SELECT 1 FROM invoice i WHERE i.emp_id = e.emp_id AND i.invoice_date >= @since) "
+	"ORDER BY e.emp_id LIMIT @batch"
+};
+
+//Deletes or retires one batch of people. Returns SQLITE_OK, with the ids handled in ids, or the error that stopped the batch
+static int purgeBatch(sqlite3 *db, sqlite3_stmt *inactive, const PurgeRequest &request, sqlite3_int64 after, std::vector<int> &ids, PurgeResult &result){
+	ids.clear();
+	int rc = sqlite3_bind_int64(inactive, sqlite3_bind_parameter_index(inactive, "@after"), after);
+	while(rc == SQLITE_OK && (rc = sqlite3_step(inactive)) == SQLITE_ROW){
+		ids.push_back(sqlite3_column_int(inactive, 0));
+		rc = SQLITE_OK;
+	}
+	sqlite3_reset(inactive);
+	if(rc != SQLITE_DONE){return fail(result, db, NULL, "Error finding inactive people to purge");}
+
+	for(int id : ids){
+		DeleteResult removed = request.table == PersonTable::TRAINER_CARD ? deleteTrainer(db, {id}) : deleteEmployee(db, {id});
+		if(!removed.ok()){
+			result.rc = removed.rc;
+			result.error = removed.error;
+			return result.rc;
+		}
+		if(removed.retired){result.retired++;}
+		else{result.deleted++;}
+	}
+	return SQLITE_OK;
+}
+
+PurgeResult purgeInactive(sqlite3 *db, const PurgeRequest &request){
+	PurgeResult result;
+	sqlite3_int64 sinceEpoch;
+	if(!validDate(request.inactiveSince) || !parseTimestamp(request.inactiveSince, sinceEpoch)){
+		fail(result, "Inactive since date must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return result;
+	}
+	if(request.batchRows <= 0){
+		fail(result, "Batch size must be greater than 0");
+		return result;
+	}
+
+	const PurgeTable &table = request.table == PersonTable::TRAINER_CARD ? TRAINERS : EMPLOYEES;
+	sqlite3_stmt *inactive;
+	int rc = sqlite3_prepare_v2(db, table.inactive, -1, &inactive, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, inactive, std::string("Error preparing inactive ") + table.name + " query");
+		return result;
+	}
+	rc = sqlite3_bind_text(inactive, sqlite3_bind_parameter_index(inactive, "@since"), request.inactiveSince.c_str(), -1, SQLITE_STATIC);
+	int sinceEpochIndex = sqlite3_bind_parameter_index(inactive, "@sinceEpoch");
+	if(rc == SQLITE_OK && sinceEpochIndex > 0){rc = sqlite3_bind_int64(inactive, sinceEpochIndex, sinceEpoch);}
+	if(rc == SQLITE_OK){rc = sqlite3_bind_int(inactive, sqlite3_bind_parameter_index(inactive, "@batch"), request.batchRows);}
+	if(rc != SQLITE_OK){
+		fail(result, db, inactive, "Error binding inactive since date in purgeInactive");
+		return result;
+	}
+
+	//Each batch is its own IMMEDIATE transaction, so the write lock is taken up front and held only for one batch; a sale waiting on the lock gets in
+	//between batches
+	std::vector<int> ids;
+	ids.reserve(request.batchRows);
+	sqlite3_int64 after = 0;
+	do{
+		rc = sqlite3_exec(db, "BEGIN IMMEDIATE", NULL, NULL, NULL);
+		if(rc != SQLITE_OK){
+			fail(result, db, NULL, std::string("Error starting purge batch of ") + table.name);
+			break;
+		}
+		rc = purgeBatch(db, inactive, request, after, ids, result);
+		if(rc == SQLITE_OK){
+			rc = sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
+			if(rc != SQLITE_OK){fail(result, db, NULL, std::string("Error committing purge batch of ") + table.name);}
+		}
+		if(rc != SQLITE_OK){
+			sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+			break;
+		}
+		result.batches++;
+		if(!ids.empty()){after = ids.back();}
+		if(request.pauseMs > 0 && static_cast<int>(ids.size()) == request.batchRows){std::this_thread::sleep_for(std::chrono::milliseconds(request.pauseMs));}
+	}while(static_cast<int>(ids.size()) == request.batchRows);
+	sqlite3_finalize(inactive);
+	return result;
+}
+
+//Report fields
+const ReportField PURGE_REPORT = {"Inactive People Purge", "purge"};
+const ReportField TABLE = {"Table", "table"};
+const ReportField INACTIVE_SINCE = {"No Activity Since", "inactive_since"};
+const ReportField DELETED = {"Deleted", "deleted"};
+const ReportField RETIRED = {"Retired (Still Referenced)", "retired"};
+const ReportField BATCHES = {"Batches", "batches"};
+
+void writePurgeReport(const PurgeRequest &request, const PurgeResult &result, ReportRenderer &out){
+	out.beginReport(PURGE_REPORT);
+	out.field(TABLE, request.table == PersonTable::TRAINER_CARD ? "trainer_card" : "employee");
+	out.field(INACTIVE_SINCE, request.inactiveSince);
+	out.field(DELETED, result.deleted);
+	out.field(RETIRED, result.retired);
+	out.field(BATCHES, result.batches);
+	out.endReport();
+}
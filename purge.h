@@ -0,0 +1,32 @@
+/* Program name: purge.h
+* Purpose: Declares the inactive people purge. Trainers and employees are never removed by the registers, so the pickers and every foreign key lookup
+*  keep growing with people who stopped coming in. purgeInactive walks trainer_card or employee in id order and removes each one registered or hired
+*  before a date with no sale (and for employees, no shift or certification) since it: deleted when nothing refers to it any more, otherwise retired (deleteTrainer / deleteEmployee). People are handled
+*  in small batches, each in its own short transaction, so registers can keep recording sales while it runs.
+*/
+
+#ifndef PURGE_H
+#define PURGE_H
+
+#include <string>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct PurgeRequest{
+	PersonTable table = PersonTable::TRAINER_CARD;
+	std::string inactiveSince; //People with no activity on or after this ("YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS") are purged
+	int batchRows = 500; //People handled per transaction; keeps each write lock short
+	int pauseMs = 0; //Sleep between batches to leave more room for sales
+};
+
+struct PurgeResult : OpResult{
+	int deleted = 0, retired = 0;
+	int batches = 0;
+};
+
+PurgeResult purgeInactive(sqlite3 *, const PurgeRequest &);
+
+void writePurgeReport(const PurgeRequest &, const PurgeResult &, ReportRenderer &);
+
+#endif
@@ -0,0 +1,250 @@
+/* Program name: rebalance.cpp
+* Purpose: Implements stock rebalancing (rebalance.h). The latest stock is streamed in prod_code order, so only one product's stock across the PokeMarts is
+*  held at a time, and each product is solved as soon as its rows are read. The solver walks the PokeMarts in region order once per product, matching
+*  each region's needs against the same region's surplus, then what is left against every other region's, two pointers at a time. Every match fills a
+*  need or empties a surplus, so a product needs at most one transfer per PokeMart involved, and solving is linear in the number of PokeMarts.
+*/
+
+#include "rebalance.h"
+#include "pokemart_internal.h"
+#include "rowmap.h"
+#include "statements.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+TransferSolver::TransferSolver(const std::vector<int> &region, double keepFactor) : region(region), keepFactor(keepFactor){
+	order.resize(region.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b){return region[a] < region[b];});
+	for(size_t i = 0; i < order.size(); i++){
+		if(i + 1 == order.size() || region[order[i + 1]] != region[order[i]]){regionEnd.push_back(i + 1);}
+	}
+}
+
+//Moves stock from gives to needs in order until either runs out. What is left of each keeps its place for the next round
+void TransferSolver::match(std::vector<Balance> &needs, std::vector<Balance> &gives, bool sameRegion, std::vector<Move> &moves){
+	size_t n = 0, g = 0;
+	while(n < needs.size() && g < gives.size()){
+		Balance &need = needs[n];
+		Balance &give = gives[g];
+		int qty = std::min(need.qty, give.qty);
+		need.qty -= qty;
+		need.after += qty;
+		give.qty -= qty;
+		give.after -= qty;
+		moves.push_back({give.mart, need.mart, qty, give.after, need.after, sameRegion});
+		if(need.qty == 0){n++;}
+		if(give.qty == 0){g++;}
+	}
+}
+
+int TransferSolver::solve(const int *stock, const int *minQty, std::vector<Move> &moves){
+	int below = 0;
+	leftNeeds.clear();
+	leftGives.clear();
+	int start = 0;
+	for(int end : regionEnd){
+		needs.clear();
+		gives.clear();
+		for(int i = start; i < end; i++){
+			int mart = order[i];
+			if(stock[mart] < 0){continue;}
+			if(stock[mart] < minQty[mart]){
+				int target = minQty[mart] * 1.5; //The level a vendor reorder restocks to
+				needs.push_back({mart, target - stock[mart], stock[mart]});
+				below++;
+				continue;
+			}
+			int keep = std::ceil(minQty[mart] * keepFactor);
+			if(stock[mart] > keep){gives.push_back({mart, stock[mart] - keep, stock[mart]});}
+		}
+		match(needs, gives, true, moves);
+		for(const Balance &need : needs){
+			if(need.qty > 0){leftNeeds.push_back(need);}
+		}
+		for(const Balance &give : gives){
+			if(give.qty > 0){leftGives.push_back(give);}
+		}
+		start = end;
+	}
+	match(leftNeeds, leftGives, false, moves);
+	return below;
+}
+
+//Numbers the PokeMarts in mart_id order and their regions in the order first seen
+static int loadMarts(sqlite3 *db, std::vector<int> &martIndex, std::vector<int> &martIDs, std::vector<int> &regions, RebalanceResult &result){
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "SELECT mart_id, region FROM pokemart ORDER BY mart_id", -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error selecting PokeMarts for rebalancing");}
+	std::unordered_map<std::string, int> regionNumbers;
+	rc = forEachRow<int, std::string_view>(res, [&](int martID, std::string_view region){
+		if(martID < 0){return;}
+		if(martID >= static_cast<int>(martIndex.size())){martIndex.resize(martID + 1, -1);}
+		martIndex[martID] = martIDs.size();
+		martIDs.push_back(martID);
+		regions.push_back(regionNumbers.emplace(std::string(region), regionNumbers.size()).first->second);
+	});
+	if(rc != SQLITE_DONE){return fail(result, db, res, "Error reading PokeMarts for rebalancing");}
+	sqlite3_finalize(res);
+	return SQLITE_OK;
+}
+
+//Reads the latest stock of every product and solves each product once all of its rows are in
+static int planTransfers(sqlite3 *db, const RebalanceRequest &request, RebalanceResult &result){
+	std::vector<int> martIndex, martIDs, regions;
+	if(loadMarts(db, martIndex, martIDs, regions, result) != SQLITE_OK){return result.rc;}
+	result.marts = martIDs.size();
+
+	//The latest row of each (mart_id, prod_code) is the one with the highest stock_id, like everywhere else
+	sqlite3_stmt *res;
+	std::string query = "SELECT s.prod_code, s.mart_id, s.stock_qty, COALESCE(r.min_qty, p.min_qty), p.vendor_price FROM stock_history s ";
+	query += "JOIN product p ON p.prod_code = s.prod_code LEFT JOIN reorder_point r ON r.mart_id = s.mart_id AND r.prod_code = s.prod_code ";
+	query += "WHERE s.stock_id IN (SELECT MAX(stock_id) FROM stock_history GROUP BY mart_id, prod_code) ORDER BY s.prod_code";
+	int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error selecting stock for rebalancing");}
+
+	TransferSolver solver(regions, request.keepFactor);
+	std::vector<int> stock(martIDs.size(), -1), minQty(martIDs.size(), 0), stocked;
+	std::vector<TransferSolver::Move> moves;
+	std::string prodCode;
+	double vendorPrice = 0;
+	auto solveProduct = [&](){
+		moves.clear();
+		result.belowReorder += solver.solve(stock.data(), minQty.data(), moves);
+		result.products++;
+		for(const TransferSolver::Move &move : moves){
+			double vendorCost = move.qty * vendorPrice;
+			result.transfers.push_back({prodCode, martIDs[move.from], martIDs[move.to], move.qty, move.fromAfter, move.toAfter, move.sameRegion, vendorCost});
+			result.unitsMoved += move.qty;
+			result.vendorCostAvoided += vendorCost;
+		}
+		for(int mart : stocked){stock[mart] = -1;}
+		stocked.clear();
+	};
+	rc = forEachRow<std::string_view, int, int, int, double>(res, [&](std::string_view rowProduct, int martID, int qty, int reorderPoint, double price){
+		if(martID < 0 || martID >= static_cast<int>(martIndex.size()) || martIndex[martID] < 0){return;} //History of a PokeMart that no longer exists
+		if(rowProduct != prodCode){
+			if(!stocked.empty()){solveProduct();}
+			prodCode = rowProduct;
+		}
+		int mart = martIndex[martID];
+		stock[mart] = qty < 0 ? 0 : qty;
+		minQty[mart] = reorderPoint;
+		vendorPrice = price;
+		stocked.push_back(mart);
+	});
+	if(rc != SQLITE_DONE){return fail(result, db, res, "Error reading stock for rebalancing");}
+	sqlite3_finalize(res);
+	if(!stocked.empty()){solveProduct();}
+	return SQLITE_OK;
+}
+
+//Writes one transfer: its stock_transfer row, then the sending and receiving stock_history rows carrying its id
+static int writeTransfer(sqlite3 *db, const StockTransfer &transfer, const Timestamp &transferTime, RebalanceResult &result){
+	sqlite3_int64 transferID;
+	{
+		Query query(db, INSERT_STOCK_TRANSFER);
+		if(!query.prepared()){return fail(result, db, NULL, "Error inserting stock_transfer");}
+		if(query.bind(transfer.prodCode, transfer.fromMart, transfer.toMart, transfer.qty, transferTime.view(), transferTime.epoch) != SQLITE_OK){
+			return fail(result, db, NULL, "Error binding stock_transfer parameters");
+		}
+		if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error inserting stock_transfer");}
+		transferID = sqlite3_last_insert_rowid(db);
+	}
+
+	const int marts[] = {transfer.fromMart, transfer.toMart};
+	const int quantities[] = {transfer.fromStockAfter, transfer.toStockAfter};
+	for(int side = 0; side < 2; side++){
+		Query query(db, INSERT_TRANSFER_STOCK);
+		if(!query.prepared()){return fail(result, db, NULL, "Error inserting transfer stock_history");}
+		if(query.bind(transfer.prodCode, marts[side], quantities[side], transferTime.view(), transferTime.epoch, transferID) != SQLITE_OK){
+			return fail(result, db, NULL, "Error binding transfer stock_history parameters");
+		}
+		if(query.step() != SQLITE_DONE){return fail(result, db, NULL, "Error inserting transfer stock_history");}
+	}
+	return SQLITE_OK;
+}
+
+RebalanceResult rebalanceStock(sqlite3 *db, const RebalanceRequest &request){
+	RebalanceResult result;
+	if(!(request.keepFactor >= 1)){
+		fail(result, "A PokeMart has to keep at least its reorder point (keep factor of 1 or more)");
+		return result;
+	}
+	if(!request.execute){
+		planTransfers(db, request, result);
+		return result;
+	}
+
+	//Executed transfers are planned inside the write transaction, so the stock they move is the stock they were planned from. BEGIN IMMEDIATE takes the
+	//write lock up front; a deferred transaction that read first could not upgrade while a register was writing
+	int rc = sqlite3_exec(db, "BEGIN IMMEDIATE", NULL, NULL, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, NULL, "Unable to start stock transfer transaction");
+		return result;
+	}
+	rc = planTransfers(db, request, result);
+	Timestamp transferTime = currentTimestamp();
+	for(size_t i = 0; rc == SQLITE_OK && i < result.transfers.size(); i++){
+		rc = writeTransfer(db, result.transfers[i], transferTime, result);
+	}
+	if(rc != SQLITE_OK){
+		rollback(db);
+		return result;
+	}
+	rc = commit(db);
+	if(rc != SQLITE_OK){
+		fail(result, db, NULL, "Error committing stock transfers");
+		return result;
+	}
+	result.executed = true;
+	return result;
+}
+
+//Report fields
+const ReportField REBALANCE_REPORT = {"Stock Rebalancing", "rebalance"};
+const ReportField STATUS = {"Status", "status"};
+const ReportField KEEP_FACTOR = {"Keep Factor", "keep_factor"};
+const ReportField MARTS = {"PokeMarts", "marts"};
+const ReportField PRODUCTS = {"Products", "products"};
+const ReportField BELOW_REORDER = {"Stock Below Reorder Point", "below_reorder"};
+const ReportField UNITS_MOVED = {"Units Moved", "units_moved"};
+const ReportField VENDOR_COST_AVOIDED = {"Vendor Cost Avoided", "vendor_cost_avoided"};
+const ReportField TRANSFERS = {"Transfers", "transfers"};
+const ReportField PROD_CODE = {"Product Code", "prod_code"};
+const ReportField FROM_MART = {"From PokeMart", "from_mart"};
+const ReportField TO_MART = {"To PokeMart", "to_mart"};
+const ReportField QTY = {"Quantity", "qty"};
+const ReportField FROM_STOCK_AFTER = {"Sender Stock After", "from_stock_after"};
+const ReportField TO_STOCK_AFTER = {"Receiver Stock After", "to_stock_after"};
+const ReportField SAME_REGION = {"Same Region", "same_region"};
+const ReportField VENDOR_COST = {"Vendor Cost", "vendor_cost"};
+
+void writeRebalanceReport(const RebalanceRequest &request, const RebalanceResult &result, ReportRenderer &out){
+	out.beginReport(REBALANCE_REPORT);
+	out.field(STATUS, result.executed ? "executed" : "proposed");
+	out.decimalField(KEEP_FACTOR, request.keepFactor);
+	out.field(MARTS, result.marts);
+	out.field(PRODUCTS, result.products);
+	out.field(BELOW_REORDER, result.belowReorder);
+	out.field(UNITS_MOVED, result.unitsMoved);
+	out.moneyField(VENDOR_COST_AVOIDED, result.vendorCostAvoided);
+	out.beginRows(TRANSFERS);
+	for(const StockTransfer &transfer : result.transfers){
+		out.beginRow();
+		out.field(PROD_CODE, transfer.prodCode);
+		out.field(FROM_MART, transfer.fromMart);
+		out.field(TO_MART, transfer.toMart);
+		out.field(QTY, transfer.qty);
+		out.field(FROM_STOCK_AFTER, transfer.fromStockAfter);
+		out.field(TO_STOCK_AFTER, transfer.toStockAfter);
+		out.field(SAME_REGION, transfer.sameRegion ? "yes" : "no");
+		out.moneyField(VENDOR_COST, transfer.vendorCost);
+		out.endRow();
+	}
+	out.endRows();
+	out.endReport();
+}
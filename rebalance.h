@@ -0,0 +1,76 @@
+/* Program name: rebalance.h
+* Purpose: Declares stock rebalancing between PokeMarts. A sale that leaves a PokeMart below its reorder point buys from the vendor, even when another
+*  PokeMart has more of the product than it needs. rebalanceStock reads the latest stock of every product at every PokeMart and moves surplus to the
+*  PokeMarts below their reorder point first, preferring a PokeMart in the same region, so those vendor orders are never placed. Executed transfers are
+*  written as a pair of stock_history rows, one taking the stock out of the sending PokeMart and one adding it at the receiving PokeMart, joined by a
+*  stock_transfer row.
+*/
+
+#ifndef REBALANCE_H
+#define REBALANCE_H
+
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct RebalanceRequest{
+	//A PokeMart below its reorder point is brought back up to 1.5 times it, the level a vendor reorder would restock to. A PokeMart only gives stock
+	//above keepFactor times its own reorder point, so a transfer never leaves it close to reordering itself
+	double keepFactor = 2;
+	bool execute = false; //Write the transfers. Otherwise they are only proposed
+};
+
+struct StockTransfer{
+	std::string prodCode;
+	int fromMart, toMart;
+	int qty;
+	int fromStockAfter, toStockAfter; //Stock at each PokeMart after the transfer
+	bool sameRegion;
+	double vendorCost; //What the receiving PokeMart would have paid the vendor for qty
+};
+
+//transfers is ordered by prod_code
+struct RebalanceResult : OpResult{
+	std::vector<StockTransfer> transfers;
+	int marts = 0, products = 0;
+	sqlite3_int64 belowReorder = 0; //(PokeMart, product) pairs below their reorder point
+	sqlite3_int64 unitsMoved = 0;
+	double vendorCostAvoided = 0;
+	bool executed = false;
+};
+
+RebalanceResult rebalanceStock(sqlite3 *, const RebalanceRequest &);
+
+void writeRebalanceReport(const RebalanceRequest &, const RebalanceResult &, ReportRenderer &);
+
+//The transfer solver on its own, for callers that already hold stock in memory (and the benchmark). PokeMarts are numbered 0 to marts - 1 by the caller
+class TransferSolver{
+public:
+	//region[m] is any number naming PokeMart m's region
+	TransferSolver(const std::vector<int> &region, double keepFactor);
+
+	//stock[m] and minQty[m] describe one product at PokeMart m; stock[m] < 0 means the PokeMart does not carry it. Appends the transfers for the product
+	//to moves, which are numbered like the PokeMarts. Returns the number of PokeMarts below their reorder point
+	struct Move{
+		int from, to, qty, fromAfter, toAfter;
+		bool sameRegion;
+	};
+	int solve(const int *stock, const int *minQty, std::vector<Move> &moves);
+
+private:
+	//Quantity a PokeMart needs or can give, in solve order
+	struct Balance{
+		int mart, qty, after;
+	};
+	void match(std::vector<Balance> &needs, std::vector<Balance> &gives, bool sameRegion, std::vector<Move> &moves);
+
+	std::vector<int> order; //PokeMarts sorted by region, so each region's PokeMarts are one run
+	std::vector<int> regionEnd; //End (in order) of each region's run
+	std::vector<int> region;
+	double keepFactor;
+	std::vector<Balance> needs, gives, leftNeeds, leftGives; //Reused between products
+};
+
+#endif
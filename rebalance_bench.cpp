@@ -0,0 +1,168 @@
+/* Program name: rebalance_bench.cpp
+* Purpose: Benchmarks stock rebalancing (rebalance.h). First times the transfer solver alone over 10,000 PokeMarts in 20 regions and 10,000 products,
+*  with every PokeMart's stock drawn between none and three times its reorder point, and checks that no PokeMart gives away stock it has to keep and that
+*  no transfer overfills a PokeMart. Then builds a database from tables.sql with a smaller chain and times proposing and executing the transfers through
+*  rebalanceStock, checking that a second proposal finds nothing left to move that the first could have.
+*  Usage: rebalance_bench [marts] [products] (run from the source directory; rebalance_bench.db is rebuilt on every run)
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "rebalance.h"
+
+const int REGIONS = 20;
+const double KEEP_FACTOR = 2;
+const int DB_MARTS = 500;
+const int DB_PRODUCTS = 50;
+
+static double secondsSince(std::chrono::steady_clock::time_point start){
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+//Solves every product of a random chain, timing only the solver. Returns false if a transfer breaks the rules
+static bool benchSolver(int marts, int products){
+	std::mt19937 random(42);
+	std::vector<int> region(marts), stock(marts), minQty(marts);
+	for(int m = 0; m < marts; m++){region[m] = m % REGIONS;}
+	TransferSolver solver(region, KEEP_FACTOR);
+
+	std::vector<TransferSolver::Move> moves;
+	std::vector<int> after(marts);
+	double solving = 0;
+	long long transfers = 0, below = 0, units = 0;
+	for(int p = 0; p < products; p++){
+		for(int m = 0; m < marts; m++){
+			minQty[m] = 10 + random() % 90;
+			stock[m] = random() % 20 == 0 ? -1 : static_cast<int>(random() % (3 * minQty[m] + 1)); //One PokeMart in 20 does not carry the product
+			after[m] = stock[m];
+		}
+		moves.clear();
+		auto start = std::chrono::steady_clock::now();
+		below += solver.solve(stock.data(), minQty.data(), moves);
+		solving += secondsSince(start);
+
+		for(const TransferSolver::Move &move : moves){
+			after[move.from] -= move.qty;
+			after[move.to] += move.qty;
+			if(move.qty <= 0 || after[move.from] != move.fromAfter || after[move.to] != move.toAfter){
+				std::cerr << "Transfer " << move.from << " -> " << move.to << " does not add up\n";
+				return false;
+			}
+			units += move.qty;
+		}
+		for(int m = 0; m < marts; m++){
+			if(after[m] == stock[m]){continue;}
+			bool gave = after[m] < stock[m];
+			if((gave && after[m] < std::ceil(minQty[m] * KEEP_FACTOR)) || (!gave && after[m] > static_cast<int>(minQty[m] * 1.5))){
+				std::cerr << "PokeMart " << m << " was left with " << after[m] << " of product " << p << '\n';
+				return false;
+			}
+		}
+		transfers += moves.size();
+	}
+	std::cout << "Solver: " << marts << " PokeMarts x " << products << " products in " << solving << " s (" << below << " below reorder point, "
+		<< transfers << " transfers, " << units << " units)\n";
+	return true;
+}
+
+//Creates the schema and a chain whose products are out of balance between PokeMarts
+static bool buildDatabase(sqlite3 *db){
+	std::ifstream tablesFile("tables.sql");
+	if(!tablesFile){
+		std::cerr << "tables.sql not found; run the benchmark from the source directory\n";
+		return false;
+	}
+	std::stringstream tables;
+	tables << tablesFile.rdbuf();
+	if(sqlite3_exec(db, tables.str().c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error creating schema: " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+
+	std::mt19937 random(7);
+	std::string sql = "BEGIN;";
+	for(int m = 1; m <= DB_MARTS; m++){
+		sql += "INSERT INTO pokemart (city, region, street_address, phone_num) VALUES ('Bench', 'Region " + std::to_string(m % REGIONS) + "', '" +
+			std::to_string(m) + " Bench Road', '" + std::to_string(m) + "');";
+	}
+	for(int p = 1; p <= DB_PRODUCTS; p++){
+		sql += "INSERT INTO product (prod_code, prod_name, prod_descript, unit_price, min_qty, vendor_price) VALUES ('P" + std::to_string(p) + "', 'Product " +
+			std::to_string(p) + "', 'Benchmark', 10, " + std::to_string(10 + p) + ", 6);";
+		for(int m = 1; m <= DB_MARTS; m++){
+			sql += "INSERT INTO stock_history (prod_code, mart_id, stock_qty) VALUES ('P" + std::to_string(p) + "', " + std::to_string(m) + ", " +
+				std::to_string(random() % (3 * (10 + p) + 1)) + ");";
+		}
+	}
+	sql += "COMMIT;";
+	if(sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error filling benchmark database: " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+static bool benchDatabase(){
+	std::string path = "rebalance_bench.db";
+	std::remove(path.c_str());
+	sqlite3 *db;
+	if(sqlite3_open(path.c_str(), &db) != SQLITE_OK){
+		std::cerr << "Error opening " << path << ": " << sqlite3_errmsg(db) << '\n';
+		sqlite3_close(db);
+		return false;
+	}
+	OpResult prepared;
+	if(buildDatabase(db)){prepared = enableForeignKeys(db);} //Sales pay for the foreign key checks, as they do in main
+	else{prepared.rc = -1;}
+	if(prepared.ok()){prepared = prepareStatements(db);}
+	if(!prepared.ok()){
+		if(!prepared.error.empty()){std::cerr << prepared.error << '\n';}
+		sqlite3_close(db);
+		return false;
+	}
+
+	bool ok = true;
+	RebalanceRequest request;
+	request.keepFactor = KEEP_FACTOR;
+	bool executed = false;
+	for(bool execute : {false, true, false}){
+		request.execute = execute;
+		auto start = std::chrono::steady_clock::now();
+		RebalanceResult result = rebalanceStock(db, request);
+		double elapsed = secondsSince(start);
+		if(!result.ok()){
+			std::cerr << result.error << '\n';
+			ok = false;
+			break;
+		}
+		std::cout << (execute ? "Execute: " : "Propose: ") << result.marts << " PokeMarts x " << result.products << " products in " << elapsed << " s ("
+			<< result.transfers.size() << " transfers, " << result.unitsMoved << " units)\n";
+		//Once executed, every need is filled or every surplus used up, so there is nothing left to propose
+		if(executed && !result.transfers.empty()){
+			std::cerr << "Stock was still out of balance after executing the transfers\n";
+			ok = false;
+		}
+		executed = executed || result.executed;
+	}
+	finalizeStatements(db);
+	sqlite3_close(db);
+	return ok;
+}
+
+int main(int argc, char *argv[]){
+	int marts = argc > 1 ? std::atoi(argv[1]) : 10000;
+	int products = argc > 2 ? std::atoi(argv[2]) : 10000;
+	if(marts < 1 || products < 1){
+		std::cerr << "Usage: " << argv[0] << " [marts] [products]\n";
+		return 2;
+	}
+	if(!benchSolver(marts, products)){return 1;}
+	return benchDatabase() ? 0 : 1;
+}
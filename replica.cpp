@@ -0,0 +1,116 @@
+/* Program name: replica.cpp
+* Purpose: Implements replica mode (replica.h). The whole database is copied in one backup step, which holds a read transaction on the source for as
+*  long as the copy takes. The time of the copy is kept in a replica_state table that only exists in the replica.
+*/
+
+#include "replica.h"
+#include "pokemart_internal.h"
+#include <ctime>
+
+OpResult refreshReplica(sqlite3 *source, const std::string &path, sqlite3_int64 &takenAt){
+	OpResult result;
+	sqlite3 *replica;
+	int rc = sqlite3_open_v2(path.c_str(), &replica, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, replica, NULL, "Error opening replica " + path);
+		sqlite3_close(replica);
+		return result;
+	}
+	sqlite3_busy_timeout(replica, 5000); //A report may be reading the previous copy
+
+	takenAt = std::time(NULL);
+	sqlite3_backup *backup = sqlite3_backup_init(replica, "main", source, "main");
+	if(backup == NULL){
+		fail(result, replica, NULL, "Error starting copy to replica " + path);
+		sqlite3_close(replica);
+		return result;
+	}
+	rc = sqlite3_backup_step(backup, -1); //All pages at once, so the copy is one consistent snapshot of the source
+	sqlite3_backup_finish(backup);
+	if(rc != SQLITE_DONE){
+		fail(result, "Error copying pokemart.db to replica " + path + ": " + sqlite3_errstr(rc));
+		sqlite3_close(replica);
+		return result;
+	}
+
+	sqlite3_stmt *res;
+	rc = sqlite3_exec(replica, "CREATE TABLE replica_state (taken_at INTEGER NOT NULL)", NULL, NULL, NULL);
+	if(rc == SQLITE_OK){rc = sqlite3_prepare_v2(replica, "INSERT INTO replica_state (taken_at) VALUES (@takenAt)", -1, &res, NULL);}
+	if(rc != SQLITE_OK){
+		fail(result, replica, NULL, "Error recording replica time");
+		sqlite3_close(replica);
+		return result;
+	}
+	rc = sqlite3_bind_int64(res, sqlite3_bind_parameter_index(res, "@takenAt"), takenAt);
+	if(rc == SQLITE_OK){rc = sqlite3_step(res);}
+	if(rc != SQLITE_DONE){fail(result, replica, res, "Error recording replica time");}
+	else{sqlite3_finalize(res);}
+	sqlite3_close(replica);
+	return result;
+}
+
+//Opens the replica read-only and reads when it was taken. Returns false if there is no usable replica
+static bool openExisting(const std::string &path, ReplicaResult &result){
+	int rc = sqlite3_open_v2(path.c_str(), &result.db, SQLITE_OPEN_READONLY, NULL);
+	if(rc == SQLITE_OK){
+		sqlite3_busy_timeout(result.db, 5000); //The replica may be in the middle of a refresh
+		sqlite3_stmt *res;
+		rc = sqlite3_prepare_v2(result.db, "SELECT taken_at FROM replica_state", -1, &res, NULL);
+		if(rc == SQLITE_OK){
+			rc = sqlite3_step(res);
+			if(rc == SQLITE_ROW){
+				result.takenAt = sqlite3_column_int64(res, 0);
+				rc = SQLITE_OK;
+			}
+		}
+		sqlite3_finalize(res);
+	}
+	if(rc != SQLITE_OK){
+		sqlite3_close(result.db);
+		result.db = NULL;
+		return false;
+	}
+	return true;
+}
+
+ReplicaResult openReplica(sqlite3 *source, const ReplicaRequest &request){
+	ReplicaResult result;
+	result.maxStalenessSeconds = request.maxStalenessSeconds;
+	sqlite3_int64 now = std::time(NULL);
+	if(openExisting(request.path, result) && now - result.takenAt <= request.maxStalenessSeconds){
+		result.ageSeconds = now - result.takenAt;
+		return result;
+	}
+	if(result.db != NULL){
+		sqlite3_close(result.db);
+		result.db = NULL;
+	}
+
+	sqlite3_int64 takenAt;
+	OpResult refreshed = refreshReplica(source, request.path, takenAt);
+	if(!refreshed.ok()){
+		static_cast<OpResult &>(result) = refreshed;
+		return result;
+	}
+	if(!openExisting(request.path, result)){
+		fail(result, "Error opening replica " + request.path);
+		return result;
+	}
+	result.refreshed = true;
+	result.ageSeconds = std::time(NULL) - result.takenAt;
+	return result;
+}
+
+//Report fields
+const ReportField DATA_AS_OF = {"Data As Of", "data_as_of"};
+const ReportField DATA_AGE = {"Data Age (seconds)", "data_age_seconds"};
+const ReportField STALENESS_BOUND = {"Staleness Bound (seconds)", "staleness_bound_seconds"};
+
+void stampReplica(const ReplicaResult &result, StampedRenderer &out){
+	char takenAt[32];
+	std::time_t time = result.takenAt;
+	std::strftime(takenAt, sizeof(takenAt), "%F %T", std::localtime(&time));
+	out.stamp(DATA_AS_OF, takenAt);
+	out.stamp(DATA_AGE, result.ageSeconds);
+	out.stamp(STALENESS_BOUND, static_cast<sqlite3_int64>(result.maxStalenessSeconds));
+}
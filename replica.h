@@ -0,0 +1,38 @@
+/* Program name: replica.h
+* Purpose: Declares replica mode. A replica is a copy of pokemart.db, taken with the SQLite online backup API, that reports read instead of the live
+*  database. Registers then never wait behind a long report, and a report only touches pokemart.db when its replica is older than the staleness bound it
+*  allows. Each copy records the time it was taken so reports can show how old their data is.
+*/
+
+#ifndef REPLICA_H
+#define REPLICA_H
+
+#include <string>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct ReplicaRequest{
+	std::string path = "pokemart_replica.db";
+	int maxStalenessSeconds = 60; //The replica is refreshed first if it is older than this
+};
+
+//db is a read-only connection to the replica, to be closed by the caller
+struct ReplicaResult : OpResult{
+	sqlite3 *db = NULL;
+	sqlite3_int64 takenAt = 0; //Unix time the copy was taken
+	sqlite3_int64 ageSeconds = 0;
+	int maxStalenessSeconds = 0; //The bound it was opened with
+	bool refreshed = false; //Whether this call made a new copy
+};
+
+//Copies the source database into the replica file and records the time. The source is only read, in a single read transaction
+OpResult refreshReplica(sqlite3 *source, const std::string &path, sqlite3_int64 &takenAt);
+
+//Opens the replica read-only, refreshing it from source first if it is missing or older than the staleness bound
+ReplicaResult openReplica(sqlite3 *source, const ReplicaRequest &);
+
+//Adds the time the replica was taken, its age and the staleness bound to every report rendered through the StampedRenderer
+void stampReplica(const ReplicaResult &, StampedRenderer &);
+
+#endif
@@ -0,0 +1,202 @@
+/* Program name: report.cpp
+* Purpose: Implements the libpokemart report writers on the statement registry (statements.h). Each row is decoded and passed to the renderer while the
+*  statement is still on that row, so text columns are never copied into their own std::string.
+*/
+
+#include "report.h"
+#include "pokemart_internal.h"
+#include "rowmap.h"
+#include "statements.h"
+#include "timestamp.h"
+
+//Report titles, sections and fields
+const ReportField INVOICE_REPORT = {"Invoice Info", "invoice"};
+const ReportField INVOICE_NUM = {"Invoice Number", "invoice_num"};
+const ReportField MART_ID = {"PokeMart ID", "mart_id"};
+const ReportField MART_ADDRESS = {"PokeMart Address", "mart_address"};
+const ReportField TRAINER_NAME = {"Trainer Name", "trainer_name"};
+const ReportField CLERK = {"Clerk", "clerk"};
+const ReportField INVOICE_DATE = {"Invoice Date", "invoice_date"};
+const ReportField PRODUCTS_ORDERED = {"Products ordered", "lines"};
+const ReportField PRODUCT = {"Product", "product"};
+const ReportField DESCRIPTION = {"Description", "description"};
+const ReportField LINE_QTY = {"Line Quantity", "qty"};
+const ReportField UNIT_PRICE = {"Unit Price", "unit_price"};
+const ReportField LINE_TOTAL = {"Line Total", "line_total"};
+const ReportField SUBTOTAL = {"Subtotal", "subtotal"};
+const ReportField TAX = {"Tax", "tax"};
+const ReportField INVOICE_TOTAL = {"Invoice Total Charge", "invoice_total"};
+
+const ReportField CERTIFICATION_REPORT = {"Certification Record", "certifications"};
+const ReportField EMP_ID = {"Employee ID", "emp_id"};
+const ReportField EMP_NAME = {"Employee", "emp_name"};
+const ReportField CERTIFICATIONS = {"Certifications", "certifications"};
+const ReportField CERT_TITLE = {"Certification", "cert_title"};
+const ReportField CERT_DESCRIPTION = {"Description", "cert_descript"};
+const ReportField PAYRATE = {"Hourly Rate", "payrate"};
+const ReportField CERT_DATE = {"Date Earned", "cert_date"};
+
+//The parts of an invoice report, shared by writeInvoiceReport and writeInvoiceBatch so a batch renders every invoice the same way
+static void writeInvoiceHeader(ReportRenderer &out, int invoiceNum, int martID, std::string_view address, std::string_view trainerName, std::string_view empName,
+	std::string_view invoiceDate){
+	out.beginReport(INVOICE_REPORT);
+	out.field(INVOICE_NUM, invoiceNum);
+	out.field(MART_ID, martID);
+	out.field(MART_ADDRESS, address);
+	out.field(TRAINER_NAME, trainerName);
+	out.field(CLERK, empName);
+	out.field(INVOICE_DATE, invoiceDate);
+	out.beginRows(PRODUCTS_ORDERED);
+}
+
+static void writeInvoiceLine(ReportRenderer &out, std::string_view prodName, std::string_view prodDescript, int qty, double unitPrice, double lineTotal){
+	out.beginRow();
+	out.field(PRODUCT, prodName);
+	out.field(DESCRIPTION, prodDescript);
+	out.field(LINE_QTY, qty);
+	out.moneyField(UNIT_PRICE, unitPrice);
+	out.moneyField(LINE_TOTAL, lineTotal);
+	out.endRow();
+}
+
+static void writeInvoiceTotals(ReportRenderer &out, double subtotal, double tax, double total){
+	out.endRows();
+	out.moneyField(SUBTOTAL, subtotal);
+	out.moneyField(TAX, tax);
+	out.moneyField(INVOICE_TOTAL, total);
+	out.endReport();
+}
+
+OpResult writeInvoiceReport(sqlite3 *db, const InvoiceRequest &request, ReportRenderer &out){
+	OpResult result;
+	Query header(db, INVOICE_HEADER);
+	if(!header.prepared()){
+		fail(result, db, NULL, "Error selecting invoice information");
+		return result;
+	}
+	if(header.bind(request.invoiceNum) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding invoice id to parameter in writeInvoiceReport");
+		return result;
+	}
+	if(header.step() != SQLITE_ROW){
+		fail(result, "Invoice " + std::to_string(request.invoiceNum) + " was not found");
+		return result;
+	}
+
+	//Output the invoice info. The totals were stored when the sale was made, so they are kept for the end of the report
+	auto [trainerName, empName, martID, address, invoiceDate, subtotal, tax, total] = header.row();
+	writeInvoiceHeader(out, request.invoiceNum, martID, address, trainerName, empName, invoiceDate);
+
+	Query lines(db, INVOICE_LINES);
+	if(!lines.prepared()){
+		fail(result, db, NULL, "Error selecting invoice line information");
+		return result;
+	}
+	if(lines.bind(request.invoiceNum) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding invoice id to parameter in writeInvoiceReport");
+		return result;
+	}
+
+	//Output details for each line as it was priced at the time of sale
+	int rc = lines.forEach([&](std::string_view prodName, std::string_view prodDescript, int qty, double unitPrice, double lineTotal){
+		writeInvoiceLine(out, prodName, prodDescript, qty, unitPrice, lineTotal);
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, NULL, "Error reading invoice lines");
+		return result;
+	}
+
+	writeInvoiceTotals(out, subtotal, tax, total);
+	return result;
+}
+
+InvoiceBatchResult writeInvoiceBatch(sqlite3 *db, const InvoiceBatchRequest &request, ReportRenderer &out){
+	InvoiceBatchResult result;
+	sqlite3_int64 epoch;
+	if((!request.from.empty() && !parseTimestamp(request.from, epoch)) || (!request.to.empty() && !parseTimestamp(request.to, epoch))){
+		fail(result, "Dates must be formatted as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS");
+		return result;
+	}
+	//Sorts after every date. It has to look like a date: invoice_date has NUMERIC affinity, so a bare "9999" would be compared as the number 9999
+	std::string to = request.to.empty() ? "9999-12-31 23:59:59" : request.to;
+
+	Query headers(db, INVOICE_BATCH_HEADERS);
+	Query lines(db, INVOICE_BATCH_LINES);
+	if(!headers.prepared() || !lines.prepared()){
+		fail(result, db, NULL, "Error selecting invoices for batch");
+		return result;
+	}
+	if(headers.bind(request.from, to, request.martID) != SQLITE_OK || lines.bind(request.from, to, request.martID) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding invoice batch parameters");
+		return result;
+	}
+
+	//The lines statement is stepped first and stays open while the headers are read, so both read the same snapshot of the database even if a sale
+	//commits meanwhile
+	int lineRC = lines.step();
+	int rc;
+	while((rc = headers.step()) == SQLITE_ROW){
+		auto [invoiceNum, trainerName, empName, martID, address, invoiceDate, subtotal, tax, total] = headers.row();
+		writeInvoiceHeader(out, invoiceNum, martID, address, trainerName, empName, invoiceDate);
+		for(; lineRC == SQLITE_ROW; lineRC = lines.step()){
+			auto [lineInvoice, prodName, prodDescript, qty, unitPrice, lineTotal] = lines.row();
+			if(lineInvoice != invoiceNum){break;} //The first line of a later invoice
+			writeInvoiceLine(out, prodName, prodDescript, qty, unitPrice, lineTotal);
+			result.lines++;
+		}
+		writeInvoiceTotals(out, subtotal, tax, total);
+		result.invoices++;
+	}
+	if(rc != SQLITE_DONE){
+		fail(result, db, NULL, "Error reading invoices for batch");
+		return result;
+	}
+	if(lineRC != SQLITE_DONE){
+		if(lineRC == SQLITE_ROW){fail(result, "Invoice lines were left over after the last invoice of the batch");}
+		else{fail(result, db, NULL, "Error reading invoice lines for batch");}
+	}
+	return result;
+}
+
+OpResult writeCertificationReport(sqlite3 *db, const CertificationRequest &request, ReportRenderer &out){
+	OpResult result;
+	Query query(db, EMPLOYEE_CERTIFICATIONS);
+	if(!query.prepared()){
+		fail(result, db, NULL, "Error selecting employee certification information");
+		return result;
+	}
+	if(query.bind(request.empID) != SQLITE_OK){
+		fail(result, db, NULL, "Error binding employee id to parameter in writeCertificationReport");
+		return result;
+	}
+
+	//The employee name is repeated on every row, so the report heading is written from the first one
+	bool first = true;
+	int rc = query.forEach([&](std::string_view empName, std::string_view certDescript, double payrate, std::string_view certDate, std::string_view certTitle){
+		if(first){
+			out.beginReport(CERTIFICATION_REPORT);
+			out.field(EMP_ID, request.empID);
+			out.field(EMP_NAME, empName);
+			out.beginRows(CERTIFICATIONS);
+			first = false;
+		}
+		out.beginRow();
+		out.field(CERT_TITLE, certTitle);
+		out.field(CERT_DESCRIPTION, certDescript);
+		out.moneyField(PAYRATE, payrate);
+		out.field(CERT_DATE, certDate);
+		out.endRow();
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, NULL, "Error reading employee certification information");
+		return result;
+	}
+
+	if(first){
+		fail(result, "Employee " + std::to_string(request.empID) + " has no certification records");
+		return result;
+	}
+	out.endRows();
+	out.endReport();
+	return result;
+}
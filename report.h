@@ -0,0 +1,36 @@
+/* Program name: report.h
+* Purpose: Declares the libpokemart report writers. A report is decoded row by row with rowmap.h and handed straight to a ReportRenderer (output.h), so
+*  printing an invoice with thousands of lines does not allocate a std::string per cell, and the same report can be written as text, CSV or JSON.
+*/
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <string>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+//Renders the invoice report (header, one row per line, and the total) for one invoice
+OpResult writeInvoiceReport(sqlite3 *, const InvoiceRequest &, ReportRenderer &);
+
+//Invoices dated from up to (not including) to, at one PokeMart or every PokeMart. Dates are "YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS"; either may be left empty
+//to leave that end open
+struct InvoiceBatchRequest{
+	std::string from, to;
+	int martID = 0;
+};
+
+struct InvoiceBatchResult : OpResult{
+	int invoices = 0, lines = 0;
+};
+
+//Renders the invoice report of every invoice in the batch, in invoice_date then invoice_num order, exactly as writeInvoiceReport renders each one. All the
+//headers are read with one query and all the lines with another, in the same order, and the two are merged as they are read, so the cost is two index
+//range scans however many invoices there are rather than two queries per invoice
+InvoiceBatchResult writeInvoiceBatch(sqlite3 *, const InvoiceBatchRequest &, ReportRenderer &);
+
+//Renders the certification record report for one employee
+OpResult writeCertificationReport(sqlite3 *, const CertificationRequest &, ReportRenderer &);
+
+#endif
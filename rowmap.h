@@ -0,0 +1,63 @@
+/* Program name: rowmap.h
+* Purpose: Typed row decoding for libpokemart queries. Columns are read straight from the statement with sqlite3_column_int64/double instead of being copied
+*  into a std::string and re-parsed, and text columns come back as std::string_view into SQLite's own buffer. A string_view is only valid until the next
+*  sqlite3_step, sqlite3_reset or sqlite3_finalize on the statement, so copy it if it has to outlive the row.
+*/
+
+#ifndef ROWMAP_H
+#define ROWMAP_H
+
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <sqlite3.h>
+
+//Reads column col of the current row as T. Only the specializations below exist, so asking for an unsupported type fails to link
+template<typename T>
+T readColumn(sqlite3_stmt *res, int col);
+
+template<>
+inline int readColumn<int>(sqlite3_stmt *res, int col){
+	return sqlite3_column_int(res, col);
+}
+
+template<>
+inline sqlite3_int64 readColumn<sqlite3_int64>(sqlite3_stmt *res, int col){
+	return sqlite3_column_int64(res, col);
+}
+
+template<>
+inline double readColumn<double>(sqlite3_stmt *res, int col){
+	return sqlite3_column_double(res, col);
+}
+
+template<>
+inline std::string_view readColumn<std::string_view>(sqlite3_stmt *res, int col){
+	const unsigned char *text = sqlite3_column_text(res, col); //Must be called before sqlite3_column_bytes so the byte count is for the text form
+	if(text == NULL){return std::string_view();}
+	return std::string_view(reinterpret_cast<const char *>(text), sqlite3_column_bytes(res, col));
+}
+
+template<typename... Columns, std::size_t... Index>
+std::tuple<Columns...> readRowAt(sqlite3_stmt *res, std::index_sequence<Index...>){
+	return std::tuple<Columns...>(readColumn<Columns>(res, Index)...);
+}
+
+//Decodes the first sizeof...(Columns) columns of the current row, in order
+template<typename... Columns>
+std::tuple<Columns...> readRow(sqlite3_stmt *res){
+	return readRowAt<Columns...>(res, std::index_sequence_for<Columns...>());
+}
+
+//Steps through every remaining row of res and calls rowFunction with the decoded columns as arguments. Returns SQLITE_DONE when all rows were read, or the
+//error code sqlite3_step stopped with
+template<typename... Columns, typename RowFunction>
+int forEachRow(sqlite3_stmt *res, RowFunction rowFunction){
+	int rc;
+	while((rc = sqlite3_step(res)) == SQLITE_ROW){
+		std::apply(rowFunction, readRow<Columns...>(res));
+	}
+	return rc;
+}
+
+#endif
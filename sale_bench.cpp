@@ -0,0 +1,163 @@
+/* Program name: sale_bench.cpp
+* Purpose: Measures heap allocations per sale. Builds a database from tables.sql and inserts.sql with enough stock and money that no sale triggers a vendor
+*  reorder, then counts every operator new made by recordSale (through the stock counters) for one-line and five-line baskets once the statements and the
+*  counters' scratch buffer are warm. The difference between the two is what each extra line costs. Fails if a line allocates anything. SQLite's own allocations are
+*  not operator new and are not counted. Then checks the counters cannot oversell: the stock of one product is set outside the counters, and several
+*  register threads sell it one at a time until they are refused. Fails unless exactly that stock was sold.
+*  Usage: sale_bench [database_path] [sales] (the database is rebuilt on every run)
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "pokemart.h"
+#include "stockcounters.h"
+
+static std::atomic<long long> heapAllocations(0);
+
+void *operator new(size_t bytes){
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	void *block = std::malloc(bytes == 0 ? 1 : bytes);
+	if(block == NULL){throw std::bad_alloc();}
+	return block;
+}
+
+void operator delete(void *block) noexcept {std::free(block);}
+void operator delete(void *block, size_t) noexcept {std::free(block);}
+
+//Runs one sql file from the source directory
+static bool runFile(sqlite3 *db, const std::string &fileName){
+	std::ifstream file(fileName);
+	if(!file){
+		std::cerr << fileName << " not found; run the benchmark from the source directory\n";
+		return false;
+	}
+	std::stringstream sql;
+	sql << file.rdbuf();
+	if(sqlite3_exec(db, sql.str().c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error running " << fileName << ": " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+//Gives PokeMart 1 plenty of every product and enough money that no sale reorders
+static bool buildDatabase(sqlite3 *db){
+	if(!runFile(db, "tables.sql") || !runFile(db, "inserts.sql")){return false;}
+	std::string sql = "INSERT INTO stock_history (prod_code, mart_id, stock_qty, stock_date) SELECT prod_code, 1, 1000000000, '2024-03-01 00:00:00' FROM product;";
+	sql += "INSERT INTO mart_balance_history (balance, mart_id, balance_date) VALUES (1000000000, 1, '2024-03-01 00:00:00');";
+	if(sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error stocking benchmark database: " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+//Records the sale count times, returning the operator new calls per sale
+static double allocationsPerSale(sqlite3 *db, StockCounters &counters, const SaleRequest &request, int count, bool &ok){
+	long long before = heapAllocations.load();
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < count && ok; i++){
+		SaleResult result = recordSale(db, request, counters);
+		if(!result.ok()){
+			std::cerr << result.error << '\n';
+			ok = false;
+		}
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	double perSale = static_cast<double>(heapAllocations.load() - before) / count;
+	std::cout << request.basket.size() << " line sales: " << perSale << " allocations per sale, " << elapsed.count() / count * 1e6 << " us per sale\n";
+	return perSale;
+}
+
+const int REGISTERS = 4;
+const int LAST_STOCK = 300;
+
+//Sets the stock of Super Potions at PokeMart 1 to LAST_STOCK with a row the counters never see, with no reorder point so selling them never reorders.
+//Then REGISTERS threads, each with its own connection as in the clerk server, sell one at a time through the shared counters until they are refused
+static bool checkOversell(const std::string &path, sqlite3 *db, StockCounters &counters){
+	std::string sql = "INSERT INTO reorder_point (mart_id, prod_code, min_qty) VALUES (1, 'SP', 0);";
+	sql += "INSERT INTO stock_history (prod_code, mart_id, stock_qty, stock_date) VALUES ('SP', 1, " + std::to_string(LAST_STOCK) + ", '2024-03-02 00:00:00');";
+	if(sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error setting the last stock: " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+
+	std::atomic<int> sold(0), failed(0);
+	std::vector<std::thread> registers;
+	for(int r = 0; r < REGISTERS; r++){
+		registers.emplace_back([&]{
+			sqlite3 *registerDB;
+			OpResult prepared;
+			if(sqlite3_open_v2(path.c_str(), &registerDB, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK){prepared.rc = SQLITE_CANTOPEN;}
+			sqlite3_busy_timeout(registerDB, 5000);
+			if(prepared.ok()){prepared = enableForeignKeys(registerDB);}
+			if(prepared.ok()){prepared = prepareStatements(registerDB);}
+			if(!prepared.ok()){failed++;}
+			SaleRequest request{1, 1, 1, {{"SP", 1}}};
+			while(prepared.ok() && recordSale(registerDB, request, counters).ok()){sold++;}
+			finalizeStatements(registerDB);
+			sqlite3_close(registerDB);
+		});
+	}
+	for(std::thread &worker : registers){worker.join();}
+
+	int left = counters.available(counters.slot(1, "SP"));
+	std::cout << REGISTERS << " registers sold " << sold.load() << " of the last " << LAST_STOCK << " Super Potions (counter left at " << left << ", "
+		<< counters.resyncs() << " resyncs)\n";
+	if(failed > 0 || sold != LAST_STOCK || left != 0){
+		std::cerr << "The stock counters let the registers sell a different quantity than was in stock\n";
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]){
+	std::string path = argc > 1 ? argv[1] : "sale_bench.db";
+	int sales = argc > 2 ? std::atoi(argv[2]) : 2000;
+	std::remove(path.c_str());
+
+	sqlite3 *db;
+	if(sqlite3_open(path.c_str(), &db) != SQLITE_OK){
+		std::cerr << "Error opening " << path << ": " << sqlite3_errmsg(db) << '\n';
+		return 1;
+	}
+	sqlite3_exec(db, "PRAGMA synchronous = OFF", NULL, NULL, NULL); //Measuring allocations, not the disk
+	StockCounters counters;
+	OpResult prepared;
+	if(buildDatabase(db)){prepared = enableForeignKeys(db);} //Sales pay for the foreign key checks, as they do in main
+	else{prepared.rc = -1;}
+	if(prepared.ok()){prepared = prepareStatements(db);}
+	if(prepared.ok()){prepared = counters.load(db);}
+	if(!prepared.ok()){
+		std::cerr << prepared.error << '\n';
+		sqlite3_close(db);
+		return 1;
+	}
+
+	SaleRequest oneLine{1, 1, 1, {{"PB", 1}}};
+	SaleRequest fiveLines{1, 1, 1, {{"PB", 1}, {"GB", 1}, {"UB", 1}, {"BP", 1}, {"SP", 1}}};
+	bool ok = true;
+	allocationsPerSale(db, counters, fiveLines, 10, ok); //Warm up SQLite's caches and the counters' scratch buffer
+	double one = allocationsPerSale(db, counters, oneLine, sales, ok);
+	double five = allocationsPerSale(db, counters, fiveLines, sales, ok);
+	if(ok){ok = checkOversell(path, db, counters);}
+	finalizeStatements(db);
+	sqlite3_close(db);
+	if(!ok){return 1;}
+
+	double perLine = (five - one) / 4;
+	std::cout << "Allocations per extra line: " << perLine << '\n';
+	if(perLine > 0){
+		std::cerr << "Sale lines allocate on the heap\n";
+		return 1;
+	}
+	return 0;
+}
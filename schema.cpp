@@ -0,0 +1,215 @@
+/* Program name: schema.cpp
+* Purpose: Brings an existing pokemart.db up to date with tables.sql. Each migration runs once, in order, in its own transaction, and PRAGMA user_version
+*  records how many have been applied. A database created from tables.sql already has the latest schema and sets user_version to match, so nothing runs.
+*  To change the schema, update tables.sql (including its user_version) and add the matching migration to the end of MIGRATIONS.
+*/
+
+#include "pokemart.h"
+#include "pokemart_internal.h"
+
+//MIGRATIONS[i] upgrades a database from user_version i to i + 1
+const char *const MIGRATIONS[] = {
+	//1: Store the price and total of each line, and the subtotal, tax and total of each invoice, at the time of sale. Existing rows are filled in from the
+	//current product prices since that is the best information available for them
+	"ALTER TABLE line ADD COLUMN unit_price NUMERIC(6,3) NOT NULL DEFAULT 0;"
+	"ALTER TABLE line ADD COLUMN line_total NUMERIC(9,3) NOT NULL DEFAULT 0;"
+	"ALTER TABLE invoice ADD COLUMN subtotal NUMERIC(9,3) NOT NULL DEFAULT 0;"
+	"ALTER TABLE invoice ADD COLUMN tax NUMERIC(9,3) NOT NULL DEFAULT 0;"
+	"ALTER TABLE invoice ADD COLUMN total NUMERIC(9,3) NOT NULL DEFAULT 0;"
+	"UPDATE line SET unit_price = COALESCE((SELECT p.unit_price FROM product p WHERE p.prod_code = line.prod_code), 0);"
+	"UPDATE line SET line_total = unit_price * qty;"
+	"UPDATE invoice SET subtotal = COALESCE((SELECT SUM(l.line_total) FROM line l WHERE l.invoice_num = invoice.invoice_num), 0);"
+	"UPDATE invoice SET tax = subtotal * tax_rate, total = subtotal + subtotal * tax_rate;",
+	//2: Index the history tables by mart so the latest stock and balance (highest id per mart and product) are found without scanning the whole history.
+	//History compaction (compaction.cpp) relies on these to keep the latest rows in place
+	"CREATE INDEX IF NOT EXISTS stock_history_mart_prod ON stock_history(mart_id, prod_code);"
+	"CREATE INDEX IF NOT EXISTS mart_balance_history_mart ON mart_balance_history(mart_id);",
+	//3: Index shifts by employee and date so a payroll run (payroll.cpp) can read an emp_id range of a pay period in order without sorting
+	"CREATE INDEX IF NOT EXISTS shift_emp_date ON shift(emp_id, shift_date);",
+	//4: Per-PokeMart reorder points from demand forecasting (forecast.cpp). Until a forecast is run, sales keep using product.min_qty
+	"CREATE TABLE reorder_point (mart_id INTEGER REFERENCES pokemart(mart_id) NOT NULL, prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL, "
+	"min_qty SMALLINT NOT NULL, demand NUMERIC(9,3) NOT NULL DEFAULT 0, updated TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP, PRIMARY KEY (mart_id, prod_code));",
+	//5: Unix time next to the local time text of every history row, so range queries compare integers (timestamp.h). Existing rows are converted from their
+	//text, which is local time; rows whose text is not a valid date are left NULL
+	"ALTER TABLE stock_history ADD COLUMN stock_epoch INTEGER;"
+	"ALTER TABLE mart_balance_history ADD COLUMN balance_epoch INTEGER;"
+	"UPDATE stock_history SET stock_epoch = CAST(strftime('%s', stock_date, 'utc') AS INTEGER);"
+	"UPDATE mart_balance_history SET balance_epoch = CAST(strftime('%s', balance_date, 'utc') AS INTEGER);",
+	//6: An append-only ledger of trainer balance changes (ledger.h). Balances that already exist become each trainer's opening entry
+	"CREATE TABLE trainer_ledger (ledger_id INTEGER PRIMARY KEY AUTOINCREMENT, trainer_id INTEGER REFERENCES trainer_card(trainer_id) NOT NULL, "
+	"entry_kind VARCHAR(10) NOT NULL, invoice_num INTEGER REFERENCES invoice(invoice_num), amount NUMERIC(9,3) NOT NULL, balance NUMERIC(9,3) NOT NULL, "
+	"entry_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP, entry_epoch INTEGER);"
+	"CREATE INDEX trainer_ledger_trainer_epoch ON trainer_ledger(trainer_id, entry_epoch);"
+	"INSERT INTO trainer_ledger (trainer_id, entry_kind, amount, balance, entry_date, entry_epoch) "
+	"SELECT trainer_id, 'opening', balance, balance, datetime('now', 'localtime'), CAST(strftime('%s', 'now') AS INTEGER) FROM trainer_card WHERE COALESCE(balance, 0) <> 0;",
+	//7: Stock transfers between PokeMarts (rebalance.h). Both stock_history rows of a transfer carry its transfer_id
+	"CREATE TABLE stock_transfer (transfer_id INTEGER PRIMARY KEY AUTOINCREMENT, prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL, "
+	"from_mart INTEGER REFERENCES pokemart(mart_id) NOT NULL, to_mart INTEGER REFERENCES pokemart(mart_id) NOT NULL, qty SMALLINT NOT NULL, "
+	"transfer_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP, transfer_epoch INTEGER);"
+	"ALTER TABLE stock_history ADD COLUMN transfer_id INTEGER REFERENCES stock_transfer(transfer_id);",
+	//8: Products in req_badges order, so the product picker reads only the products a trainer has the badges for as one range of the index
+	"CREATE INDEX IF NOT EXISTS product_req_badges ON product(req_badges);",
+	//9: Foreign keys are enforced from this version on (enableForeignKeys). Deleting a parent row looks for children by the referencing column, so every
+	//referencing column not already leading an index gets one (transfer_id only for the transfer rows that set it). Trainers and employees that still have
+	//history are retired (retired_date) instead of deleted. The original seed data sold product 'PKB', which does not exist ('PB' was meant, as inserts.sql
+	//now has it), so that line is repriced as 'PB' the way migration 1 would have and its invoice totalled again. Any other row left pointing at a missing
+	//parent fails this migration (foreignKeyViolation) rather than being guessed at
+	"UPDATE line SET unit_price = (SELECT p.unit_price FROM product p WHERE p.prod_code = 'PB'), "
+	"line_total = qty * (SELECT p.unit_price FROM product p WHERE p.prod_code = 'PB') "
+	"WHERE prod_code = 'PKB' AND NOT EXISTS (SELECT 1 FROM product WHERE prod_code = 'PKB') AND EXISTS (SELECT 1 FROM product WHERE prod_code = 'PB');"
+	"UPDATE invoice SET subtotal = COALESCE((SELECT SUM(l.line_total) FROM line l WHERE l.invoice_num = invoice.invoice_num), 0) "
+	"WHERE invoice_num IN (SELECT invoice_num FROM line WHERE prod_code = 'PKB') "
+	"AND NOT EXISTS (SELECT 1 FROM product WHERE prod_code = 'PKB') AND EXISTS (SELECT 1 FROM product WHERE prod_code = 'PB');"
+	"UPDATE invoice SET tax = subtotal * tax_rate, total = subtotal + subtotal * tax_rate "
+	"WHERE invoice_num IN (SELECT invoice_num FROM line WHERE prod_code = 'PKB') "
+	"AND NOT EXISTS (SELECT 1 FROM product WHERE prod_code = 'PKB') AND EXISTS (SELECT 1 FROM product WHERE prod_code = 'PB');"
+	"UPDATE line SET prod_code = 'PB' "
+	"WHERE prod_code = 'PKB' AND NOT EXISTS (SELECT 1 FROM product WHERE prod_code = 'PKB') AND EXISTS (SELECT 1 FROM product WHERE prod_code = 'PB');"
+	"CREATE INDEX IF NOT EXISTS product_vendor ON product(vendor_id);"
+	"CREATE INDEX IF NOT EXISTS certification_record_cert ON certification_record(cert_id);"
+	"CREATE INDEX IF NOT EXISTS shift_cert ON shift(cert_id);"
+	"CREATE INDEX IF NOT EXISTS invoice_trainer_date ON invoice(trainer_id, invoice_date);"
+	"CREATE INDEX IF NOT EXISTS invoice_emp_date ON invoice(emp_id, invoice_date);"
+	"CREATE INDEX IF NOT EXISTS invoice_mart ON invoice(mart_id);"
+	"CREATE INDEX IF NOT EXISTS line_prod ON line(prod_code);"
+	"CREATE INDEX IF NOT EXISTS stock_history_prod ON stock_history(prod_code);"
+	"CREATE INDEX IF NOT EXISTS stock_history_transfer ON stock_history(transfer_id) WHERE transfer_id IS NOT NULL;"
+	"CREATE INDEX IF NOT EXISTS stock_transfer_prod ON stock_transfer(prod_code);"
+	"CREATE INDEX IF NOT EXISTS stock_transfer_from ON stock_transfer(from_mart);"
+	"CREATE INDEX IF NOT EXISTS stock_transfer_to ON stock_transfer(to_mart);"
+	"CREATE INDEX IF NOT EXISTS trainer_ledger_invoice ON trainer_ledger(invoice_num);"
+	"CREATE INDEX IF NOT EXISTS reorder_point_prod ON reorder_point(prod_code);"
+	"ALTER TABLE trainer_card ADD COLUMN retired_date TIMESTAMP;"
+	"ALTER TABLE employee ADD COLUMN retired_date TIMESTAMP;",
+	//10: As-of lookups (asof.h). History in date order per mart (and product), so the row in effect at any time is one seek back from it, and checkpoint
+	//tables holding the stock and balance of every mart at chosen times, which stay correct after compaction archives the rows they were read from
+	"CREATE INDEX IF NOT EXISTS stock_history_mart_prod_epoch ON stock_history(mart_id, prod_code, stock_epoch);"
+	"CREATE INDEX IF NOT EXISTS mart_balance_history_mart_epoch ON mart_balance_history(mart_id, balance_epoch);"
+	"CREATE TABLE history_checkpoint (checkpoint_epoch INTEGER PRIMARY KEY, checkpoint_date TIMESTAMP NOT NULL, stock_rows INTEGER NOT NULL DEFAULT 0, "
+	"balance_rows INTEGER NOT NULL DEFAULT 0, created TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP);"
+	"CREATE TABLE stock_checkpoint (mart_id INTEGER REFERENCES pokemart(mart_id) NOT NULL, prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL, "
+	"checkpoint_epoch INTEGER NOT NULL, stock_id INTEGER NOT NULL, stock_date TIMESTAMP NOT NULL, stock_epoch INTEGER NOT NULL, stock_qty SMALLINT NOT NULL, "
+	"PRIMARY KEY (mart_id, prod_code, checkpoint_epoch));"
+	"CREATE TABLE balance_checkpoint (mart_id INTEGER REFERENCES pokemart(mart_id) NOT NULL, checkpoint_epoch INTEGER NOT NULL, balance_id INTEGER NOT NULL, "
+	"balance_date TIMESTAMP NOT NULL, balance_epoch INTEGER NOT NULL, balance NUMERIC(9,3) NOT NULL, PRIMARY KEY (mart_id, checkpoint_epoch));"
+	"CREATE INDEX IF NOT EXISTS stock_checkpoint_prod ON stock_checkpoint(prod_code);",
+	//11: Effective-dated prices and promotions (pricing.h), each for one PokeMart, one region or (with neither set) every PokeMart. Until one is scheduled,
+	//sales keep charging product.unit_price
+	"CREATE TABLE product_price (price_id INTEGER PRIMARY KEY AUTOINCREMENT, prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL, "
+	"mart_id INTEGER REFERENCES pokemart(mart_id), region VARCHAR(50), unit_price NUMERIC(6,3) NOT NULL, starts TIMESTAMP NOT NULL, ends TIMESTAMP, "
+	"start_epoch INTEGER NOT NULL, end_epoch INTEGER, CHECK (mart_id IS NULL OR region IS NULL));"
+	"CREATE TABLE promotion (promo_id INTEGER PRIMARY KEY AUTOINCREMENT, prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL, "
+	"mart_id INTEGER REFERENCES pokemart(mart_id), region VARCHAR(50), percent_off NUMERIC(5,3) NOT NULL, starts TIMESTAMP NOT NULL, ends TIMESTAMP, "
+	"start_epoch INTEGER NOT NULL, end_epoch INTEGER, CHECK (mart_id IS NULL OR region IS NULL), CHECK (percent_off > 0 AND percent_off <= 100));"
+	"CREATE INDEX IF NOT EXISTS product_price_prod ON product_price(prod_code);"
+	"CREATE INDEX IF NOT EXISTS product_price_mart ON product_price(mart_id) WHERE mart_id IS NOT NULL;"
+	"CREATE INDEX IF NOT EXISTS promotion_prod ON promotion(prod_code);"
+	"CREATE INDEX IF NOT EXISTS promotion_mart ON promotion(mart_id) WHERE mart_id IS NOT NULL;",
+	//12: Batch receipts (report.h) read a range of dates in invoice_date order
+	"CREATE INDEX IF NOT EXISTS invoice_by_date ON invoice(invoice_date);",
+	//13: When each employee was hired, so the purge (purge.h) never takes someone hired since its date for inactive. Existing employees are dated from their
+	//first certification, shift or sale, or from now if they have none, which keeps them until the purge is run with a later date
+	"ALTER TABLE employee ADD COLUMN hire_date TIMESTAMP;"
+	"UPDATE employee SET hire_date = MIN("
+	"COALESCE((SELECT MIN(c.cert_date) FROM certification_record c WHERE c.emp_id = employee.emp_id), CURRENT_TIMESTAMP), "
+	"COALESCE((SELECT MIN(s.shift_date) FROM shift s WHERE s.emp_id = employee.emp_id), CURRENT_TIMESTAMP), "
+	"COALESCE((SELECT MIN(i.invoice_date) FROM invoice i WHERE i.emp_id = employee.emp_id), CURRENT_TIMESTAMP));",
+};
+
+const int SCHEMA_VERSION = sizeof(MIGRATIONS) / sizeof(MIGRATIONS[0]);
+
+//The first version that enforces foreign keys. Every migration to it or past it must leave no row pointing at a missing parent
+const int FOREIGN_KEY_VERSION = 9;
+
+//Reads PRAGMA user_version
+static int schemaVersion(sqlite3 *db, int &version, OpResult &result){
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error reading schema version");}
+	rc = sqlite3_step(res);
+	if(rc != SQLITE_ROW){return fail(result, db, res, "Error reading schema version");}
+	version = sqlite3_column_int(res, 0);
+	sqlite3_finalize(res);
+	return SQLITE_OK;
+}
+
+//Runs PRAGMA foreign_key_check and describes the first row it finds pointing at a missing parent, leaving violation empty if there is none
+static int foreignKeyViolation(sqlite3 *db, std::string &violation, OpResult &result){
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(db, "PRAGMA foreign_key_check", -1, &res, NULL);
+	if(rc != SQLITE_OK){return fail(result, db, res, "Error checking foreign keys");}
+	rc = sqlite3_step(res);
+	if(rc == SQLITE_ROW){
+		violation = "row " + std::to_string(sqlite3_column_int64(res, 1)) + " of " + reinterpret_cast<const char *>(sqlite3_column_text(res, 0)) +
+			" references a missing " + reinterpret_cast<const char *>(sqlite3_column_text(res, 2));
+	}
+	else if(rc != SQLITE_DONE){return fail(result, db, res, "Error checking foreign keys");}
+	sqlite3_finalize(res);
+	return SQLITE_OK;
+}
+
+OpResult migrateSchema(sqlite3 *db){
+	OpResult result;
+	int version;
+	if(schemaVersion(db, version, result) != SQLITE_OK){return result;}
+	if(version > SCHEMA_VERSION){
+		fail(result, "pokemart.db has schema version " + std::to_string(version) + ", which is newer than this program supports (" + std::to_string(SCHEMA_VERSION) + ")");
+		return result;
+	}
+
+	for(; version < SCHEMA_VERSION; version++){
+		int rc = startTransaction(db);
+		if(rc != SQLITE_OK){
+			fail(result, db, NULL, "Unable to start schema migration transaction");
+			return result;
+		}
+		std::string sql = MIGRATIONS[version];
+		sql += "PRAGMA user_version = " + std::to_string(version + 1) + ";";
+		rc = sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL);
+		if(rc != SQLITE_OK){
+			fail(result, db, NULL, "Error applying schema migration " + std::to_string(version + 1));
+			rollback(db);
+			return result;
+		}
+		if(version + 1 >= FOREIGN_KEY_VERSION){
+			std::string violation;
+			if(foreignKeyViolation(db, violation, result) != SQLITE_OK){
+				rollback(db);
+				return result;
+			}
+			if(!violation.empty()){
+				fail(result, "Schema migration " + std::to_string(version + 1) + " stopped: " + violation + ". Repair or remove it and run again");
+				rollback(db);
+				return result;
+			}
+		}
+		rc = commit(db);
+		if(rc != SQLITE_OK){
+			fail(result, db, NULL, "Error committing schema migration " + std::to_string(version + 1));
+			return result;
+		}
+	}
+	return result;
+}
+
+//Foreign keys are off on every new SQLite connection, and PRAGMA foreign_keys is silently ignored inside a transaction or by a SQLite built without them,
+//so the setting is read back to make sure it took
+OpResult enableForeignKeys(sqlite3 *db){
+	OpResult result;
+	int rc = sqlite3_exec(db, "PRAGMA foreign_keys = ON", NULL, NULL, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, NULL, "Error enabling foreign keys");
+		return result;
+	}
+	sqlite3_stmt *res;
+	rc = sqlite3_prepare_v2(db, "PRAGMA foreign_keys", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error reading foreign key setting");
+		return result;
+	}
+	rc = sqlite3_step(res);
+	bool enabled = rc == SQLITE_ROW && sqlite3_column_int(res, 0) == 1;
+	sqlite3_finalize(res);
+	if(!enabled){fail(result, "Foreign keys could not be enabled on this connection");}
+	return result;
+}
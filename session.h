@@ -0,0 +1,166 @@
+/* Program name: session.h
+* Purpose: The coroutine types clerk sessions (clerk.h) are written with. A SessionTask is a coroutine that can co_await another SessionTask, and a
+*  ClerkTerminal holds one clerk's typed input and the stream their screen is written to. When a session needs a word the terminal does not have yet,
+*  the whole chain of coroutines suspends and control returns to whatever resumed it: the console loop in main, or a server thread that owns hundreds of
+*  sessions. That driver resumes the session once more input has arrived, so a waiting clerk costs a few small coroutine frames instead of a thread.
+*/
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+template<typename T> struct SessionPromise;
+
+//Owns the coroutine frame; destroying a task destroys the coroutine, and every task it is awaiting, wherever it is suspended. A task starts suspended
+//and runs when it is awaited (or started by its driver)
+template<typename T = void>
+class [[nodiscard]] SessionTask{
+public:
+	typedef SessionPromise<T> promise_type;
+
+	explicit SessionTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+	SessionTask(SessionTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	SessionTask &operator=(SessionTask &&other) noexcept {
+		if(this != &other){
+			if(handle){handle.destroy();}
+			handle = std::exchange(other.handle, nullptr);
+		}
+		return *this;
+	}
+	~SessionTask(){if(handle){handle.destroy();}}
+
+	//Awaiting a task runs it until it finishes, suspending the awaiting coroutine for as long as the task waits for input
+	bool await_ready() const noexcept {return false;}
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+		handle.promise().continuation = caller;
+		return handle;
+	}
+	T await_resume(){
+		if constexpr(!std::is_void_v<T>){return std::move(*handle.promise().value);}
+	}
+
+	//For the driver of a top level session: runs it until it first waits for input or finishes
+	void start(){handle.resume();}
+	bool done() const {return !handle || handle.done();}
+
+private:
+	std::coroutine_handle<promise_type> handle;
+};
+
+//When a task finishes, control transfers straight back to the coroutine awaiting it, so a chain of nested calls never grows the real stack
+struct SessionPromiseBase{
+	std::coroutine_handle<> continuation = std::noop_coroutine();
+
+	struct FinalAwaiter{
+		bool await_ready() noexcept {return false;}
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept {return finished.promise().continuation;}
+		void await_resume() noexcept {}
+	};
+
+	std::suspend_always initial_suspend() noexcept {return {};}
+	FinalAwaiter final_suspend() noexcept {return {};}
+	void unhandled_exception(){std::terminate();} //The library reports errors in results, so an exception here is a bug
+};
+
+template<typename T>
+struct SessionPromise : SessionPromiseBase{
+	std::optional<T> value;
+	SessionTask<T> get_return_object(){return SessionTask<T>(std::coroutine_handle<SessionPromise>::from_promise(*this));}
+	void return_value(T result){value = std::move(result);}
+};
+
+template<>
+struct SessionPromise<void> : SessionPromiseBase{
+	SessionTask<void> get_return_object(){return SessionTask<void>(std::coroutine_handle<SessionPromise>::from_promise(*this));}
+	void return_void(){}
+};
+
+//One clerk's terminal. The driver appends whatever the clerk typed with input() and calls resume(); the session reads it a word at a time the way the
+//menu used to read std::cin, and writes its screen to out. The driver is responsible for getting out to the clerk
+class ClerkTerminal{
+public:
+	explicit ClerkTerminal(std::ostream &out) : out(out) {}
+	ClerkTerminal(const ClerkTerminal &) = delete;
+	ClerkTerminal &operator=(const ClerkTerminal &) = delete;
+
+	std::ostream &out;
+
+	//co_await terminal.word() gives the next whitespace delimited word, suspending the session until a complete one has been typed
+	struct WordAwaiter{
+		ClerkTerminal &terminal;
+		bool await_ready(){return terminal.hasWord();}
+		void await_suspend(std::coroutine_handle<> session){terminal.waiting = session;}
+		std::string await_resume(){return terminal.takeWord();}
+	};
+	WordAwaiter word(){return {*this};}
+
+	//Drops the rest of the current line, as the menu did after a word that was not a number
+	void discardLine(){
+		size_t newline = buffer.find('\n', pos);
+		if(newline == std::string::npos){
+			pos = buffer.size();
+			discarding = true;
+		}
+		else{pos = newline + 1;}
+	}
+
+	void input(std::string_view text){
+		if(discarding){
+			size_t newline = text.find('\n');
+			if(newline == std::string_view::npos){return;}
+			discarding = false;
+			text.remove_prefix(newline + 1);
+		}
+		if(pos > 0 && pos * 2 >= buffer.size()){ //Drop what has been read before the buffer grows
+			buffer.erase(0, pos);
+			pos = 0;
+		}
+		buffer.append(text);
+	}
+
+	//Resumes the session if it is waiting for a word that has now been typed. Returns whether it ran
+	bool resume(){
+		if(!waiting || !hasWord()){return false;}
+		std::exchange(waiting, nullptr).resume();
+		return true;
+	}
+
+	bool waitingForInput() const {return static_cast<bool>(waiting);}
+	size_t buffered() const {return buffer.size() - pos;} //Input typed but not read yet
+
+private:
+	static bool space(char c){return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';}
+
+	//A word is complete once the whitespace after it has arrived
+	bool hasWord(){
+		while(pos < buffer.size() && space(buffer[pos])){pos++;}
+		for(size_t i = pos; i < buffer.size(); i++){
+			if(space(buffer[i])){return true;}
+		}
+		return false;
+	}
+
+	std::string takeWord(){
+		size_t end = pos;
+		while(end < buffer.size() && !space(buffer[end])){end++;}
+		std::string word = buffer.substr(pos, end - pos);
+		pos = end;
+		return word;
+	}
+
+	std::string buffer;
+	size_t pos = 0;
+	bool discarding = false; //discardLine found no newline yet, so input drops text up to the next one
+	std::coroutine_handle<> waiting;
+};
+
+#endif
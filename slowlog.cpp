@@ -0,0 +1,279 @@
+/* Program name: slowlog.cpp
+* Purpose: Implements the slow statement log declared in slowlog.h. Each traced connection gets a trace callback for SQLITE_TRACE_ROW, which counts the
+*  rows each statement returns, and SQLITE_TRACE_PROFILE, which fires as a statement finishes with the time it took. The statement's counters are read
+*  and reset there, so a reused prepared statement reports each run on its own. Page cache misses are only counted per connection, so a statement is given
+*  the misses since the last statement on its connection finished. No SQL is run from inside the callback: the first time a statement is slow its SQL is
+*  queued for the log's planner thread, which reads the plan on read-only connections of its own.
+*/
+
+#include "slowlog.h"
+#include "timestamp.h"
+#include "pokemart_internal.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+//A slow statement whose plan the planner thread has yet to read
+struct PlanRequest{
+	std::string path; //Database file the statement ran against
+	std::string sql;
+};
+
+struct SlowLogFile{
+	SlowLogRequest request;
+	std::ofstream out;
+	sqlite3_int64 bytes = 0;
+	std::unordered_set<std::string> planned; //SQL (before parameters are filled in) whose plan has been written or queued
+
+	std::thread planner;
+	std::mutex planMutex; //Taken after logMutex, never before it
+	std::condition_variable planWake;
+	std::deque<PlanRequest> plans;
+	bool stopping = false;
+};
+
+//Per connection trace state, only touched by the thread using the connection
+struct ConnectionTrace{
+	sqlite3 *db;
+	std::unordered_map<sqlite3_stmt *, sqlite3_int64> rows; //Rows returned so far by each running statement
+};
+
+struct SlowStatement{
+	double ms;
+	sqlite3_int64 rows = 0;
+	int vmSteps, fullScanSteps, sorts, autoIndexes, cacheMisses;
+};
+
+static std::mutex logMutex;
+static std::unique_ptr<SlowLogFile> slowLog;
+static std::atomic<sqlite3_int64> thresholdNs{-1}; //-1 while no log is open, so the callbacks skip the lock
+
+static std::mutex tracesMutex;
+static std::unordered_map<sqlite3 *, std::unique_ptr<ConnectionTrace>> traces;
+
+//Renames the log to .1, .1 to .2 and so on, dropping the oldest, and starts an empty log. Called with logMutex held
+static void rotateLog(SlowLogFile &log){
+	const std::string &path = log.request.path;
+	log.out.close();
+	std::remove((path + "." + std::to_string(log.request.keepFiles)).c_str());
+	for(int i = log.request.keepFiles - 1; i >= 1; i--){
+		std::rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+	}
+	if(log.request.keepFiles > 0){std::rename(path.c_str(), (path + ".1").c_str());}
+	else{std::remove(path.c_str());}
+	log.out.open(path, std::ios::app);
+	log.bytes = 0;
+}
+
+//Appends an entry to the log, rotating it once it is full. Called with logMutex held
+static void writeEntry(SlowLogFile &log, const std::string &entry){
+	log.out << entry;
+	log.out.flush(); //The log is read while the registers are running
+	log.bytes += entry.size();
+	if(log.bytes >= log.request.maxBytes){rotateLog(log);}
+}
+
+//Writes the EXPLAIN QUERY PLAN of a queued statement to entry, one line per step indented under its parent. Returns false if no plan could be read for
+//now, in which case it is tried again the next time the statement is slow
+static bool writeQueryPlan(std::unordered_map<std::string, sqlite3 *> &connections, const PlanRequest &plan, std::ostringstream &entry){
+	sqlite3 *&planDB = connections[plan.path];
+	if(planDB == NULL){
+		if(sqlite3_open_v2(plan.path.c_str(), &planDB, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK){
+			entry << "  Query plan: unavailable (" << sqlite3_errmsg(planDB) << ")\n";
+			sqlite3_close(planDB);
+			planDB = NULL;
+			return false;
+		}
+		sqlite3_busy_timeout(planDB, 1000); //Waits out a commit in progress; nobody is waiting on this thread
+	}
+
+	sqlite3_stmt *res;
+	int rc = sqlite3_prepare_v2(planDB, ("EXPLAIN QUERY PLAN " + plan.sql).c_str(), -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		entry << "  Query plan: unavailable (" << sqlite3_errmsg(planDB) << ")\n";
+		sqlite3_finalize(res);
+		return rc != SQLITE_BUSY && rc != SQLITE_LOCKED; //Statements on attached or temporary tables never have a plan here
+	}
+	entry << "  Query plan:\n";
+	std::unordered_map<int, int> depth; //Plan step id to its indent
+	while((rc = sqlite3_step(res)) == SQLITE_ROW){
+		int id = sqlite3_column_int(res, 0);
+		auto parent = depth.find(sqlite3_column_int(res, 1));
+		int indent = parent == depth.end() ? 0 : parent->second + 1;
+		depth[id] = indent;
+		const unsigned char *detail = sqlite3_column_text(res, 3);
+		entry << "    " << std::string(indent * 2, ' ') << (detail != NULL ? reinterpret_cast<const char *>(detail) : "") << '\n';
+	}
+	sqlite3_finalize(res);
+	return rc == SQLITE_DONE;
+}
+
+//Reads the plans of queued statements until the log is closed and the queue is empty, writing each as its own entry
+static void runPlanner(SlowLogFile &log){
+	std::unordered_map<std::string, sqlite3 *> connections; //One read-only connection per database file
+	std::unique_lock<std::mutex> lock(log.planMutex);
+	while(true){
+		log.planWake.wait(lock, [&]{return log.stopping || !log.plans.empty();});
+		if(log.plans.empty()){break;} //Stopping, with every queued plan written
+		PlanRequest plan = std::move(log.plans.front());
+		log.plans.pop_front();
+		lock.unlock();
+
+		std::ostringstream entry;
+		entry << currentTimestamp().view() << " | query plan of a slow statement\n";
+		entry << "  SQL: " << plan.sql << '\n';
+		bool read = writeQueryPlan(connections, plan, entry);
+		{
+			std::lock_guard<std::mutex> logLock(logMutex);
+			if(read){writeEntry(log, entry.str());}
+			else{log.planned.erase(plan.sql);}
+		}
+		lock.lock();
+	}
+	for(auto &connection : connections){
+		sqlite3_close(connection.second);
+	}
+}
+
+//Stops the planner thread of a log that is no longer slowLog, once it has written the plans still queued
+static void stopPlanner(SlowLogFile &log){
+	{
+		std::lock_guard<std::mutex> lock(log.planMutex);
+		log.stopping = true;
+	}
+	log.planWake.notify_one();
+	log.planner.join();
+}
+
+static void logStatement(ConnectionTrace &trace, sqlite3_stmt *res, const SlowStatement &slow){
+	const char *text = sqlite3_sql(res);
+	std::string sql = text != NULL ? text : "";
+	char *expanded = sqlite3_expanded_sql(res);
+	const char *path = sqlite3_db_filename(trace.db, "main");
+
+	std::ostringstream entry;
+	entry << currentTimestamp().view() << " | " << slow.ms << " ms | " << slow.rows << " rows | " << slow.vmSteps << " VM steps | " << slow.fullScanSteps
+		<< " full scan steps | " << slow.sorts << " sorts | " << slow.autoIndexes << " automatic indexes | " << slow.cacheMisses << " cache misses\n";
+	entry << "  SQL: " << (expanded != NULL ? expanded : sql.c_str()) << '\n';
+	sqlite3_free(expanded);
+
+	std::lock_guard<std::mutex> lock(logMutex);
+	if(!slowLog){return;}
+	if(slowLog->planned.insert(sql).second){
+		if(path == NULL || *path == '\0'){entry << "  Query plan: unavailable for an in-memory database\n";}
+		else{
+			std::lock_guard<std::mutex> planLock(slowLog->planMutex);
+			slowLog->plans.push_back({path, sql});
+			slowLog->planWake.notify_one();
+		}
+	}
+	writeEntry(*slowLog, entry.str());
+}
+
+static int traceStatement(unsigned type, void *context, void *statement, void *detail){
+	ConnectionTrace &trace = *static_cast<ConnectionTrace *>(context);
+	sqlite3_stmt *res = static_cast<sqlite3_stmt *>(statement);
+	if(type == SQLITE_TRACE_ROW){
+		trace.rows[res]++;
+		return 0;
+	}
+
+	//SQLITE_TRACE_PROFILE: the statement has finished. Every counter is reset whether or not it is logged, so the next run starts from zero
+	SlowStatement slow;
+	auto counted = trace.rows.find(res);
+	if(counted != trace.rows.end()){
+		slow.rows = counted->second;
+		trace.rows.erase(counted);
+	}
+	slow.vmSteps = sqlite3_stmt_status(res, SQLITE_STMTSTATUS_VM_STEP, 1);
+	slow.fullScanSteps = sqlite3_stmt_status(res, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+	slow.sorts = sqlite3_stmt_status(res, SQLITE_STMTSTATUS_SORT, 1);
+	slow.autoIndexes = sqlite3_stmt_status(res, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+	int highwater;
+	sqlite3_db_status(trace.db, SQLITE_DBSTATUS_CACHE_MISS, &slow.cacheMisses, &highwater, 1);
+
+	sqlite3_int64 nanoseconds = *static_cast<sqlite3_int64 *>(detail);
+	sqlite3_int64 threshold = thresholdNs.load(std::memory_order_relaxed);
+	if(threshold < 0 || nanoseconds < threshold){return 0;}
+	slow.ms = nanoseconds / 1e6;
+	logStatement(trace, res, slow);
+	return 0;
+}
+
+OpResult openSlowLog(const SlowLogRequest &request){
+	OpResult result;
+	if(request.thresholdMs < 0 || request.maxBytes <= 0 || request.keepFiles < 0){
+		fail(result, "Slow log threshold and rotated log count cannot be negative, and its maximum size must be greater than 0");
+		return result;
+	}
+	std::unique_ptr<SlowLogFile> log = std::make_unique<SlowLogFile>();
+	log->request = request;
+	log->out.open(request.path, std::ios::app);
+	if(!log->out){
+		fail(result, "Error opening slow statement log " + request.path);
+		return result;
+	}
+	log->out.seekp(0, std::ios::end);
+	log->bytes = log->out.tellp();
+	log->planner = std::thread(runPlanner, std::ref(*log));
+
+	{
+		std::lock_guard<std::mutex> lock(logMutex);
+		std::swap(slowLog, log);
+		thresholdNs = static_cast<sqlite3_int64>(request.thresholdMs * 1e6);
+	}
+	if(log){stopPlanner(*log);} //The log this one replaced. Its planner takes logMutex to write, so it is stopped without holding it
+	return result;
+}
+
+void closeSlowLog(){
+	std::unique_ptr<SlowLogFile> log;
+	{
+		std::lock_guard<std::mutex> lock(logMutex);
+		thresholdNs = -1;
+		std::swap(slowLog, log);
+	}
+	if(log){stopPlanner(*log);}
+}
+
+OpResult traceSlowStatements(sqlite3 *db){
+	OpResult result;
+	if(thresholdNs.load() < 0){return result;}
+	std::lock_guard<std::mutex> lock(tracesMutex);
+	std::unique_ptr<ConnectionTrace> &trace = traces[db];
+	if(!trace){
+		trace = std::make_unique<ConnectionTrace>();
+		trace->db = db;
+	}
+	if(sqlite3_trace_v2(db, SQLITE_TRACE_ROW | SQLITE_TRACE_PROFILE, traceStatement, trace.get()) != SQLITE_OK){
+		traces.erase(db);
+		fail(result, db, NULL, "Error tracing connection for the slow statement log");
+	}
+	return result;
+}
+
+void untraceSlowStatements(sqlite3 *db){
+	std::lock_guard<std::mutex> lock(tracesMutex);
+	auto found = traces.find(db);
+	if(found == traces.end()){return;}
+	sqlite3_trace_v2(db, 0, NULL, NULL);
+	traces.erase(found);
+}
+
+bool slowLogFromEnvironment(SlowLogRequest &request){
+	const char *threshold = std::getenv("POKEMART_SLOW_MS");
+	if(threshold == NULL || *threshold == '\0'){return false;}
+	request.thresholdMs = std::atof(threshold);
+	const char *path = std::getenv("POKEMART_SLOW_LOG");
+	if(path != NULL && *path != '\0'){request.path = path;}
+	return true;
+}
@@ -0,0 +1,35 @@
+/* Program name: slowlog.h
+* Purpose: Declares the slow statement log. Once a log is open, every connection passed to traceSlowStatements is profiled with sqlite3_trace_v2, and each
+*  statement that runs longer than the threshold is written to the log with its SQL (parameters filled in), the rows it returned and its VM steps, full
+*  scan steps, sorts, automatic indexes and page cache misses. The first time a statement is slow its EXPLAIN QUERY PLAN is read by a thread of the log's
+*  own and written as an entry after it, so the register that ran the statement never waits for the plan. The log rotates
+*  when it reaches maxBytes: pokemart_slow.log becomes pokemart_slow.log.1, and so on up to keepFiles old logs.
+*/
+
+#ifndef SLOWLOG_H
+#define SLOWLOG_H
+
+#include <string>
+#include <sqlite3.h>
+#include "pokemart.h"
+
+struct SlowLogRequest{
+	std::string path = "pokemart_slow.log";
+	double thresholdMs = 100; //Statements taking at least this long are logged. 0 logs every statement
+	sqlite3_int64 maxBytes = 10 * 1024 * 1024; //Size at which the log is rotated
+	int keepFiles = 5; //Rotated logs kept next to the current one
+};
+
+//Opens the process's slow statement log, replacing any log already open. Connections are only traced once passed to traceSlowStatements
+OpResult openSlowLog(const SlowLogRequest &);
+void closeSlowLog();
+
+//Traces a connection into the open slow log, from whichever thread uses it. Does nothing if no log is open. Call untraceSlowStatements before closing a
+//traced connection. Query plans are read on the log's thread, with a read-only connection to each database file; in-memory databases get no plans
+OpResult traceSlowStatements(sqlite3 *);
+void untraceSlowStatements(sqlite3 *);
+
+//Reads POKEMART_SLOW_MS (the threshold; the log is off when it is unset) and POKEMART_SLOW_LOG (the path) into request. Returns false when the log is off
+bool slowLogFromEnvironment(SlowLogRequest &);
+
+#endif
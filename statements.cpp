@@ -0,0 +1,103 @@
+/* Program name: statements.cpp
+* Purpose: Implements the statement registry declared in statements.h. The prepared statements of each connection are kept in one array indexed by
+*  StatementID. Connections are looked up under a mutex, and each thread remembers the last connection it used so a register's statements are found
+*  without taking the lock.
+*/
+
+#include "statements.h"
+#include "pokemart_internal.h"
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+//Every entry of the registry, in StatementID order
+constexpr StatementText ALL_STATEMENTS[] = {
+	LIST_TRAINERS, LIST_EMPLOYEES, LIST_POKEMARTS, LIST_INVOICES, LIST_PRODUCTS,
+	INSERT_TRAINER, INSERT_EMPLOYEE, UPDATE_TRAINER_BALANCE, INSERT_ADJUSTMENT_LEDGER, UPDATE_TRAINER_BADGES, UPDATE_TRAINER_PHONE, UPDATE_EMPLOYEE_PHONE, DELETE_TRAINER, DELETE_EMPLOYEE,
+	RETIRE_TRAINER, RETIRE_EMPLOYEE,
+	INSERT_INVOICE, LATEST_MART_BALANCE, SALE_PRODUCT, INSERT_LINE, INSERT_STOCK_HISTORY, CHARGE_TRAINER, INSERT_SALE_LEDGER, INSERT_MART_BALANCE, STORE_INVOICE_TOTALS,
+	INSERT_STOCK_TRANSFER, INSERT_TRANSFER_STOCK,
+	AS_OF_STOCK, AS_OF_BALANCE, CHECKPOINT_PRODUCTS, CHECKPOINT_STOCK, CHECKPOINT_BALANCE,
+	INVOICE_HEADER, INVOICE_LINES, INVOICE_SUMMARY, INVOICE_BATCH_HEADERS, INVOICE_BATCH_LINES, EMPLOYEE_CERTIFICATIONS
+};
+
+constexpr size_t STATEMENT_COUNT = static_cast<size_t>(StatementID::COUNT);
+
+static constexpr bool registryInOrder(){
+	for(size_t i = 0; i < std::size(ALL_STATEMENTS); i++){
+		if(ALL_STATEMENTS[i].id != static_cast<StatementID>(i)){return false;}
+	}
+	return std::size(ALL_STATEMENTS) == STATEMENT_COUNT;
+}
+static_assert(registryInOrder(), "ALL_STATEMENTS must list every StatementID once, in order");
+
+using StatementSet = std::array<sqlite3_stmt *, STATEMENT_COUNT>;
+
+static std::mutex connectionsMutex;
+static std::unordered_map<sqlite3 *, StatementSet> connections; //Nodes do not move when the map grows, so a thread can keep a pointer to its connection's set
+static std::atomic<unsigned> connectionsClosed(0); //Bumped by finalizeStatements so no thread keeps using the set of a closed connection
+static thread_local sqlite3 *lastDB = NULL;
+static thread_local StatementSet *lastStatements = NULL;
+static thread_local unsigned lastClosed = 0;
+
+static void finalizeAll(StatementSet &statements){
+	for(sqlite3_stmt *&res : statements){
+		sqlite3_finalize(res); //NULL is a no-op
+		res = NULL;
+	}
+}
+
+OpResult prepareStatements(sqlite3 *db){
+	OpResult result;
+	StatementSet statements = {};
+	for(const StatementText &statement : ALL_STATEMENTS){
+		sqlite3_stmt *&res = statements[static_cast<size_t>(statement.id)];
+		int rc = sqlite3_prepare_v3(db, statement.sql, -1, SQLITE_PREPARE_PERSISTENT, &res, NULL);
+		if(rc != SQLITE_OK){
+			fail(result, db, NULL, std::string("Error preparing statement ") + statement.sql);
+			finalizeAll(statements);
+			return result;
+		}
+		//The declared signature has to match the SQL it was written for
+		if(sqlite3_bind_parameter_count(res) != statement.params || sqlite3_column_count(res) != statement.columns){
+			fail(result, std::string("Statement does not match its declared parameters and columns: ") + statement.sql);
+			finalizeAll(statements);
+			return result;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	StatementSet &stored = connections[db];
+	finalizeAll(stored); //Prepared twice
+	stored = statements;
+	return result;
+}
+
+void finalizeStatements(sqlite3 *db){
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	auto found = connections.find(db);
+	if(found != connections.end()){
+		finalizeAll(found->second);
+		connections.erase(found);
+	}
+	connectionsClosed++;
+}
+
+sqlite3_stmt *preparedStatement(sqlite3 *db, StatementID id){
+	if(db != lastDB || lastClosed != connectionsClosed.load()){
+		std::unique_lock<std::mutex> lock(connectionsMutex);
+		auto found = connections.find(db);
+		if(found == connections.end()){
+			lock.unlock();
+			if(!prepareStatements(db).ok()){return NULL;}
+			lock.lock();
+			found = connections.find(db);
+		}
+		lastDB = db;
+		lastStatements = &found->second;
+		lastClosed = connectionsClosed.load();
+	}
+	return (*lastStatements)[static_cast<size_t>(id)];
+}
@@ -0,0 +1,246 @@
+/* Program name: statements.h
+* Purpose: The libpokemart statement registry. Each statement the library runs for pickers, edits, sales and invoice and certification reports is declared
+*  here once, with the types of its parameters and result columns. Statements are prepared once per connection (prepareStatements in pokemart.h) and
+*  reused, parameters are bound by position, and binding the wrong number or the wrong types of values fails to compile.
+*/
+
+#ifndef STATEMENTS_H
+#define STATEMENTS_H
+
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <sqlite3.h>
+#include "rowmap.h"
+
+//Signatures: the types bound to ?1, ?2, ... and the types of the result columns, in order. Text is std::string_view either way
+template<typename... Types> struct ParamTypes{};
+template<typename... Types> struct ColumnTypes{};
+
+//One id per registry entry, in the order of ALL_STATEMENTS in statements.cpp
+enum class StatementID{
+	LIST_TRAINERS, LIST_EMPLOYEES, LIST_POKEMARTS, LIST_INVOICES, LIST_PRODUCTS,
+	INSERT_TRAINER, INSERT_EMPLOYEE, UPDATE_TRAINER_BALANCE, INSERT_ADJUSTMENT_LEDGER, UPDATE_TRAINER_BADGES, UPDATE_TRAINER_PHONE, UPDATE_EMPLOYEE_PHONE, DELETE_TRAINER, DELETE_EMPLOYEE,
+	RETIRE_TRAINER, RETIRE_EMPLOYEE,
+	INSERT_INVOICE, LATEST_MART_BALANCE, SALE_PRODUCT, INSERT_LINE, INSERT_STOCK_HISTORY, CHARGE_TRAINER, INSERT_SALE_LEDGER, INSERT_MART_BALANCE, STORE_INVOICE_TOTALS,
+	INSERT_STOCK_TRANSFER, INSERT_TRANSFER_STOCK,
+	AS_OF_STOCK, AS_OF_BALANCE, CHECKPOINT_PRODUCTS, CHECKPOINT_STOCK, CHECKPOINT_BALANCE,
+	INVOICE_HEADER, INVOICE_LINES, INVOICE_SUMMARY, INVOICE_BATCH_HEADERS, INVOICE_BATCH_LINES, EMPLOYEE_CERTIFICATIONS,
+	COUNT
+};
+
+//What prepareStatements needs to know about an entry: its SQL and how many parameters and columns its signature declares
+struct StatementText{
+	StatementID id;
+	const char *sql;
+	int params, columns;
+};
+
+template<typename Params, typename Columns> struct StatementDef;
+
+template<typename... Params, typename... Columns>
+struct StatementDef<ParamTypes<Params...>, ColumnTypes<Columns...>> : StatementText{
+	constexpr StatementDef(StatementID id, const char *sql) : StatementText{id, sql, sizeof...(Params), sizeof...(Columns)} {}
+};
+
+//Pickers
+using PickerStatement = StatementDef<ParamTypes<>, ColumnTypes<int, std::string_view>>;
+inline constexpr PickerStatement LIST_TRAINERS(StatementID::LIST_TRAINERS,
+	"SELECT trainer_id, trainer_fname || ' ' || trainer_lname FROM trainer_card WHERE retired_date IS NULL ORDER BY trainer_id");
+inline constexpr PickerStatement LIST_EMPLOYEES(StatementID::LIST_EMPLOYEES,
+	"SELECT emp_id, emp_fname || ' ' || emp_lname FROM employee WHERE retired_date IS NULL ORDER BY emp_id");
+inline constexpr PickerStatement LIST_POKEMARTS(StatementID::LIST_POKEMARTS,
+	"SELECT mart_id, street_address || ' - ' || city || ' , ' || region FROM pokemart");
+inline constexpr PickerStatement LIST_INVOICES(StatementID::LIST_INVOICES,
+	"SELECT invoice_num, 'Invoice ' || invoice_num FROM invoice");
+//?1 is the mart_id and ?2 the trainer_id. Products are read from the product_req_badges range up to the trainer's badge level, or up to ?3 without a trainer
+inline constexpr StatementDef<ParamTypes<int, int, int>, ColumnTypes<std::string_view, std::string_view, double, int>> LIST_PRODUCTS(StatementID::LIST_PRODUCTS,
+	"SELECT p.prod_code, p.prod_name, p.unit_price, s.stock_qty FROM product p JOIN stock_history s ON s.prod_code = p.prod_code "
+	"WHERE p.req_badges <= COALESCE((SELECT badge_level FROM trainer_card WHERE trainer_id = ?2), ?3) "
+	"AND s.stock_id = (SELECT MAX(stock_id) FROM stock_history WHERE mart_id = ?1 AND prod_code = p.prod_code) ORDER BY p.unit_price");
+
+//Insert, update and delete
+inline constexpr StatementDef<ParamTypes<std::string_view, std::string_view, int, std::string_view>, ColumnTypes<>> INSERT_TRAINER(StatementID::INSERT_TRAINER,
+	"INSERT INTO trainer_card (trainer_fname, trainer_lname, badge_level, trainer_phone) VALUES (?1, ?2, ?3, ?4)");
+inline constexpr StatementDef<ParamTypes<std::string_view, std::string_view, std::string_view>, ColumnTypes<>> INSERT_EMPLOYEE(StatementID::INSERT_EMPLOYEE,
+	"INSERT INTO employee (emp_fname, emp_lname, emp_phone, hire_date) VALUES (?1, ?2, ?3, CURRENT_TIMESTAMP)"); //Migrated databases have no default
+inline constexpr StatementDef<ParamTypes<double, int>, ColumnTypes<>> UPDATE_TRAINER_BALANCE(StatementID::UPDATE_TRAINER_BALANCE,
+	"UPDATE trainer_card SET balance = ?1 WHERE trainer_id = ?2");
+//Run before UPDATE_TRAINER_BALANCE, while the old balance is still there. ?1 is the trainer_id, ?2 the new balance and ?3 and ?4 the entry's date and epoch
+inline constexpr StatementDef<ParamTypes<int, double, std::string_view, sqlite3_int64>, ColumnTypes<>> INSERT_ADJUSTMENT_LEDGER(StatementID::INSERT_ADJUSTMENT_LEDGER,
+	"INSERT INTO trainer_ledger (trainer_id, entry_kind, amount, balance, entry_date, entry_epoch) "
+	"SELECT trainer_id, 'adjustment', ?2 - COALESCE(balance, 0), ?2, ?3, ?4 FROM trainer_card WHERE trainer_id = ?1");
+inline constexpr StatementDef<ParamTypes<int, int>, ColumnTypes<>> UPDATE_TRAINER_BADGES(StatementID::UPDATE_TRAINER_BADGES,
+	"UPDATE trainer_card SET badge_level = ?1 WHERE trainer_id = ?2");
+inline constexpr StatementDef<ParamTypes<std::string_view, int>, ColumnTypes<>> UPDATE_TRAINER_PHONE(StatementID::UPDATE_TRAINER_PHONE,
+	"UPDATE trainer_card SET trainer_phone = ?1 WHERE trainer_id = ?2");
+inline constexpr StatementDef<ParamTypes<std::string_view, int>, ColumnTypes<>> UPDATE_EMPLOYEE_PHONE(StatementID::UPDATE_EMPLOYEE_PHONE,
+	"UPDATE employee SET emp_phone = ?1 WHERE emp_id = ?2");
+using DeleteStatement = StatementDef<ParamTypes<int>, ColumnTypes<>>;
+inline constexpr DeleteStatement DELETE_TRAINER(StatementID::DELETE_TRAINER, "DELETE FROM trainer_card WHERE trainer_id = ?1");
+inline constexpr DeleteStatement DELETE_EMPLOYEE(StatementID::DELETE_EMPLOYEE, "DELETE FROM employee WHERE emp_id = ?1");
+//Soft deletes for rows the foreign keys keep from being deleted. ?1 is the retired_date
+using RetireStatement = StatementDef<ParamTypes<std::string_view, int>, ColumnTypes<>>;
+inline constexpr RetireStatement RETIRE_TRAINER(StatementID::RETIRE_TRAINER, "UPDATE trainer_card SET retired_date = ?1 WHERE trainer_id = ?2");
+inline constexpr RetireStatement RETIRE_EMPLOYEE(StatementID::RETIRE_EMPLOYEE, "UPDATE employee SET retired_date = ?1 WHERE emp_id = ?2");
+
+//Sales
+inline constexpr StatementDef<ParamTypes<int, int, int>, ColumnTypes<>> INSERT_INVOICE(StatementID::INSERT_INVOICE,
+	"INSERT INTO invoice (trainer_id, emp_id, mart_id) VALUES (?1, ?2, ?3)");
+inline constexpr StatementDef<ParamTypes<int>, ColumnTypes<double>> LATEST_MART_BALANCE(StatementID::LATEST_MART_BALANCE,
+	"SELECT balance FROM mart_balance_history WHERE mart_id = ?1 ORDER BY balance_id DESC LIMIT 1");
+//?1 is the prod_code and ?2 the mart_id. The reorder point is the PokeMart's forecast one, or product.min_qty if it has none
+inline constexpr StatementDef<ParamTypes<std::string_view, int>, ColumnTypes<std::string_view, double, int, int, double>> SALE_PRODUCT(StatementID::SALE_PRODUCT,
+	"SELECT p.prod_name, p.unit_price, s.stock_qty, COALESCE(r.min_qty, p.min_qty), p.vendor_price FROM product p JOIN stock_history s ON s.prod_code = p.prod_code "
+	"LEFT JOIN reorder_point r ON r.mart_id = ?2 AND r.prod_code = p.prod_code "
+	"WHERE p.prod_code = ?1 AND s.stock_id = (SELECT MAX(stock_id) FROM stock_history WHERE mart_id = ?2 AND prod_code = ?1)");
+inline constexpr StatementDef<ParamTypes<int, int, std::string_view, int, double, double>, ColumnTypes<>> INSERT_LINE(StatementID::INSERT_LINE,
+	"INSERT INTO line (invoice_num, line_num, prod_code, qty, unit_price, line_total) VALUES (?1, ?2, ?3, ?4, ?5, ?6)");
+inline constexpr StatementDef<ParamTypes<std::string_view, int, int, std::string_view, sqlite3_int64>, ColumnTypes<>> INSERT_STOCK_HISTORY(StatementID::INSERT_STOCK_HISTORY,
+	"INSERT INTO stock_history (prod_code, mart_id, stock_qty, stock_date, stock_epoch) VALUES (?1, ?2, ?3, ?4, ?5)");
+inline constexpr StatementDef<ParamTypes<double, int>, ColumnTypes<>> CHARGE_TRAINER(StatementID::CHARGE_TRAINER,
+	"UPDATE trainer_card SET balance = balance + ?1 WHERE trainer_id = ?2");
+//Run after CHARGE_TRAINER so the entry holds the balance the charge left. ?1 is the trainer_id, ?2 the amount charged and ?3 the invoice_num
+inline constexpr StatementDef<ParamTypes<int, double, int, std::string_view, sqlite3_int64>, ColumnTypes<>> INSERT_SALE_LEDGER(StatementID::INSERT_SALE_LEDGER,
+	"INSERT INTO trainer_ledger (trainer_id, entry_kind, invoice_num, amount, balance, entry_date, entry_epoch) "
+	"SELECT trainer_id, 'sale', ?3, ?2, COALESCE(balance, 0), ?4, ?5 FROM trainer_card WHERE trainer_id = ?1");
+inline constexpr StatementDef<ParamTypes<double, int, std::string_view, sqlite3_int64>, ColumnTypes<>> INSERT_MART_BALANCE(StatementID::INSERT_MART_BALANCE,
+	"INSERT INTO mart_balance_history (balance, mart_id, balance_date, balance_epoch) VALUES (?1, ?2, ?3, ?4)");
+//?1 is the subtotal and ?2 the invoice_num
+inline constexpr StatementDef<ParamTypes<double, int>, ColumnTypes<double, double>> STORE_INVOICE_TOTALS(StatementID::STORE_INVOICE_TOTALS,
+	"UPDATE invoice SET subtotal = ?1, tax = ?1 * tax_rate, total = ?1 + ?1 * tax_rate WHERE invoice_num = ?2 RETURNING tax, total");
+
+//Stock transfers (rebalance.h). ?1 is the prod_code, ?2 the sending and ?3 the receiving mart_id, ?4 the quantity
+inline constexpr StatementDef<ParamTypes<std::string_view, int, int, int, std::string_view, sqlite3_int64>, ColumnTypes<>> INSERT_STOCK_TRANSFER(StatementID::INSERT_STOCK_TRANSFER,
+	"INSERT INTO stock_transfer (prod_code, from_mart, to_mart, qty, transfer_date, transfer_epoch) VALUES (?1, ?2, ?3, ?4, ?5, ?6)");
+//One side of a transfer: INSERT_STOCK_HISTORY with the transfer_id in ?6
+inline constexpr StatementDef<ParamTypes<std::string_view, int, int, std::string_view, sqlite3_int64, sqlite3_int64>, ColumnTypes<>> INSERT_TRANSFER_STOCK(StatementID::INSERT_TRANSFER_STOCK,
+	"INSERT INTO stock_history (prod_code, mart_id, stock_qty, stock_date, stock_epoch, transfer_id) VALUES (?1, ?2, ?3, ?4, ?5, ?6)");
+
+//History as of a time (asof.h). ?1 is the mart_id and the last parameter the time as Unix time. The row in effect is the later of the last history row and
+//the last checkpoint row dated at or before it, each found with one seek back from that time
+inline constexpr StatementDef<ParamTypes<int, std::string_view, sqlite3_int64>, ColumnTypes<int, std::string_view>> AS_OF_STOCK(StatementID::AS_OF_STOCK,
+	"SELECT stock_qty, stock_date FROM ("
+	"SELECT * FROM (SELECT stock_id, stock_date, stock_epoch, stock_qty FROM stock_history WHERE mart_id = ?1 AND prod_code = ?2 AND stock_epoch <= ?3 "
+	"ORDER BY stock_epoch DESC, stock_id DESC LIMIT 1) UNION ALL "
+	"SELECT * FROM (SELECT stock_id, stock_date, stock_epoch, stock_qty FROM stock_checkpoint WHERE mart_id = ?1 AND prod_code = ?2 AND checkpoint_epoch <= ?3 "
+	"ORDER BY checkpoint_epoch DESC LIMIT 1)) ORDER BY stock_epoch DESC, stock_id DESC LIMIT 1");
+inline constexpr StatementDef<ParamTypes<int, sqlite3_int64>, ColumnTypes<double, std::string_view>> AS_OF_BALANCE(StatementID::AS_OF_BALANCE,
+	"SELECT balance, balance_date FROM ("
+	"SELECT * FROM (SELECT balance_id, balance_date, balance_epoch, balance FROM mart_balance_history WHERE mart_id = ?1 AND balance_epoch <= ?2 "
+	"ORDER BY balance_epoch DESC, balance_id DESC LIMIT 1) UNION ALL "
+	"SELECT * FROM (SELECT balance_id, balance_date, balance_epoch, balance FROM balance_checkpoint WHERE mart_id = ?1 AND checkpoint_epoch <= ?2 "
+	"ORDER BY checkpoint_epoch DESC LIMIT 1)) ORDER BY balance_epoch DESC, balance_id DESC LIMIT 1");
+//The products a PokeMart has stock history or an earlier checkpoint of, the only ones a checkpoint can copy anything for. One range of
+//stock_history_mart_prod and of stock_checkpoint's primary key
+inline constexpr StatementDef<ParamTypes<int>, ColumnTypes<std::string_view>> CHECKPOINT_PRODUCTS(StatementID::CHECKPOINT_PRODUCTS,
+	"SELECT prod_code FROM stock_history WHERE mart_id = ?1 UNION SELECT prod_code FROM stock_checkpoint WHERE mart_id = ?1");
+//Copies the row AS_OF_STOCK and AS_OF_BALANCE would return into a checkpoint at that time. Nothing is written for a key with no history by then
+inline constexpr StatementDef<ParamTypes<int, std::string_view, sqlite3_int64>, ColumnTypes<>> CHECKPOINT_STOCK(StatementID::CHECKPOINT_STOCK,
+	"INSERT OR REPLACE INTO stock_checkpoint (mart_id, prod_code, checkpoint_epoch, stock_id, stock_date, stock_epoch, stock_qty) "
+	"SELECT ?1, ?2, ?3, stock_id, stock_date, stock_epoch, stock_qty FROM ("
+	"SELECT * FROM (SELECT stock_id, stock_date, stock_epoch, stock_qty FROM stock_history WHERE mart_id = ?1 AND prod_code = ?2 AND stock_epoch <= ?3 "
+	"ORDER BY stock_epoch DESC, stock_id DESC LIMIT 1) UNION ALL "
+	"SELECT * FROM (SELECT stock_id, stock_date, stock_epoch, stock_qty FROM stock_checkpoint WHERE mart_id = ?1 AND prod_code = ?2 AND checkpoint_epoch <= ?3 "
+	"ORDER BY checkpoint_epoch DESC LIMIT 1)) ORDER BY stock_epoch DESC, stock_id DESC LIMIT 1");
+inline constexpr StatementDef<ParamTypes<int, sqlite3_int64>, ColumnTypes<>> CHECKPOINT_BALANCE(StatementID::CHECKPOINT_BALANCE,
+	"INSERT OR REPLACE INTO balance_checkpoint (mart_id, checkpoint_epoch, balance_id, balance_date, balance_epoch, balance) "
+	"SELECT ?1, ?2, balance_id, balance_date, balance_epoch, balance FROM ("
+	"SELECT * FROM (SELECT balance_id, balance_date, balance_epoch, balance FROM mart_balance_history WHERE mart_id = ?1 AND balance_epoch <= ?2 "
+	"ORDER BY balance_epoch DESC, balance_id DESC LIMIT 1) UNION ALL "
+	"SELECT * FROM (SELECT balance_id, balance_date, balance_epoch, balance FROM balance_checkpoint WHERE mart_id = ?1 AND checkpoint_epoch <= ?2 "
+	"ORDER BY checkpoint_epoch DESC LIMIT 1)) ORDER BY balance_epoch DESC, balance_id DESC LIMIT 1");
+
+//Reports. The names on an invoice are left joined, so an invoice whose trainer, clerk or PokeMart row is gone is still written with those names blank, and
+//a line whose product is gone shows its prod_code. The batch receipt statements below join the same way, so both write the same receipt
+inline constexpr StatementDef<ParamTypes<int>, ColumnTypes<std::string_view, std::string_view, int, std::string_view, std::string_view, double, double, double>>
+	INVOICE_HEADER(StatementID::INVOICE_HEADER,
+	"SELECT COALESCE(t.trainer_fname || ' ' || t.trainer_lname, ''), COALESCE(e.emp_fname || ' ' || e.emp_lname, ''), i.mart_id, "
+	"COALESCE(pkmt.street_address || ' - ' || pkmt.city || ', ' || pkmt.region, ''), i.invoice_date, i.subtotal, i.tax, i.total "
+	"FROM invoice i LEFT JOIN pokemart pkmt ON i.mart_id = pkmt.mart_id LEFT JOIN employee e ON i.emp_id = e.emp_id "
+	"LEFT JOIN trainer_card t ON i.trainer_id = t.trainer_id "
+	"WHERE i.invoice_num = ?1");
+inline constexpr StatementDef<ParamTypes<int>, ColumnTypes<std::string_view, std::string_view, int, double, double>> INVOICE_LINES(StatementID::INVOICE_LINES,
+	"SELECT COALESCE(p.prod_name, l.prod_code), COALESCE(p.prod_descript, ''), l.qty, l.unit_price, l.line_total FROM line l "
+	"LEFT JOIN product p ON l.prod_code = p.prod_code WHERE l.invoice_num = ?1 ORDER BY l.line_num");
+inline constexpr StatementDef<ParamTypes<int>, ColumnTypes<int, int, int, std::string_view, double, double, double, double>> INVOICE_SUMMARY(StatementID::INVOICE_SUMMARY,
+	"SELECT trainer_id, emp_id, mart_id, invoice_date, tax_rate, subtotal, tax, total FROM invoice WHERE invoice_num = ?1");
+//Batch receipts: ?1 and ?2 are the dates from and up to, ?3 the mart_id or 0. Both are one range of invoice_by_date, and the lines come out in the same
+//(invoice_date, invoice_num) order as the headers so the two can be merged without sorting. That needs both to select the same invoices, so like
+//INVOICE_HEADER and INVOICE_LINES they left join the names
+inline constexpr StatementDef<ParamTypes<std::string_view, std::string_view, int>,
+	ColumnTypes<int, std::string_view, std::string_view, int, std::string_view, std::string_view, double, double, double>> INVOICE_BATCH_HEADERS(StatementID::INVOICE_BATCH_HEADERS,
+	"SELECT i.invoice_num, COALESCE(t.trainer_fname || ' ' || t.trainer_lname, ''), COALESCE(e.emp_fname || ' ' || e.emp_lname, ''), i.mart_id, "
+	"COALESCE(pkmt.street_address || ' - ' || pkmt.city || ', ' || pkmt.region, ''), i.invoice_date, i.subtotal, i.tax, i.total "
+	"FROM invoice i LEFT JOIN pokemart pkmt ON i.mart_id = pkmt.mart_id LEFT JOIN employee e ON i.emp_id = e.emp_id "
+	"LEFT JOIN trainer_card t ON i.trainer_id = t.trainer_id "
+	"WHERE i.invoice_date >= ?1 AND i.invoice_date < ?2 AND (?3 = 0 OR i.mart_id = ?3) ORDER BY i.invoice_date, i.invoice_num");
+inline constexpr StatementDef<ParamTypes<std::string_view, std::string_view, int>, ColumnTypes<int, std::string_view, std::string_view, int, double, double>>
+	INVOICE_BATCH_LINES(StatementID::INVOICE_BATCH_LINES,
+	"SELECT i.invoice_num, COALESCE(p.prod_name, l.prod_code), COALESCE(p.prod_descript, ''), l.qty, l.unit_price, l.line_total "
+	"FROM invoice i JOIN line l ON l.invoice_num = i.invoice_num LEFT JOIN product p ON l.prod_code = p.prod_code "
+	"WHERE i.invoice_date >= ?1 AND i.invoice_date < ?2 AND (?3 = 0 OR i.mart_id = ?3) ORDER BY i.invoice_date, i.invoice_num, l.line_num");
+inline constexpr StatementDef<ParamTypes<int>, ColumnTypes<std::string_view, std::string_view, double, std::string_view, std::string_view>> EMPLOYEE_CERTIFICATIONS(StatementID::EMPLOYEE_CERTIFICATIONS,
+	"SELECT e.emp_fname || ' ' || e.emp_lname, c.cert_descript, c.cert_payrate, cr.cert_date, c.cert_title "
+	"FROM employee e JOIN certification_record cr ON e.emp_id = cr.emp_id JOIN certification c ON cr.cert_id = c.cert_id WHERE e.emp_id = ?1");
+
+//The prepared statement for an entry on this connection, preparing every entry first if the connection has none yet. NULL if preparing failed
+sqlite3_stmt *preparedStatement(sqlite3 *, StatementID);
+
+//A value can be bound to a parameter declared as the same type. Text parameters also take anything that converts to std::string_view
+template<typename Declared, typename Value>
+struct Bindable : std::is_same<Declared, Value> {};
+
+template<typename Value>
+struct Bindable<std::string_view, Value> : std::is_convertible<const Value &, std::string_view> {};
+
+inline int bindValue(sqlite3_stmt *res, int index, int value){return sqlite3_bind_int(res, index, value);}
+inline int bindValue(sqlite3_stmt *res, int index, sqlite3_int64 value){return sqlite3_bind_int64(res, index, value);}
+inline int bindValue(sqlite3_stmt *res, int index, double value){return sqlite3_bind_double(res, index, value);}
+inline int bindValue(sqlite3_stmt *res, int index, std::string_view value){return sqlite3_bind_text(res, index, value.data(), value.size(), SQLITE_STATIC);}
+
+//One use of a registry statement. The statement is reset when the Query goes out of scope, ready for its next use; it is never finalized. Text bound with
+//bind is not copied, so it has to stay valid until the last step
+template<typename Params, typename Columns> class Query;
+
+template<typename... Params, typename... Columns>
+class Query<ParamTypes<Params...>, ColumnTypes<Columns...>>{
+public:
+	Query(sqlite3 *db, const StatementDef<ParamTypes<Params...>, ColumnTypes<Columns...>> &statement) : res(preparedStatement(db, statement.id)) {}
+	~Query(){if(res != NULL){sqlite3_reset(res);}}
+	Query(const Query &) = delete;
+	Query &operator=(const Query &) = delete;
+
+	bool prepared() const {return res != NULL;}
+
+	//Binds one value per parameter, in order. Returns SQLITE_OK or the first bind error
+	template<typename... Values>
+	int bind(const Values &... values){
+		static_assert(sizeof...(Values) == sizeof...(Params), "Wrong number of values bound to a registry statement");
+		static_assert((Bindable<Params, Values>::value && ...), "Value bound to a registry statement does not match its parameter type");
+		return bindAll(std::index_sequence_for<Params...>(), Params(values)...);
+	}
+
+	int step(){return sqlite3_step(res);}
+	std::tuple<Columns...> row() const {return readRow<Columns...>(res);}
+
+	//Calls rowFunction with the decoded columns of every remaining row. Returns SQLITE_DONE or the error sqlite3_step stopped with
+	template<typename RowFunction>
+	int forEach(RowFunction rowFunction){return forEachRow<Columns...>(res, rowFunction);}
+
+private:
+	sqlite3_stmt *res;
+
+	template<std::size_t... Index>
+	int bindAll(std::index_sequence<Index...>, const Params &... values){
+		int rc = SQLITE_OK;
+		((rc = rc == SQLITE_OK ? bindValue(res, Index + 1, values) : rc), ...);
+		return rc;
+	}
+};
+
+template<typename Params, typename Columns>
+Query(sqlite3 *, const StatementDef<Params, Columns> &) -> Query<Params, Columns>;
+
+#endif
@@ -0,0 +1,162 @@
+/* Program name: stockcounters.cpp
+* Purpose: Implements the in-memory stock counters declared in stockcounters.h. The counters guard no other memory, so relaxed atomics are enough; the
+*  compare-and-swap alone makes a reservation all or nothing. A counter and its reserved quantity are updated one after the other, so a resync racing a
+*  reservation can be off by it; recordSale still refuses anything the database does not have, and the next disagreement resyncs the counter again.
+*/
+
+#include "stockcounters.h"
+#include "pokemart_internal.h"
+#include "rowmap.h"
+#include "statements.h"
+
+OpResult StockCounters::load(sqlite3 *db){
+	OpResult result;
+	sqlite3_stmt *res;
+
+	//Products are numbered in prod_code order to give each its column
+	productColumns.clear();
+	int rc = sqlite3_prepare_v2(db, "SELECT prod_code FROM product ORDER BY prod_code", -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting products for stock counters");
+		return result;
+	}
+	rc = forEachRow<std::string_view>(res, [&](std::string_view prodCode){
+		productColumns.emplace(std::string(prodCode), static_cast<int>(productColumns.size()));
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading products for stock counters");
+		return result;
+	}
+	sqlite3_finalize(res);
+	products = productColumns.size();
+
+	//The latest row of each (mart_id, prod_code), found by its highest stock_id like everywhere else
+	std::string query = "SELECT s.mart_id, s.prod_code, s.stock_qty FROM stock_history s ";
+	query += "WHERE s.stock_id IN (SELECT MAX(stock_id) FROM stock_history GROUP BY mart_id, prod_code) ORDER BY s.mart_id";
+	rc = sqlite3_prepare_v2(db, query.c_str(), -1, &res, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, db, res, "Error selecting stock for stock counters");
+		return result;
+	}
+	std::vector<int> martIDs, columns, quantities;
+	rc = forEachRow<int, std::string_view, int>(res, [&](int martID, std::string_view prodCode, int qty){
+		auto column = productColumns.find(std::string(prodCode));
+		if(martID < 0 || column == productColumns.end()){return;} //History for a product that no longer exists
+		martIDs.push_back(martID);
+		columns.push_back(column->second);
+		quantities.push_back(qty);
+	});
+	if(rc != SQLITE_DONE){
+		fail(result, db, res, "Error reading stock for stock counters");
+		return result;
+	}
+	sqlite3_finalize(res);
+
+	//Only PokeMarts with stock get a row, so the array stays dense when mart ids have gaps
+	martRows.clear();
+	int marts = 0;
+	for(int martID : martIDs){
+		if(martID >= static_cast<int>(martRows.size())){martRows.resize(martID + 1, -1);}
+		if(martRows[martID] < 0){martRows[martID] = marts++;}
+	}
+	counts = std::make_unique<std::atomic<int>[]>(static_cast<size_t>(marts) * products);
+	reserved = std::make_unique<std::atomic<int>[]>(static_cast<size_t>(marts) * products);
+	for(size_t i = 0; i < static_cast<size_t>(marts) * products; i++){
+		counts[i].store(-1, std::memory_order_relaxed);
+		reserved[i].store(0, std::memory_order_relaxed);
+	}
+	for(size_t i = 0; i < martIDs.size(); i++){
+		counts[martRows[martIDs[i]] * products + columns[i]].store(quantities[i], std::memory_order_relaxed);
+	}
+	return result;
+}
+
+int StockCounters::slot(int martID, const std::string &prodCode) const{
+	if(martID < 0 || martID >= static_cast<int>(martRows.size()) || martRows[martID] < 0){return -1;}
+	auto column = productColumns.find(prodCode);
+	if(column == productColumns.end()){return -1;}
+	int index = martRows[martID] * products + column->second;
+	return counts[index].load(std::memory_order_relaxed) < 0 ? -1 : index;
+}
+
+bool StockCounters::reserve(int slot, int qty){
+	std::atomic<int> &count = counts[slot];
+	int current = count.load(std::memory_order_relaxed);
+	do{
+		if(current < qty){return false;}
+	}while(!count.compare_exchange_weak(current, current - qty, std::memory_order_relaxed));
+	reserved[slot].fetch_add(qty, std::memory_order_relaxed);
+	return true;
+}
+
+void StockCounters::release(int slot, int qty){
+	reserved[slot].fetch_sub(qty, std::memory_order_relaxed);
+	counts[slot].fetch_add(qty, std::memory_order_relaxed);
+}
+
+void StockCounters::commit(int slot, int qty, int delivered){
+	reserved[slot].fetch_sub(qty, std::memory_order_relaxed);
+	if(delivered > 0){counts[slot].fetch_add(delivered, std::memory_order_relaxed);}
+}
+
+void StockCounters::resync(int slot, int committed){
+	int expected = committed - reserved[slot].load(std::memory_order_relaxed);
+	if(expected < 0){expected = 0;}
+	if(counts[slot].exchange(expected, std::memory_order_relaxed) != expected){resynced.fetch_add(1, std::memory_order_relaxed);}
+}
+
+int StockCounters::available(int slot) const{
+	return counts[slot].load(std::memory_order_relaxed);
+}
+
+//Gives back every reservation made for a sale that will not be recorded
+static void releaseAll(StockCounters &counters, const SaleRequest &request, const std::vector<int> &slots){
+	for(size_t i = 0; i < slots.size(); i++){
+		if(slots[i] >= 0){counters.release(slots[i], request.basket[i].qty);}
+	}
+}
+
+//Resets a counter from the latest stock committed to stock_history. Left as it is if the stock cannot be read
+static void resyncFromDatabase(sqlite3 *db, StockCounters &counters, int slot, int martID, const std::string &prodCode){
+	Query query(db, SALE_PRODUCT);
+	if(!query.prepared() || query.bind(prodCode, martID) != SQLITE_OK || query.step() != SQLITE_ROW){return;}
+	counters.resync(slot, std::get<2>(query.row()));
+}
+
+SaleResult recordSale(sqlite3 *db, const SaleRequest &request, StockCounters &counters){
+	SaleResult result;
+
+	//Reserve every line first. Lines the counters do not know about (or with a bad quantity) are left to the checks in recordSale. The slots only live
+	//until the sale commits or rolls back, so each register thread reuses one buffer and a steady run of sales does not allocate for them
+	static thread_local std::vector<int> slots;
+	slots.assign(request.basket.size(), -1);
+	for(size_t i = 0; i < request.basket.size(); i++){
+		const SaleLine &line = request.basket[i];
+		int slot = counters.slot(request.martID, line.prodCode);
+		if(slot < 0 || line.qty < 1){continue;}
+		if(!counters.reserve(slot, line.qty)){
+			resyncFromDatabase(db, counters, slot, request.martID, line.prodCode); //Stock may have arrived outside the counters
+		}
+		if(!counters.reserve(slot, line.qty)){
+			releaseAll(counters, request, slots);
+			fail(result, "Cannot order more " + line.prodCode + " than there are in stock (" + std::to_string(counters.available(slot)) + " available)");
+			return result;
+		}
+		slots[i] = slot;
+	}
+
+	//The stock_history rows are written by recordSale as usual. Once it commits the reservations are the new stock, plus anything reordered
+	result = recordSale(db, request);
+	if(!result.ok()){
+		//The sale may have failed because stock was taken outside the counters, so the lines it reserved are checked against the database again
+		releaseAll(counters, request, slots);
+		for(size_t i = 0; i < slots.size(); i++){
+			if(slots[i] >= 0){resyncFromDatabase(db, counters, slots[i], request.martID, request.basket[i].prodCode);}
+		}
+		return result;
+	}
+	for(size_t i = 0; i < result.lines.size(); i++){
+		if(slots[i] >= 0){counters.commit(slots[i], request.basket[i].qty, result.lines[i].reorderQty);}
+	}
+	return result;
+}
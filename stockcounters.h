@@ -0,0 +1,60 @@
+/* Program name: stockcounters.h
+* Purpose: Declares in-memory stock counters for running several registers in one process. The latest stock of every product at every PokeMart is loaded
+*  into a dense array of atomics, and a sale reserves its quantities there with compare-and-swap before it touches the database. Two registers selling the
+*  last of a product can then never both succeed, and neither waits on the database write lock just to find out whether there is enough stock.
+*  The reservation is written to stock_history by recordSale on commit and given back if the sale rolls back. The clerk server (clerkserver.h) shares
+*  one set between all of its registers.
+*/
+
+#ifndef STOCKCOUNTERS_H
+#define STOCKCOUNTERS_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sqlite3.h>
+#include "pokemart.h"
+
+//Stock written outside the counters (a transfer, a sale from another process, a manual update) is not seen as it happens. recordSale stays the
+//check that matters, so this can only make the counters refuse a sale the database would take, or let one through that recordSale then refuses. Either
+//way the sale below brings the product's counter back in line with stock_history before giving up
+class StockCounters{
+public:
+	//Reads the latest stock of every product at every PokeMart. Not safe to call while sales are running
+	OpResult load(sqlite3 *);
+
+	//The counter of a product at a PokeMart, or -1 if that PokeMart has no stock history for it. Safe to call from any thread after load
+	int slot(int martID, const std::string &prodCode) const;
+
+	//Takes qty out of the counter if at least that much is available, and returns whether it did. Never lets the counter go below 0
+	bool reserve(int slot, int qty);
+
+	//Gives back a reservation of a sale that was not recorded
+	void release(int slot, int qty);
+
+	//Settles a reservation of a sale that was recorded, adding the stock a vendor reorder delivered
+	void commit(int slot, int qty, int delivered);
+
+	//Sets the counter to the stock committed in the database less what is reserved by sales still running
+	void resync(int slot, int committed);
+
+	int available(int slot) const;
+	int resyncs() const {return resynced.load(std::memory_order_relaxed);} //Counters that were found out of line with the database and reset
+
+private:
+	std::vector<int> martRows; //mart_id -> row of counts, -1 if the PokeMart has no stock
+	std::unordered_map<std::string, int> productColumns; //prod_code -> column of counts
+	int products = 0;
+	std::unique_ptr<std::atomic<int>[]> counts; //One per (mart row, product column); -1 where the PokeMart has never stocked the product
+	std::unique_ptr<std::atomic<int>[]> reserved; //Quantity held by sales not yet committed or rolled back, per counter
+	std::atomic<int> resynced{0};
+};
+
+//Records a sale like recordSale(sqlite3 *, const SaleRequest &), but first reserves every line in the counters. A line the counters are out of stock for
+//is checked against the latest committed stock first, a read that does not wait on sales in WAL mode, and the sale fails without writing only if the
+//database agrees. Each register thread needs its own database connection; the counters are shared
+SaleResult recordSale(sqlite3 *, const SaleRequest &, StockCounters &);
+
+#endif
@@ -11,7 +11,9 @@ CREATE TABLE mart_balance_history (
 balance_id INTEGER PRIMARY KEY AUTOINCREMENT,
 balance NUMERIC(9,3) NOT NULL,
 balance_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
-mart_id SMALLINT REFERENCES pokemart(mart_id) NOT NULL);
+mart_id SMALLINT REFERENCES pokemart(mart_id) NOT NULL,
+-- balance_date as Unix time, which range queries compare. NULL for rows whose balance_date is not a valid date
+balance_epoch INTEGER);
 
 CREATE TABLE trainer_card (
 trainer_id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -21,6 +23,8 @@ trainer_fname VARCHAR(20) NOT NULL,
 trainer_lname VARCHAR(20) NOT NULL,
 trainer_phone CHAR(8),
 registration_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+-- Set instead of deleting a trainer that still has invoices or ledger entries. Retired trainers are left out of the pickers
+retired_date TIMESTAMP,
 UNIQUE (trainer_fname, trainer_lname, trainer_phone));
 
 CREATE TABLE vendor (
@@ -46,6 +50,9 @@ emp_id INTEGER PRIMARY KEY AUTOINCREMENT,
 emp_fname VARCHAR(20) NOT NULL,
 emp_lname VARCHAR(20) NOT NULL,
 emp_phone CHAR(8),
+hire_date TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+-- Set instead of deleting an employee that still has invoices, shifts or certification records. Retired employees are left out of the pickers
+retired_date TIMESTAMP,
 UNIQUE (emp_fname, emp_lname, emp_phone));
 
 CREATE TABLE certification (
@@ -76,13 +83,18 @@ trainer_id INTEGER REFERENCES trainer_card(trainer_id) NOT NULL,
 emp_id INTEGER REFERENCES employee(emp_id) NOT NULL,
 mart_id INTEGER REFERENCES pokemart(mart_id) NOT NULL,
 tax_rate NUMERIC(5,3) NOT NULL DEFAULT 0.07,
-invoice_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP);
+invoice_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+subtotal NUMERIC(9,3) NOT NULL DEFAULT 0,
+tax NUMERIC(9,3) NOT NULL DEFAULT 0,
+total NUMERIC(9,3) NOT NULL DEFAULT 0);
 
 CREATE TABLE line (
 invoice_num INTEGER REFERENCES invoice(invoice_num) NOT NULL,
 line_num INTEGER NOT NULL,
 prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL,
 qty SMALLINT NOT NULL,
+unit_price NUMERIC(6,3) NOT NULL DEFAULT 0,
+line_total NUMERIC(9,3) NOT NULL DEFAULT 0,
 PRIMARY KEY (invoice_num, line_num));
 
 CREATE TABLE stock_history (
@@ -90,4 +102,143 @@ stock_id INTEGER PRIMARY KEY AUTOINCREMENT,
 prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL,
 stock_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
 mart_id SMALLINT REFERENCES pokemart(mart_id) NOT NULL,
-stock_qty SMALLINT NOT NULL);
+stock_qty SMALLINT NOT NULL,
+-- stock_date as Unix time, which range queries compare. NULL for rows whose stock_date is not a valid date
+stock_epoch INTEGER,
+-- Set on the two rows written by a transfer between PokeMarts, the one sending the stock and the one receiving it
+transfer_id INTEGER REFERENCES stock_transfer(transfer_id));
+
+-- Stock moved between PokeMarts by rebalancing (rebalance.h) instead of ordered from the vendor
+CREATE TABLE stock_transfer (
+transfer_id INTEGER PRIMARY KEY AUTOINCREMENT,
+prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL,
+from_mart INTEGER REFERENCES pokemart(mart_id) NOT NULL,
+to_mart INTEGER REFERENCES pokemart(mart_id) NOT NULL,
+qty SMALLINT NOT NULL,
+transfer_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+transfer_epoch INTEGER);
+
+-- Every change to a trainer_card balance, appended in the same transaction as the change (ledger.h). balance is the trainer's balance after the entry, so
+-- a trainer's amounts sum to trainer_card.balance. entry_kind is 'opening', 'sale' (invoice_num is set) or 'adjustment'
+CREATE TABLE trainer_ledger (
+ledger_id INTEGER PRIMARY KEY AUTOINCREMENT,
+trainer_id INTEGER REFERENCES trainer_card(trainer_id) NOT NULL,
+entry_kind VARCHAR(10) NOT NULL,
+invoice_num INTEGER REFERENCES invoice(invoice_num),
+amount NUMERIC(9,3) NOT NULL,
+balance NUMERIC(9,3) NOT NULL,
+entry_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+entry_epoch INTEGER);
+
+-- Checkpoints (asof.h): the stock of every product and the balance of every PokeMart as of checkpoint_epoch, copied from the history row in effect then.
+-- An as-of lookup takes the later of the newest history row and the newest checkpoint row at or before its time, so the answer survives compaction
+-- archiving the history row. history_checkpoint lists the checkpoints taken
+CREATE TABLE history_checkpoint (
+checkpoint_epoch INTEGER PRIMARY KEY,
+checkpoint_date TIMESTAMP NOT NULL,
+stock_rows INTEGER NOT NULL DEFAULT 0,
+balance_rows INTEGER NOT NULL DEFAULT 0,
+created TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP);
+
+CREATE TABLE stock_checkpoint (
+mart_id INTEGER REFERENCES pokemart(mart_id) NOT NULL,
+prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL,
+checkpoint_epoch INTEGER NOT NULL,
+stock_id INTEGER NOT NULL,
+stock_date TIMESTAMP NOT NULL,
+stock_epoch INTEGER NOT NULL,
+stock_qty SMALLINT NOT NULL,
+PRIMARY KEY (mart_id, prod_code, checkpoint_epoch));
+
+CREATE TABLE balance_checkpoint (
+mart_id INTEGER REFERENCES pokemart(mart_id) NOT NULL,
+checkpoint_epoch INTEGER NOT NULL,
+balance_id INTEGER NOT NULL,
+balance_date TIMESTAMP NOT NULL,
+balance_epoch INTEGER NOT NULL,
+balance NUMERIC(9,3) NOT NULL,
+PRIMARY KEY (mart_id, checkpoint_epoch));
+
+-- Effective-dated prices and promotions (pricing.h). Each applies from starts up to (not including) ends, or indefinitely when ends is NULL, at one PokeMart
+-- (mart_id), every PokeMart in a region, or every PokeMart (neither set). A PokeMart's own price beats its region's, which beats the chain's; the best
+-- promotion in effect is taken off whichever price applies. Products with no price in effect sell at product.unit_price. start_epoch and end_epoch are
+-- the same times as Unix time
+CREATE TABLE product_price (
+price_id INTEGER PRIMARY KEY AUTOINCREMENT,
+prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL,
+mart_id INTEGER REFERENCES pokemart(mart_id),
+region VARCHAR(50),
+unit_price NUMERIC(6,3) NOT NULL,
+starts TIMESTAMP NOT NULL,
+ends TIMESTAMP,
+start_epoch INTEGER NOT NULL,
+end_epoch INTEGER,
+CHECK (mart_id IS NULL OR region IS NULL));
+
+CREATE TABLE promotion (
+promo_id INTEGER PRIMARY KEY AUTOINCREMENT,
+prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL,
+mart_id INTEGER REFERENCES pokemart(mart_id),
+region VARCHAR(50),
+percent_off NUMERIC(5,3) NOT NULL,
+starts TIMESTAMP NOT NULL,
+ends TIMESTAMP,
+start_epoch INTEGER NOT NULL,
+end_epoch INTEGER,
+CHECK (mart_id IS NULL OR region IS NULL),
+CHECK (percent_off > 0 AND percent_off <= 100));
+
+-- Reorder points per PokeMart, written by demand forecasting (forecast.cpp). Sales use these instead of product.min_qty when one exists
+CREATE TABLE reorder_point (
+mart_id INTEGER REFERENCES pokemart(mart_id) NOT NULL,
+prod_code VARCHAR(20) REFERENCES product(prod_code) NOT NULL,
+min_qty SMALLINT NOT NULL,
+demand NUMERIC(9,3) NOT NULL DEFAULT 0,
+updated TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+PRIMARY KEY (mart_id, prod_code));
+
+-- The latest stock and balance are found by the highest id per mart (and product), which these indexes answer with a single seek
+CREATE INDEX stock_history_mart_prod ON stock_history(mart_id, prod_code);
+CREATE INDEX mart_balance_history_mart ON mart_balance_history(mart_id);
+
+-- The stock and balance in effect at a given time (asof.h) are the last row dated at or before it, one seek back in these indexes
+CREATE INDEX stock_history_mart_prod_epoch ON stock_history(mart_id, prod_code, stock_epoch);
+CREATE INDEX mart_balance_history_mart_epoch ON mart_balance_history(mart_id, balance_epoch);
+
+-- Payroll reads each employee's shifts in a pay period in emp_id order
+CREATE INDEX shift_emp_date ON shift(emp_id, shift_date);
+
+-- Statements read one trainer's ledger in date order
+CREATE INDEX trainer_ledger_trainer_epoch ON trainer_ledger(trainer_id, entry_epoch);
+
+-- The product picker lists what a trainer has the badges for as one range of this index
+CREATE INDEX product_req_badges ON product(req_badges);
+
+-- Batch receipts read a range of dates as one range of this index, in invoice_date then invoice_num order
+CREATE INDEX invoice_by_date ON invoice(invoice_date);
+
+-- Foreign keys are enforced (PRAGMA foreign_keys), so deleting a parent row looks up its children by each referencing column. These index the ones not
+-- already leading an index above or a primary key. The invoice indexes also answer when a trainer or employee last made a sale (purge.h). Sales never set
+-- stock_history.transfer_id, so its index only holds transfer rows and costs a sale nothing
+CREATE INDEX product_vendor ON product(vendor_id);
+CREATE INDEX certification_record_cert ON certification_record(cert_id);
+CREATE INDEX shift_cert ON shift(cert_id);
+CREATE INDEX invoice_trainer_date ON invoice(trainer_id, invoice_date);
+CREATE INDEX invoice_emp_date ON invoice(emp_id, invoice_date);
+CREATE INDEX invoice_mart ON invoice(mart_id);
+CREATE INDEX line_prod ON line(prod_code);
+CREATE INDEX stock_history_prod ON stock_history(prod_code);
+CREATE INDEX stock_history_transfer ON stock_history(transfer_id) WHERE transfer_id IS NOT NULL;
+CREATE INDEX stock_transfer_prod ON stock_transfer(prod_code);
+CREATE INDEX stock_transfer_from ON stock_transfer(from_mart);
+CREATE INDEX stock_transfer_to ON stock_transfer(to_mart);
+CREATE INDEX trainer_ledger_invoice ON trainer_ledger(invoice_num);
+CREATE INDEX reorder_point_prod ON reorder_point(prod_code);
+CREATE INDEX stock_checkpoint_prod ON stock_checkpoint(prod_code);
+CREATE INDEX product_price_prod ON product_price(prod_code);
+CREATE INDEX product_price_mart ON product_price(mart_id) WHERE mart_id IS NOT NULL;
+CREATE INDEX promotion_prod ON promotion(prod_code);
+CREATE INDEX promotion_mart ON promotion(mart_id) WHERE mart_id IS NOT NULL;
+
+-- Number of schema migrations (schema.cpp) this file already includes
+PRAGMA user_version = 13;
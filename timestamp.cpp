@@ -0,0 +1,58 @@
+/* Program name: timestamp.cpp
+* Purpose: Implements the cached clock declared in timestamp.h. Each thread keeps the last second it used; when the second changes it takes the shared one
+*  under a mutex, and only the first thread to see a new second formats it.
+*/
+
+#include "timestamp.h"
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+
+static std::mutex sharedMutex;
+static Timestamp sharedSecond; //Guarded by sharedMutex
+static thread_local Timestamp threadSecond;
+
+static void formatLocal(sqlite3_int64 epoch, char (&text)[TIMESTAMP_LENGTH + 1]){
+	std::time_t seconds = epoch;
+	std::tm local;
+	localtime_r(&seconds, &local);
+	std::strftime(text, sizeof(text), "%F %T", &local);
+}
+
+Timestamp currentTimestamp(){
+	sqlite3_int64 now = std::time(NULL);
+	if(now == threadSecond.epoch){return threadSecond;}
+
+	std::lock_guard<std::mutex> lock(sharedMutex);
+	if(now != sharedSecond.epoch){
+		formatLocal(now, sharedSecond.text);
+		sharedSecond.epoch = now;
+	}
+	threadSecond = sharedSecond;
+	return threadSecond;
+}
+
+Timestamp timestampAt(sqlite3_int64 epoch){
+	Timestamp stamp;
+	stamp.epoch = epoch;
+	formatLocal(epoch, stamp.text);
+	return stamp;
+}
+
+bool parseTimestamp(const std::string &text, sqlite3_int64 &epoch){
+	std::tm local = {};
+	int consumed = 0;
+	int fields = std::sscanf(text.c_str(), "%4d-%2d-%2d%n %2d:%2d:%2d%n", &local.tm_year, &local.tm_mon, &local.tm_mday, &consumed,
+		&local.tm_hour, &local.tm_min, &local.tm_sec, &consumed);
+	if((fields != 3 && fields != 6) || consumed != static_cast<int>(text.size())){return false;}
+	if(local.tm_mon < 1 || local.tm_mon > 12 || local.tm_mday < 1 || local.tm_mday > 31 || local.tm_hour > 23 || local.tm_min > 59 || local.tm_sec > 59){
+		return false; //mktime would quietly roll these over into the next month, day or minute
+	}
+	local.tm_year -= 1900;
+	local.tm_mon -= 1;
+	local.tm_isdst = -1; //Let mktime work out daylight saving time for the date
+	std::time_t seconds = std::mktime(&local);
+	if(seconds == -1){return false;}
+	epoch = seconds;
+	return true;
+}
@@ -0,0 +1,32 @@
+/* Program name: timestamp.h
+* Purpose: Declares the clock the library stamps history rows with. Rows store Unix time in an integer column, which range queries compare, next to the
+*  same second as local "YYYY-MM-DD HH:MM:SS" text for everything that reads the text columns. The formatted second is cached and shared by every thread, so
+*  localtime (which takes a process-wide lock) and strftime run at most once per second however many registers are selling.
+*/
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <string>
+#include <string_view>
+#include <sqlite3.h>
+
+const size_t TIMESTAMP_LENGTH = 19; //YYYY-MM-DD HH:MM:SS
+
+struct Timestamp{
+	sqlite3_int64 epoch = 0; //Unix time
+	char text[TIMESTAMP_LENGTH + 1] = {}; //The same second in local time
+
+	std::string_view view() const {return std::string_view(text, TIMESTAMP_LENGTH);}
+};
+
+//The current second
+Timestamp currentTimestamp();
+
+//A given second, formatted the same way
+Timestamp timestampAt(sqlite3_int64 epoch);
+
+//Converts local "YYYY-MM-DD" (midnight) or "YYYY-MM-DD HH:MM:SS" to Unix time. Returns false if the text is not in either format
+bool parseTimestamp(const std::string &, sqlite3_int64 &epoch);
+
+#endif
@@ -0,0 +1,144 @@
+/* Program name: wal_bench.cpp
+* Purpose: Benchmarks the WAL checkpointer (walcheckpoint.h). Builds a database in WAL mode from tables.sql and inserts.sql with enough stock and money that
+*  no sale reorders, then records bursts of sales with a pause between bursts, as registers do, and times every recordSale. This is run twice on a fresh
+*  database: once with SQLite checkpointing on whichever sale commits past 1000 pages, and once with the checkpointer thread. Prints the median, 99th
+*  percentile and slowest sale of each, and the checkpointer's metrics, and fails if the checkpointer let the log grow much past restartPages.
+*  Usage: wal_bench [bursts] [sales_per_burst] [pause_ms] (run from the source directory; wal_bench.db is rebuilt on every run)
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pokemart.h"
+#include "walcheckpoint.h"
+
+const int MARTS = 5;
+const int TRAINERS = 5;
+const char *const DB_PATH = "wal_bench.db";
+//How far past restartPages the log may grow: several benchmark sales' worth, the ones that commit before the RESTART gets the write lock
+const int LOG_SLACK_PAGES = 200;
+
+//Runs one sql file from the source directory
+static bool runFile(sqlite3 *db, const std::string &fileName){
+	std::ifstream file(fileName);
+	if(!file){
+		std::cerr << fileName << " not found; run the benchmark from the source directory\n";
+		return false;
+	}
+	std::stringstream sql;
+	sql << file.rdbuf();
+	if(sqlite3_exec(db, sql.str().c_str(), NULL, NULL, NULL) != SQLITE_OK){
+		std::cerr << "Error running " << fileName << ": " << sqlite3_errmsg(db) << '\n';
+		return false;
+	}
+	return true;
+}
+
+//Builds the database in WAL mode, giving every PokeMart plenty of every product and enough money that no sale reorders
+static bool buildDatabase(){
+	for(const char *suffix : {"", "-wal", "-shm"}){std::remove((std::string(DB_PATH) + suffix).c_str());}
+	sqlite3 *db;
+	if(sqlite3_open(DB_PATH, &db) != SQLITE_OK){
+		std::cerr << "Error opening " << DB_PATH << ": " << sqlite3_errmsg(db) << '\n';
+		sqlite3_close(db);
+		return false;
+	}
+	bool ok = sqlite3_exec(db, "PRAGMA journal_mode = WAL", NULL, NULL, NULL) == SQLITE_OK && runFile(db, "tables.sql") && runFile(db, "inserts.sql");
+	if(ok){
+		std::string sql = "INSERT INTO stock_history (prod_code, mart_id, stock_qty, stock_date) SELECT prod_code, mart_id, 1000000000, '2024-03-01 00:00:00' FROM product, pokemart;";
+		sql += "INSERT INTO mart_balance_history (balance, mart_id, balance_date) SELECT 1000000000, mart_id, '2024-03-01 00:00:00' FROM pokemart;";
+		ok = sqlite3_exec(db, sql.c_str(), NULL, NULL, NULL) == SQLITE_OK && sqlite3_wal_checkpoint_v2(db, NULL, SQLITE_CHECKPOINT_TRUNCATE, NULL, NULL) == SQLITE_OK;
+		if(!ok){std::cerr << "Error stocking benchmark database: " << sqlite3_errmsg(db) << '\n';}
+	}
+	sqlite3_close(db);
+	return ok;
+}
+
+//Records the sales and returns how long each took, in milliseconds. Empty if a sale failed
+static std::vector<double> runSales(sqlite3 *db, int bursts, int salesPerBurst, int pauseMs){
+	const SaleLine products[] = {{"PB", 1}, {"GB", 2}, {"UB", 1}, {"BP", 3}, {"SP", 1}};
+	std::vector<double> latencies;
+	latencies.reserve(bursts * salesPerBurst);
+	for(int burst = 0; burst < bursts; burst++){
+		for(int i = 0; i < salesPerBurst; i++){
+			SaleRequest request{i % TRAINERS + 1, 1, i % MARTS + 1, {products[i % 5], products[(i + 1) % 5], products[(i + 2) % 5]}};
+			auto start = std::chrono::steady_clock::now();
+			SaleResult result = recordSale(db, request);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			if(!result.ok()){
+				std::cerr << result.error << '\n';
+				return std::vector<double>();
+			}
+			latencies.push_back(elapsed.count());
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(pauseMs));
+	}
+	return latencies;
+}
+
+static void printLatencies(const char *label, std::vector<double> latencies){
+	std::sort(latencies.begin(), latencies.end());
+	auto at = [&](double fraction){return latencies[std::min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()))];};
+	std::cout << label << ": " << latencies.size() << " sales, median " << at(0.5) << " ms, 99th percentile " << at(0.99) << " ms, 99.9th percentile "
+		<< at(0.999) << " ms, slowest " << latencies.back() << " ms\n";
+}
+
+//One run on a fresh database, with or without the checkpointer
+static bool runRound(bool checkpointer, int bursts, int salesPerBurst, int pauseMs){
+	if(!buildDatabase()){return false;}
+	sqlite3 *db;
+	if(sqlite3_open_v2(DB_PATH, &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK){
+		std::cerr << "Error opening " << DB_PATH << ": " << sqlite3_errmsg(db) << '\n';
+		sqlite3_close(db);
+		return false;
+	}
+	sqlite3_busy_timeout(db, 5000); //As main does, so a sale waits out a RESTART checkpoint instead of failing
+	OpResult prepared = enableForeignKeys(db);
+	if(prepared.ok()){prepared = prepareStatements(db);}
+	WalCheckpointRequest request;
+	request.path = DB_PATH;
+	if(prepared.ok() && checkpointer){
+		prepared = startWalCheckpointer(request);
+		if(prepared.ok()){prepared = watchWalCommits(db);}
+	}
+	std::vector<double> latencies;
+	if(prepared.ok()){latencies = runSales(db, bursts, salesPerBurst, pauseMs);}
+	else{std::cerr << prepared.error << '\n';}
+	stopWalCheckpointer();
+	finalizeStatements(db);
+	sqlite3_close(db);
+	if(latencies.empty()){return false;}
+
+	printLatencies(checkpointer ? "Checkpointer thread" : "SQLite automatic checkpoints", latencies);
+	if(checkpointer){
+		WalCheckpointMetrics metrics = walCheckpointMetrics();
+		ReportWriter writer(std::cout);
+		writeWalCheckpointReport(metrics, *makeRenderer(ReportFormat::TEXT, writer));
+		writer.flush();
+		if(metrics.peakWalPages > request.restartPages + LOG_SLACK_PAGES){
+			std::cerr << "The log reached " << metrics.peakWalPages << " pages; the checkpointer should keep it within " << request.restartPages + LOG_SLACK_PAGES << '\n';
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]){
+	int bursts = argc > 1 ? std::atoi(argv[1]) : 20;
+	int salesPerBurst = argc > 2 ? std::atoi(argv[2]) : 500;
+	int pauseMs = argc > 3 ? std::atoi(argv[3]) : 300;
+	if(bursts < 1 || salesPerBurst < 1 || pauseMs < 0){
+		std::cerr << "Usage: " << argv[0] << " [bursts] [sales_per_burst] [pause_ms]\n";
+		return 2;
+	}
+	bool ok = runRound(false, bursts, salesPerBurst, pauseMs) && runRound(true, bursts, salesPerBurst, pauseMs);
+	for(const char *suffix : {"-wal", "-shm"}){std::remove((std::string(DB_PATH) + suffix).c_str());}
+	return ok ? 0 : 1;
+}
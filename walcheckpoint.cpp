@@ -0,0 +1,271 @@
+/* Program name: walcheckpoint.cpp
+* Purpose: Implements the WAL checkpointer declared in walcheckpoint.h. Watched connections get a sqlite3_wal_hook in place of the one
+*  sqlite3_wal_autocheckpoint installs; it only stores the commit's time and the log's size in atomics, so a commit costs the register nothing more. The
+*  commit that takes the log to restartPages also wakes the thread, which otherwise reads the atomics every pollMs. The thread runs
+*  sqlite3_wal_checkpoint_v2 on its own connection.
+*/
+
+#include "walcheckpoint.h"
+#include "pokemart_internal.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct WalCheckpointer{
+	WalCheckpointRequest request;
+	sqlite3 *db = NULL;
+	std::string file; //Full path of the database, as sqlite3_db_filename gives it for every connection to it
+	std::thread thread;
+	bool stopping = false; //Guarded by wakeMutex
+	std::chrono::steady_clock::time_point lockWaitStart; //When the checkpoint in progress first found the database locked
+};
+
+static std::mutex checkpointerMutex; //Held while the checkpointer is started, stopped or looked up
+static std::unique_ptr<WalCheckpointer> checkpointer;
+
+//Written by the commit hook on every watched connection, from whichever thread commits
+static std::atomic<sqlite3_int64> commits{0};
+static std::atomic<sqlite3_int64> lastCommitNs{0};
+static std::atomic<int> walPages{0};
+static std::atomic<int> peakWalPages{0};
+static std::atomic<int> escalatePages{std::numeric_limits<int>::max()}; //The running checkpointer's restartPages
+static std::atomic<bool> escalating{false}; //Set by the commit that takes the log to escalatePages, and cleared by the thread when it wakes for it
+static std::atomic<bool> lockWanted{false}; //Set while a checkpoint is waiting for a lock, so every commit tells it the write lock has just come free
+
+//The thread sleeps on wakeSignal between polls, and is woken by the commit hook to escalate or by stopWalCheckpointer. While its checkpoint waits for a
+//lock it sleeps on commitSignal instead
+static std::mutex wakeMutex;
+static std::condition_variable wakeSignal, commitSignal;
+
+//Longest the checkpoint connection waits for a commit before trying for the lock again anyway
+const std::chrono::milliseconds LOCK_RETRY{1};
+
+static std::mutex metricsMutex;
+static WalCheckpointMetrics metrics; //Everything but the commit counters above, written by the checkpoint thread
+
+static sqlite3_int64 nowNs(){
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int onCommit(void *, sqlite3 *, const char *, int pages){
+	commits.fetch_add(1, std::memory_order_relaxed);
+	lastCommitNs.store(nowNs(), std::memory_order_relaxed);
+	walPages.store(pages, std::memory_order_relaxed);
+	int peak = peakWalPages.load(std::memory_order_relaxed);
+	while(pages > peak && !peakWalPages.compare_exchange_weak(peak, pages, std::memory_order_relaxed)){}
+	//A burst can add thousands of pages between two polls, so the commit that reaches restartPages wakes the thread itself, and while the thread's
+	//checkpoint waits for the write lock every commit tells it the lock is free. The hook runs after the lock is released, so yielding the processor here
+	//lets the thread take it before this register's next sale does. The hook only signals; it never waits for the checkpoint
+	bool escalate = pages >= escalatePages.load(std::memory_order_relaxed) && !escalating.exchange(true, std::memory_order_relaxed);
+	bool waiting = lockWanted.load(std::memory_order_relaxed);
+	if(escalate || waiting){
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			if(escalate){wakeSignal.notify_one();}
+			if(waiting){commitSignal.notify_one();}
+		}
+		std::this_thread::yield();
+	}
+	return SQLITE_OK;
+}
+
+//Busy handler of the checkpoint connection. SQLite's own busy timeout sleeps up to 100 ms between tries, but in a burst a register sells back to back and
+//the write lock is only free between two of its sales, so a RESTART that sleeps blindly misses every gap until busyMs runs out while the log keeps
+//growing. Instead it sleeps until the next commit, which is when the lock comes free
+static int retryLock(void *arg, int tries){
+	WalCheckpointer &self = *static_cast<WalCheckpointer *>(arg);
+	auto now = std::chrono::steady_clock::now();
+	if(tries == 0){self.lockWaitStart = now;}
+	if(now - self.lockWaitStart >= std::chrono::milliseconds(self.request.busyMs)){return 0;}
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	lockWanted.store(true, std::memory_order_relaxed);
+	commitSignal.wait_for(lock, LOCK_RETRY);
+	return 1;
+}
+
+//Runs one checkpoint and records it. Returns true if every page of the log is now in the database
+static bool checkpoint(WalCheckpointer &self, int mode){
+	int logPages = 0, checkpointedPages = 0;
+	auto start = std::chrono::steady_clock::now();
+	int rc = sqlite3_wal_checkpoint_v2(self.db, NULL, mode, &logPages, &checkpointedPages);
+	lockWanted.store(false, std::memory_order_relaxed);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::lock_guard<std::mutex> lock(metricsMutex);
+	if(rc != SQLITE_OK){ //SQLITE_BUSY when a sale held on past busyMs; tried again at the next poll
+		metrics.busy++;
+		return false;
+	}
+	if(mode == SQLITE_CHECKPOINT_PASSIVE){metrics.passive++;}
+	else if(mode == SQLITE_CHECKPOINT_RESTART){metrics.restart++;}
+	else{metrics.truncate++;}
+	metrics.lastLogPages = logPages;
+	metrics.lastCheckpointedPages = checkpointedPages;
+	metrics.lastMs = elapsed.count();
+	metrics.maxMs = std::max(metrics.maxMs, metrics.lastMs);
+	metrics.totalMs += metrics.lastMs;
+	return checkpointedPages == logPages;
+}
+
+static void runCheckpoints(WalCheckpointer &self){
+	const WalCheckpointRequest &request = self.request;
+	const std::string walPath = self.file + "-wal";
+	sqlite3_int64 checkpointedCommits = -1; //The commit count when a PASSIVE checkpoint last emptied the log, so an idle log is not checkpointed again
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	for(;;){
+		wakeSignal.wait_for(lock, std::chrono::milliseconds(request.pollMs), [&]{return self.stopping || escalating.load(std::memory_order_relaxed);});
+		if(self.stopping){break;}
+		escalating.store(false, std::memory_order_relaxed); //A checkpoint that gives up is tried again at the next poll or commit past restartPages
+		lock.unlock();
+		int pages = walPages.load(std::memory_order_relaxed);
+		sqlite3_int64 seen = commits.load(std::memory_order_relaxed);
+		bool idle = nowNs() - lastCommitNs.load(std::memory_order_relaxed) >= static_cast<sqlite3_int64>(request.idleMs) * 1000000;
+
+		if(pages >= request.restartPages){
+			//The log is only started over by the next commit, so until then the hook's page count is out of date. Clearing it stops the same log being
+			//restarted again every poll; a commit in the meantime has already replaced it with its own count
+			int mode = pages >= request.truncatePages ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_RESTART;
+			if(checkpoint(self, mode)){walPages.compare_exchange_strong(pages, 0, std::memory_order_relaxed);}
+		}
+		else if(idle && seen != checkpointedCommits && checkpoint(self, SQLITE_CHECKPOINT_PASSIVE)){
+			checkpointedCommits = seen;
+		}
+
+		std::error_code error;
+		sqlite3_int64 walBytes = std::filesystem::file_size(walPath, error);
+		if(!error){
+			std::lock_guard<std::mutex> metricsLock(metricsMutex);
+			metrics.walBytes = walBytes;
+			metrics.peakWalBytes = std::max(metrics.peakWalBytes, walBytes);
+		}
+		lock.lock();
+	}
+}
+
+OpResult startWalCheckpointer(const WalCheckpointRequest &request){
+	OpResult result;
+	stopWalCheckpointer();
+	std::unique_ptr<WalCheckpointer> self = std::make_unique<WalCheckpointer>();
+	self->request = request;
+	int rc = sqlite3_open_v2(request.path.c_str(), &self->db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, NULL);
+	if(rc != SQLITE_OK){
+		fail(result, self->db, NULL, "Error opening " + request.path + " for WAL checkpoints");
+		sqlite3_close(self->db);
+		return result;
+	}
+	sqlite3_busy_timeout(self->db, 5000); //Switching to WAL waits for every other connection to finish what it is doing
+
+	//The journal mode is stored in the database, so this only has to switch it once. The pragma returns the mode it ends up in
+	sqlite3_stmt *res;
+	rc = sqlite3_prepare_v2(self->db, "PRAGMA journal_mode = WAL", -1, &res, NULL);
+	if(rc == SQLITE_OK){rc = sqlite3_step(res);}
+	if(rc != SQLITE_ROW){
+		fail(result, self->db, res, "Error switching " + request.path + " to WAL mode");
+		sqlite3_close(self->db);
+		return result;
+	}
+	const unsigned char *mode = sqlite3_column_text(res, 0);
+	std::string journalMode = mode != NULL ? reinterpret_cast<const char *>(mode) : "";
+	sqlite3_finalize(res);
+	if(journalMode != "wal"){
+		fail(result, request.path + " cannot use WAL mode (it is in " + journalMode + " mode)");
+		sqlite3_close(self->db);
+		return result;
+	}
+	sqlite3_busy_handler(self->db, retryLock, self.get()); //The WalCheckpointer stays where it is when checkpointer takes it over
+	self->file = sqlite3_db_filename(self->db, "main");
+
+	{
+		std::lock_guard<std::mutex> lock(metricsMutex);
+		metrics = WalCheckpointMetrics();
+	}
+	commits = 0;
+	lastCommitNs = nowNs();
+	walPages = 0;
+	peakWalPages = 0;
+	escalating = false;
+	escalatePages = request.restartPages;
+
+	std::lock_guard<std::mutex> lock(checkpointerMutex);
+	checkpointer = std::move(self);
+	checkpointer->thread = std::thread(runCheckpoints, std::ref(*checkpointer));
+	return result;
+}
+
+void stopWalCheckpointer(){
+	std::lock_guard<std::mutex> lock(checkpointerMutex);
+	if(!checkpointer){return;}
+	escalatePages = std::numeric_limits<int>::max();
+	{
+		std::lock_guard<std::mutex> stopLock(wakeMutex);
+		checkpointer->stopping = true;
+	}
+	wakeSignal.notify_one();
+	checkpointer->thread.join();
+	sqlite3_close(checkpointer->db);
+	checkpointer.reset();
+}
+
+OpResult watchWalCommits(sqlite3 *db){
+	OpResult result;
+	std::lock_guard<std::mutex> lock(checkpointerMutex);
+	if(!checkpointer){return result;}
+	const char *file = sqlite3_db_filename(db, "main");
+	if(file == NULL || checkpointer->file != file){return result;} //Another database keeps its own checkpoints
+	sqlite3_wal_hook(db, onCommit, NULL); //Replaces the hook that checkpoints every 1000 pages
+	return result;
+}
+
+WalCheckpointMetrics walCheckpointMetrics(){
+	WalCheckpointMetrics snapshot;
+	{
+		std::lock_guard<std::mutex> lock(metricsMutex);
+		snapshot = metrics;
+	}
+	snapshot.commits = commits.load(std::memory_order_relaxed);
+	snapshot.walPages = walPages.load(std::memory_order_relaxed);
+	snapshot.peakWalPages = peakWalPages.load(std::memory_order_relaxed);
+	return snapshot;
+}
+
+//Report fields
+const ReportField WAL_CHECKPOINT_REPORT = {"WAL Checkpoints", "wal_checkpoints"};
+const ReportField COMMITS = {"Commits", "commits"};
+const ReportField WAL_PAGES = {"Log Pages", "wal_pages"};
+const ReportField PEAK_WAL_PAGES = {"Most Log Pages", "peak_wal_pages"};
+const ReportField WAL_BYTES = {"Log Bytes", "wal_bytes"};
+const ReportField PEAK_WAL_BYTES = {"Most Log Bytes", "peak_wal_bytes"};
+const ReportField PASSIVE = {"Passive", "passive"};
+const ReportField RESTART = {"Restart", "restart"};
+const ReportField TRUNCATE = {"Truncate", "truncate"};
+const ReportField BUSY = {"Busy", "busy"};
+const ReportField LAST_LOG_PAGES = {"Last Checkpoint Log Pages", "last_log_pages"};
+const ReportField LAST_CHECKPOINTED_PAGES = {"Last Checkpoint Pages In Database", "last_checkpointed_pages"};
+const ReportField LAST_MS = {"Last Checkpoint ms", "last_ms"};
+const ReportField MAX_MS = {"Longest Checkpoint ms", "max_ms"};
+const ReportField TOTAL_MS = {"Total Checkpoint ms", "total_ms"};
+
+void writeWalCheckpointReport(const WalCheckpointMetrics &metrics, ReportRenderer &out){
+	out.beginReport(WAL_CHECKPOINT_REPORT);
+	out.field(COMMITS, metrics.commits);
+	out.field(WAL_PAGES, metrics.walPages);
+	out.field(PEAK_WAL_PAGES, metrics.peakWalPages);
+	out.field(WAL_BYTES, metrics.walBytes);
+	out.field(PEAK_WAL_BYTES, metrics.peakWalBytes);
+	out.field(PASSIVE, metrics.passive);
+	out.field(RESTART, metrics.restart);
+	out.field(TRUNCATE, metrics.truncate);
+	out.field(BUSY, metrics.busy);
+	out.field(LAST_LOG_PAGES, metrics.lastLogPages);
+	out.field(LAST_CHECKPOINTED_PAGES, metrics.lastCheckpointedPages);
+	out.decimalField(LAST_MS, metrics.lastMs);
+	out.decimalField(MAX_MS, metrics.maxMs);
+	out.decimalField(TOTAL_MS, metrics.totalMs);
+	out.endReport();
+}
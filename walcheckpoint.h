@@ -0,0 +1,56 @@
+/* Program name: walcheckpoint.h
+* Purpose: Declares the WAL checkpointer. In WAL mode SQLite checkpoints on whichever connection commits once the log passes 1000 pages, so one sale in
+*  every few hundred pays for copying the whole log back into pokemart.db. Once the checkpointer is started, pokemart.db is in WAL mode, and every
+*  connection passed to watchWalCommits stops checkpointing: its commits only record their time and the size of the log. A thread with its own
+*  connection does the checkpoints instead. When no sale has committed for idleMs it runs a PASSIVE checkpoint, which never waits on a register. If the
+*  registers never pause long enough, the commit that takes the log to restartPages wakes the thread without waiting for it, and the thread runs a RESTART
+*  checkpoint, which waits for the sale in progress and lets the next one start the log over. While it waits for the write lock, every commit wakes it as
+*  the lock comes free, so it gets in between two sales of a burst and the log stays near restartPages. From truncatePages, which the log only reaches if a
+*  RESTART gives up, it runs TRUNCATE, which also gives the file's space back.
+*/
+
+#ifndef WALCHECKPOINT_H
+#define WALCHECKPOINT_H
+
+#include <string>
+#include <sqlite3.h>
+#include "pokemart.h"
+#include "output.h"
+
+struct WalCheckpointRequest{
+	std::string path = "pokemart.db";
+	int pollMs = 50; //How often the thread looks at the log
+	int idleMs = 200; //Time since the last commit after which the registers count as idle
+	int restartPages = 4000; //Log size (in pages) at which a RESTART checkpoint is run without waiting for the registers to go idle
+	int truncatePages = 16000; //Log size at which a TRUNCATE checkpoint is run instead
+	int busyMs = 250; //Longest a RESTART or TRUNCATE waits on a sale before giving up until the next poll or commit past restartPages
+};
+
+struct WalCheckpointMetrics{
+	sqlite3_int64 commits = 0; //Commits on watched connections
+	int walPages = 0, peakWalPages = 0; //Pages in the log after the last commit, and the most there have been
+	sqlite3_int64 walBytes = 0, peakWalBytes = 0; //Size of the -wal file when the thread last looked
+	int passive = 0, restart = 0, truncate = 0; //Checkpoints run in each mode
+	int busy = 0; //RESTART and TRUNCATE checkpoints that gave up on a sale, and were tried again
+	int lastLogPages = 0, lastCheckpointedPages = 0; //Pages in the log at the last checkpoint, and how many of them were in the database after it
+	double lastMs = 0, maxMs = 0, totalMs = 0; //Time spent in checkpoints
+};
+
+//Switches the database to WAL mode and starts the checkpoint thread, replacing any already running. Connections only stop checkpointing once passed to
+//watchWalCommits
+OpResult startWalCheckpointer(const WalCheckpointRequest &);
+
+//Stops the thread and closes its connection. Watched connections are left without automatic checkpoints, so stop it after they are done; SQLite still
+//checkpoints the log when the last connection closes
+void stopWalCheckpointer();
+
+//Turns off automatic checkpoints on a connection to the checkpointer's database and reports its commits to the thread. Does nothing if no checkpointer is
+//running, so the connection keeps SQLite's own checkpoints
+OpResult watchWalCommits(sqlite3 *);
+
+//The counters since the checkpointer was started
+WalCheckpointMetrics walCheckpointMetrics();
+
+void writeWalCheckpointReport(const WalCheckpointMetrics &, ReportRenderer &);
+
+#endif